@@ -0,0 +1,95 @@
+# Native Linux build of the demo library and its host-side tools.
+#
+# Dependencies are taken from the system: SDL2, libtmx (which pulls in
+# libxml2 and zlib) and cwalk.
+
+find_package(SDL2 REQUIRED)
+find_package(LibXml2 REQUIRED)
+find_package(ZLIB REQUIRED)
+
+find_path(LIBTMX_INC_DIR tmx.h)
+find_library(LIBTMX_LIB tmx)
+find_path(CWALK_INC_DIR cwalk.h)
+find_library(CWALK_LIB cwalk)
+
+if(NOT LIBTMX_INC_DIR OR NOT LIBTMX_LIB)
+    message(FATAL_ERROR "libtmx not found.")
+endif()
+if(NOT CWALK_INC_DIR OR NOT CWALK_LIB)
+    message(FATAL_ERROR "cwalk not found.")
+endif()
+
+option(DEMO_PROFILE "Build with the frame profiler" OFF)
+
+if(NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE Release)
+endif()
+
+set(SRC_DIR   "${CMAKE_CURRENT_SOURCE_DIR}/src")
+set(TOOLS_DIR "${CMAKE_CURRENT_SOURCE_DIR}/tools")
+
+set(demo_sources
+  "${SRC_DIR}/animation.c"
+  "${SRC_DIR}/arena.c"
+  "${SRC_DIR}/blit.c"
+  "${SRC_DIR}/cache.c"
+  "${SRC_DIR}/chunk.c"
+  "${SRC_DIR}/collision.c"
+  "${SRC_DIR}/core.c"
+  "${SRC_DIR}/input.c"
+  "${SRC_DIR}/job.c"
+  "${SRC_DIR}/map_blob.c"
+  "${SRC_DIR}/object.c"
+  "${SRC_DIR}/path.c"
+  "${SRC_DIR}/profile.c"
+  "${SRC_DIR}/property.c"
+  "${SRC_DIR}/render_list.c"
+  "${SRC_DIR}/stream.c"
+  "${SRC_DIR}/texture_blob.c"
+  "${SRC_DIR}/tile_flag.c"
+  "${SRC_DIR}/tiled.c"
+  "${SRC_DIR}/tileset.c")
+
+add_library(demo STATIC ${demo_sources})
+
+target_compile_options(
+    demo
+    PUBLIC
+    -Wall)
+
+if(DEMO_PROFILE)
+    target_compile_definitions(demo PUBLIC PROFILE_ENABLED)
+endif()
+
+target_include_directories(
+    demo
+    PUBLIC
+    ${SRC_DIR}
+    ${SDL2_INCLUDE_DIRS}
+    ${LIBTMX_INC_DIR}
+    ${CWALK_INC_DIR}
+    ${LIBXML2_INCLUDE_DIR})
+
+target_link_libraries(
+    demo
+    PUBLIC
+    ${SDL2_LIBRARIES}
+    ${LIBTMX_LIB}
+    ${LIBXML2_LIBRARIES}
+    ${ZLIB_LIBRARIES}
+    ${CWALK_LIB})
+
+add_executable(demo_bench "${TOOLS_DIR}/bench.c")
+target_link_libraries(demo_bench demo)
+
+add_executable(demo_mapc "${TOOLS_DIR}/mapc.c")
+target_link_libraries(demo_mapc demo)
+
+add_executable(demo_texconv "${TOOLS_DIR}/texconv.c")
+target_link_libraries(demo_texconv demo)
+
+add_executable(demo_blit_check "${TOOLS_DIR}/blit_check.c")
+target_link_libraries(demo_blit_check demo)
+
+add_executable(demo_property_bench "${TOOLS_DIR}/property_bench.c")
+target_link_libraries(demo_property_bench demo)
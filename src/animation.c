@@ -0,0 +1,756 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <tmx.h>
+#include "animation.h"
+#include "arena.h"
+#include "chunk.h"
+#include "core.h"
+#include "job.h"
+#include "map_blob.h"
+#include "render_list.h"
+#include "tiled.h"
+#include "tileset.h"
+
+typedef struct animated_tile_scan
+{
+    map_t*        map;
+    const Sint32* animation_of_gid;
+
+} animated_tile_scan_t;
+
+// patch_streamed_chunk keeps one bit per cell of a chunk in a Uint64.
+SDL_COMPILE_TIME_ASSERT(chunk_cell_mask, CHUNK_SIZE * CHUNK_SIZE <= 64);
+
+static void     count_animated_tiles(void* data, Sint32 chunk_y);
+static Sint32   get_cell_animation(render_list_t* list, const Sint32* animation_of_gid, Sint32 index_x, Sint32 index_y, Sint32 layer_index);
+static status_t index_animated_tiles(const Sint32* animation_of_gid, Sint32 animated_tile_count, core_t* core);
+static SDL_bool is_animation_sooner(map_t* map, Sint32 queue_a, Sint32 queue_b);
+static status_t load_animations_from_blob(core_t* core);
+static status_t load_animations_from_tiled_map(core_t* core);
+static status_t patch_animated_tile(const animated_tile_t* tile, chunk_cache_t* cache, SDL_Texture** target, core_t* core);
+static status_t patch_animated_tiles(core_t* core);
+static status_t patch_streamed_chunk(chunk_t* chunk, Sint32 chunk_index, chunk_cache_t* cache, core_t* core);
+static status_t patch_streamed_chunks(chunk_cache_t* cache, core_t* core);
+static void     sift_animation_down(map_t* map, Sint32 queue_index);
+static void     sift_animation_up(map_t* map, Sint32 queue_index);
+static void     sort_animated_tiles(void* data, Sint32 chunk_y);
+static void     swap_animations(map_t* map, Sint32 queue_a, Sint32 queue_b);
+
+/* Animated tiles are stored in two parts: one animation state per
+ * animated gid (shared by every cell showing that gid) and the list of
+ * cells showing an animated tile on any layer, sorted by chunk and
+ * indexed by animation, so that a tick only looks at the cells of the
+ * animations that changed.  Frame changes are written to the render
+ * list's per-gid source positions, which every chunk bake and patch
+ * reads from.
+ *
+ * Every frame lasts as long as its Tiled duration.  Animations wait in
+ * a min-heap ordered by the time of their next frame, so a tick only
+ * looks at the animations that are due, and only the cells of those
+ * whose source changed get patched.
+ */
+status_t load_animated_tiles(core_t* core)
+{
+    map_t*               map                 = core->map;
+    render_list_t*       list                = &map->render_list;
+    animated_tile_scan_t scan;
+    Sint32*              animation_of_gid;
+    Sint32               chunk_count         = list->chunk_count_x * list->chunk_count_y;
+    Sint32               animated_tile_count = 0;
+    Sint32               index;
+    status_t             status;
+
+    // [1] One animation per animated gid.
+    if (map->blob.data)
+    {
+        status = load_animations_from_blob(core);
+    }
+    else
+    {
+        status = load_animations_from_tiled_map(core);
+    }
+
+    if (CORE_OK != status || 0 >= map->animation_count)
+    {
+        return status;
+    }
+
+    /* Streamed maps are never resident as a whole: their animated cells
+     * are found in the cell lists of the resident chunks instead, so
+     * only the animation of each gid is kept.
+     */
+    map->animation_queue   = (Sint32*)arena_calloc(map->arena, (size_t)map->animation_count, sizeof(Sint32));
+    map->changed_animation = (Sint32*)arena_calloc(map->arena, (size_t)map->animation_count, sizeof(Sint32));
+    if (! map->animation_queue || ! map->changed_animation)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    if (list->stream)
+    {
+        map->animation_of_gid = (Sint32*)arena_calloc(map->arena, (size_t)list->gid_count, sizeof(Sint32));
+        if (! map->animation_of_gid)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            return CORE_ERROR;
+        }
+        animation_of_gid = map->animation_of_gid;
+    }
+    else
+    {
+        animation_of_gid          = (Sint32*)calloc((size_t)list->gid_count, sizeof(Sint32));
+        map->animated_tile_offset = (Sint32*)arena_calloc(map->arena, (size_t)chunk_count + 1, sizeof(Sint32));
+        if (! animation_of_gid || ! map->animated_tile_offset)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            free(animation_of_gid);
+            return CORE_ERROR;
+        }
+    }
+
+    for (index = 0; index < map->animation_count; index += 1)
+    {
+        animation_t* animation = &map->animation[index];
+
+        animation->current_frame = 0;
+        animation->id            = (Sint32)animation->frame[0].tile_id;
+        animation->next_change   = map->animation_time + SDL_max(animation->frame[0].duration, 1);
+
+        get_tile_source(get_tileset_first_gid(animation->gid, core) + animation->id, &list->src[animation->gid], core);
+        animation_of_gid[animation->gid] = index + 1;
+
+        // Animations of a single frame never change.
+        if (1 < animation->animation_length)
+        {
+            map->animation_queue[map->animation_queue_count] = index;
+            map->animation_queue_count                       += 1;
+            sift_animation_up(map, map->animation_queue_count - 1);
+        }
+    }
+
+    if (list->stream)
+    {
+        dbgprint("Load %d animation(s) of a streamed map.", map->animation_count);
+        return CORE_OK;
+    }
+
+    // [2] Count animated cells per chunk, a row of chunks per job.
+    scan.map              = map;
+    scan.animation_of_gid = animation_of_gid;
+
+    run_jobs(count_animated_tiles, &scan, list->chunk_count_y, 1, core);
+
+    for (index = 0; index < chunk_count; index += 1)
+    {
+        map->animated_tile_offset[index + 1] += map->animated_tile_offset[index];
+    }
+    animated_tile_count = map->animated_tile_offset[chunk_count];
+
+    if (0 < animated_tile_count)
+    {
+        map->animated_tile = (animated_tile_t*)arena_calloc(map->arena, (size_t)animated_tile_count, sizeof(struct animated_tile));
+        if (! map->animated_tile)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            free(animation_of_gid);
+            return CORE_ERROR;
+        }
+    }
+
+    // [3] Sort animated cells into their chunks.
+    run_jobs(sort_animated_tiles, &scan, list->chunk_count_y, 1, core);
+
+    // Filling advanced each offset by one chunk; shift them back.
+    for (index = chunk_count; index > 0; index -= 1)
+    {
+        map->animated_tile_offset[index] = map->animated_tile_offset[index - 1];
+    }
+    map->animated_tile_offset[0] = 0;
+    map->animated_tile_index     = animated_tile_count;
+
+    // [4] Cells of each animation.
+    if (CORE_OK != index_animated_tiles(animation_of_gid, animated_tile_count, core))
+    {
+        free(animation_of_gid);
+        return CORE_ERROR;
+    }
+
+    free(animation_of_gid);
+
+    dbgprint("Load %d animated tile(s), %d animation(s).", animated_tile_count, map->animation_count);
+
+    return CORE_OK;
+}
+
+status_t update_animated_tiles(core_t* core)
+{
+    map_t*         map  = core->map;
+    render_list_t* list = &map->render_list;
+    Sint32         index;
+
+    if (0 >= map->animation_queue_count)
+    {
+        return CORE_OK;
+    }
+
+    // [1] The changes of the last tick have been patched.
+    for (index = 0; index < map->changed_animation_count; index += 1)
+    {
+        map->animation[map->changed_animation[index]].has_changed = SDL_FALSE;
+    }
+    map->changed_animation_count = 0;
+
+    /* [2] Advance the animations that are due, soonest first.  Simulated
+     * time is used, so animations run at the same speed whatever the
+     * frame rate.  An animation advances at most one frame per tick: one
+     * that fell further behind is rescheduled from now instead.
+     */
+    map->animation_time += core->time_since_last_frame;
+
+    while (0 < map->animation_queue_count)
+    {
+        Sint32       animation_index = map->animation_queue[0];
+        animation_t* animation       = &map->animation[animation_index];
+        Uint32       duration;
+        SDL_Point    frame;
+
+        if (0 < (Sint32)(animation->next_change - map->animation_time))
+        {
+            break;
+        }
+
+        animation->current_frame += 1;
+        if (animation->current_frame >= animation->animation_length)
+        {
+            animation->current_frame = 0;
+        }
+
+        animation->id = (Sint32)animation->frame[animation->current_frame].tile_id;
+        duration      = SDL_max(animation->frame[animation->current_frame].duration, 1);
+
+        animation->next_change += duration;
+        if (0 >= (Sint32)(animation->next_change - map->animation_time))
+        {
+            animation->next_change = map->animation_time + duration;
+        }
+        sift_animation_down(map, 0);
+
+        get_tile_source(get_tileset_first_gid(animation->gid, core) + animation->id, &frame, core);
+
+        if (frame.x != list->src[animation->gid].x || frame.y != list->src[animation->gid].y)
+        {
+            list->src[animation->gid] = frame;
+            animation->has_changed    = SDL_TRUE;
+
+            map->changed_animation[map->changed_animation_count] = animation_index;
+            map->changed_animation_count                        += 1;
+        }
+    }
+
+    if (0 == map->changed_animation_count)
+    {
+        return CORE_OK;
+    }
+
+    /* [3] Both levels bake every visible layer, so every resident chunk
+     * of either level showing a changed cell has to be patched.
+     */
+    if (! list->stream)
+    {
+        return patch_animated_tiles(core);
+    }
+
+    for (index = 0; index < MAP_LAYER_MAX; index += 1)
+    {
+        if (CORE_OK != patch_streamed_chunks(&map->chunk_cache[index], core))
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    return CORE_OK;
+}
+
+static status_t load_animations_from_blob(core_t* core)
+{
+    map_t*                      map       = core->map;
+    const map_blob_header_t*    header    = map->blob.header;
+    const map_blob_animation_t* animation = (const map_blob_animation_t*)get_map_blob_section(&map->blob, header->animation_offset);
+    const animation_frame_t*    frame     = (const animation_frame_t*)get_map_blob_section(&map->blob, header->frame_offset);
+    Uint32                      index;
+    Uint32                      frame_index;
+    Uint32                      first_gid;
+
+    if (0 == header->animation_count)
+    {
+        return CORE_OK;
+    }
+
+    map->animation = (animation_t*)arena_calloc(map->arena, (size_t)header->animation_count, sizeof(struct animation));
+    if (! map->animation)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+    map->animation_count = (Sint32)header->animation_count;
+
+    // Frames are used in place.
+    for (index = 0; index < header->animation_count; index += 1)
+    {
+        if (animation[index].gid >= header->gid_count || 0 == animation[index].frame_count ||
+            animation[index].first_frame + animation[index].frame_count > header->frame_count)
+        {
+            dbgprint("%s: corrupt animation table.", FUNCTION_NAME);
+            return CORE_ERROR;
+        }
+
+        // Frames refer to tiles of the tileset of the animated tile.
+        first_gid = (Uint32)get_tileset_first_gid((Sint32)animation[index].gid, core);
+
+        for (frame_index = 0; frame_index < animation[index].frame_count; frame_index += 1)
+        {
+            if (first_gid + frame[animation[index].first_frame + frame_index].tile_id >= header->gid_count)
+            {
+                dbgprint("%s: corrupt animation table.", FUNCTION_NAME);
+                return CORE_ERROR;
+            }
+        }
+
+        map->animation[index].gid              = (Sint32)animation[index].gid;
+        map->animation[index].frame            = &frame[animation[index].first_frame];
+        map->animation[index].animation_length = (Sint32)animation[index].frame_count;
+    }
+
+    return CORE_OK;
+}
+
+static status_t load_animations_from_tiled_map(core_t* core)
+{
+    map_t*   map         = core->map;
+    tmx_map* handle      = map->handle;
+    Sint32   frame_count = 0;
+    Sint32   gid;
+    Sint32   index;
+    Sint32   frame_index;
+
+    for (gid = 0; gid < map->render_list.gid_count; gid += 1)
+    {
+        Sint32 animation_length = 0;
+
+        if (is_tile_animated(gid, &animation_length, NULL, handle))
+        {
+            map->animation_count += 1;
+            frame_count          += animation_length;
+        }
+    }
+
+    if (0 >= map->animation_count)
+    {
+        return CORE_OK;
+    }
+
+    map->animation       = (animation_t*)arena_calloc(map->arena, (size_t)map->animation_count, sizeof(struct animation));
+    map->animation_frame = (animation_frame_t*)arena_calloc(map->arena, (size_t)frame_count, sizeof(struct animation_frame));
+    if (! map->animation || ! map->animation_frame)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    index       = 0;
+    frame_index = 0;
+    for (gid = 0; gid < map->render_list.gid_count; gid += 1)
+    {
+        Sint32 animation_length = 0;
+        Sint32 frame;
+
+        if (! is_tile_animated(gid, &animation_length, NULL, handle))
+        {
+            continue;
+        }
+
+        map->animation[index].gid              = gid;
+        map->animation[index].frame            = &map->animation_frame[frame_index];
+        map->animation[index].animation_length = animation_length;
+
+        for (frame = 0; frame < animation_length; frame += 1)
+        {
+            map->animation_frame[frame_index].tile_id  = handle->tiles[gid]->animation[frame].tile_id;
+            map->animation_frame[frame_index].duration = handle->tiles[gid]->animation[frame].duration;
+            frame_index += 1;
+        }
+        index += 1;
+    }
+
+    return CORE_OK;
+}
+
+/* Redraw the cells of the animations changed by this tick in every
+ * resident chunk, each cell once even if several of its layers
+ * changed.  Chunks that are not resident or not baked yet pick up the
+ * current frame when they get baked or drawn, so there is nothing to
+ * do for them.
+ */
+static status_t patch_animated_tiles(core_t* core)
+{
+    map_t*       map    = core->map;
+    SDL_Texture* target = NULL;
+    Sint32       index;
+    Sint32       tile_index;
+    Sint32       layer_index;
+
+    map->animation_tick += 1;
+
+    for (index = 0; index < map->changed_animation_count; index += 1)
+    {
+        Sint32 animation = map->changed_animation[index];
+
+        for (tile_index = map->animation_tile_offset[animation]; tile_index < map->animation_tile_offset[animation + 1]; tile_index += 1)
+        {
+            animated_tile_t* tile = &map->animated_tile[map->animation_tile[tile_index]];
+
+            if (tile->patch_tick == map->animation_tick)
+            {
+                continue;
+            }
+            tile->patch_tick = map->animation_tick;
+
+            for (layer_index = 0; layer_index < MAP_LAYER_MAX; layer_index += 1)
+            {
+                if (CORE_OK != patch_animated_tile(tile, &map->chunk_cache[layer_index], &target, core))
+                {
+                    return CORE_ERROR;
+                }
+            }
+        }
+    }
+
+    return CORE_OK;
+}
+
+// Redraw an animated cell in the chunk of a cache holding it, if resident and baked.
+static status_t patch_animated_tile(const animated_tile_t* tile, chunk_cache_t* cache, SDL_Texture** target, core_t* core)
+{
+    Sint32   chunk_x = tile->index_x / CHUNK_SIZE;
+    Sint32   chunk_y = tile->index_y / CHUNK_SIZE;
+    chunk_t* chunk;
+
+    if (! cache->chunk)
+    {
+        return CORE_OK;
+    }
+
+    chunk = &cache->chunk[((chunk_y % cache->ring_height) * cache->ring_width) + (chunk_x % cache->ring_width)];
+    if (chunk->index_x != chunk_x || chunk->index_y != chunk_y || ! chunk->is_baked)
+    {
+        return CORE_OK;
+    }
+
+    if (! chunk->pixels && *target != chunk->texture)
+    {
+        if (0 > set_render_target(chunk->texture, core))
+        {
+            dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+            return CORE_ERROR;
+        }
+        *target = chunk->texture;
+    }
+
+    redraw_chunk_tile(chunk, tile->index_x, tile->index_y, core);
+    request_redraw(RENDER_CHANGE_ANIMATION, core);
+
+    return CORE_OK;
+}
+
+// Streamed maps have no list of animated cells: walk the cells of every resident chunk.
+static status_t patch_streamed_chunks(chunk_cache_t* cache, core_t* core)
+{
+    Sint32 index;
+
+    if (! cache->chunk)
+    {
+        return CORE_OK;
+    }
+
+    for (index = 0; index < cache->ring_width * cache->ring_height; index += 1)
+    {
+        chunk_t* chunk = &cache->chunk[index];
+
+        if (0 > chunk->index_x || ! chunk->is_baked)
+        {
+            continue;
+        }
+
+        if (CORE_OK != patch_streamed_chunk(chunk, (chunk->index_y * cache->chunk_count_x) + chunk->index_x, cache, core))
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    return CORE_OK;
+}
+
+/* Streamed chunks have no list of animated cells: walk their cells.
+ * Chunks out of view are not patched, as reading their cells could
+ * evict pages the view needs; they are baked again once visible.
+ */
+static status_t patch_streamed_chunk(chunk_t* chunk, Sint32 chunk_index, chunk_cache_t* cache, core_t* core)
+{
+    map_t*         map           = core->map;
+    SDL_bool       is_target_set = SDL_FALSE;
+    Uint64         patched_mask  = 0; // One bit per cell of the chunk.
+    render_cell_t* cells;
+    SDL_Rect       range;
+    Sint32         cell_count;
+    Sint32         index;
+
+    get_visible_chunks(cache, &range, core);
+
+    if (chunk->index_x < range.x || chunk->index_y < range.y || chunk->index_x >= range.x + range.w || chunk->index_y >= range.y + range.h)
+    {
+        chunk->is_baked = SDL_FALSE;
+        return CORE_OK;
+    }
+
+    cells = get_render_list_cells(&map->render_list, chunk_index, &cell_count);
+
+    for (index = 0; index < cell_count; index += 1)
+    {
+        Sint32 animation = map->animation_of_gid[cells[index].gid];
+        Uint64 cell_bit  = (Uint64)1 << ((cells[index].pos_y * CHUNK_SIZE) + cells[index].pos_x);
+
+        // Cells are listed once per layer, but redrawn with all their layers.
+        if (! animation || ! map->animation[animation - 1].has_changed || (patched_mask & cell_bit))
+        {
+            continue;
+        }
+        patched_mask |= cell_bit;
+
+        if (! is_target_set && ! chunk->pixels)
+        {
+            if (0 > set_render_target(chunk->texture, core))
+            {
+                dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+                return CORE_ERROR;
+            }
+            is_target_set = SDL_TRUE;
+        }
+
+        redraw_chunk_tile(chunk, (chunk->index_x * CHUNK_SIZE) + cells[index].pos_x, (chunk->index_y * CHUNK_SIZE) + cells[index].pos_y, core);
+        request_redraw(RENDER_CHANGE_ANIMATION, core);
+    }
+
+    return CORE_OK;
+}
+
+// Count the animated cells of each chunk of a row of chunks.
+static void count_animated_tiles(void* data, Sint32 chunk_y)
+{
+    animated_tile_scan_t* scan   = (animated_tile_scan_t*)data;
+    map_t*                map    = scan->map;
+    render_list_t*        list   = &map->render_list;
+    Sint32                last_y = SDL_min((chunk_y + 1) * CHUNK_SIZE, list->height);
+    Sint32                layer_index;
+    Sint32                index_height;
+    Sint32                index_width;
+
+    for (index_height = chunk_y * CHUNK_SIZE; index_height < last_y; index_height += 1)
+    {
+        for (index_width = 0; index_width < list->width; index_width += 1)
+        {
+            for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+            {
+                if (scan->animation_of_gid[get_render_list_gid(list, layer_index, index_width, index_height)])
+                {
+                    map->animated_tile_offset[(chunk_y * list->chunk_count_x) + (index_width / CHUNK_SIZE) + 1] += 1;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/* Animation + 1 shown by a layer of a cell, or 0 if there is none or a
+ * lower layer of the cell shows the same animation.
+ */
+static Sint32 get_cell_animation(render_list_t* list, const Sint32* animation_of_gid, Sint32 index_x, Sint32 index_y, Sint32 layer_index)
+{
+    Sint32 animation = animation_of_gid[get_render_list_gid(list, layer_index, index_x, index_y)];
+    Sint32 index;
+
+    for (index = 0; animation && index < layer_index; index += 1)
+    {
+        if (animation == animation_of_gid[get_render_list_gid(list, index, index_x, index_y)])
+        {
+            return 0;
+        }
+    }
+
+    return animation;
+}
+
+/* List the animated cells of each animation, each cell once, in chunk
+ * order.
+ */
+static status_t index_animated_tiles(const Sint32* animation_of_gid, Sint32 animated_tile_count, core_t* core)
+{
+    map_t*         map        = core->map;
+    render_list_t* list       = &map->render_list;
+    Sint32         tile_count;
+    Sint32         tile_index;
+    Sint32         layer_index;
+    Sint32         index;
+
+    map->animation_tile_offset = (Sint32*)arena_calloc(map->arena, (size_t)map->animation_count + 1, sizeof(Sint32));
+    if (! map->animation_tile_offset)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    // [1] Count the cells of each animation.
+    for (tile_index = 0; tile_index < animated_tile_count; tile_index += 1)
+    {
+        const animated_tile_t* tile = &map->animated_tile[tile_index];
+
+        for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+        {
+            Sint32 animation = get_cell_animation(list, animation_of_gid, tile->index_x, tile->index_y, layer_index);
+
+            if (animation)
+            {
+                map->animation_tile_offset[animation] += 1;
+            }
+        }
+    }
+
+    for (index = 0; index < map->animation_count; index += 1)
+    {
+        map->animation_tile_offset[index + 1] += map->animation_tile_offset[index];
+    }
+    tile_count = map->animation_tile_offset[map->animation_count];
+
+    if (0 >= tile_count)
+    {
+        return CORE_OK;
+    }
+
+    map->animation_tile = (Sint32*)arena_calloc(map->arena, (size_t)tile_count, sizeof(Sint32));
+    if (! map->animation_tile)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    // [2] Sort them by animation.
+    for (tile_index = 0; tile_index < animated_tile_count; tile_index += 1)
+    {
+        const animated_tile_t* tile = &map->animated_tile[tile_index];
+
+        for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+        {
+            Sint32 animation = get_cell_animation(list, animation_of_gid, tile->index_x, tile->index_y, layer_index);
+
+            if (animation)
+            {
+                map->animation_tile[map->animation_tile_offset[animation - 1]] = tile_index;
+                map->animation_tile_offset[animation - 1]                     += 1;
+            }
+        }
+    }
+
+    // Filling advanced each offset by one animation; shift them back.
+    for (index = map->animation_count; index > 0; index -= 1)
+    {
+        map->animation_tile_offset[index] = map->animation_tile_offset[index - 1];
+    }
+    map->animation_tile_offset[0] = 0;
+
+    return CORE_OK;
+}
+
+// Due times wrap around after 49 days of simulated time.
+static SDL_bool is_animation_sooner(map_t* map, Sint32 queue_a, Sint32 queue_b)
+{
+    Uint32 change_a = map->animation[map->animation_queue[queue_a]].next_change;
+    Uint32 change_b = map->animation[map->animation_queue[queue_b]].next_change;
+
+    return 0 > (Sint32)(change_a - change_b) ? SDL_TRUE : SDL_FALSE;
+}
+
+static void sift_animation_down(map_t* map, Sint32 queue_index)
+{
+    for (;;)
+    {
+        Sint32 child  = (queue_index * 2) + 1;
+        Sint32 sooner = queue_index;
+
+        if (child < map->animation_queue_count && is_animation_sooner(map, child, sooner))
+        {
+            sooner = child;
+        }
+        if (child + 1 < map->animation_queue_count && is_animation_sooner(map, child + 1, sooner))
+        {
+            sooner = child + 1;
+        }
+        if (sooner == queue_index)
+        {
+            return;
+        }
+
+        swap_animations(map, queue_index, sooner);
+        queue_index = sooner;
+    }
+}
+
+static void sift_animation_up(map_t* map, Sint32 queue_index)
+{
+    while (0 < queue_index && is_animation_sooner(map, queue_index, (queue_index - 1) / 2))
+    {
+        swap_animations(map, queue_index, (queue_index - 1) / 2);
+        queue_index = (queue_index - 1) / 2;
+    }
+}
+
+// Sort the animated cells of a row of chunks into their chunks.
+static void sort_animated_tiles(void* data, Sint32 chunk_y)
+{
+    animated_tile_scan_t* scan   = (animated_tile_scan_t*)data;
+    map_t*                map    = scan->map;
+    render_list_t*        list   = &map->render_list;
+    Sint32                last_y = SDL_min((chunk_y + 1) * CHUNK_SIZE, list->height);
+    Sint32                layer_index;
+    Sint32                index_height;
+    Sint32                index_width;
+
+    for (index_height = chunk_y * CHUNK_SIZE; index_height < last_y; index_height += 1)
+    {
+        for (index_width = 0; index_width < list->width; index_width += 1)
+        {
+            for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+            {
+                if (scan->animation_of_gid[get_render_list_gid(list, layer_index, index_width, index_height)])
+                {
+                    Sint32           chunk = (chunk_y * list->chunk_count_x) + (index_width / CHUNK_SIZE);
+                    animated_tile_t* tile  = &map->animated_tile[map->animated_tile_offset[chunk]];
+
+                    map->animated_tile_offset[chunk] += 1;
+
+                    tile->index_x = index_width;
+                    tile->index_y = index_height;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void swap_animations(map_t* map, Sint32 queue_a, Sint32 queue_b)
+{
+    Sint32 animation = map->animation_queue[queue_a];
+
+    map->animation_queue[queue_a] = map->animation_queue[queue_b];
+    map->animation_queue[queue_b] = animation;
+}
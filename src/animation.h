@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <SDL.h>
+#include "core.h"
+
+status_t load_animated_tiles(core_t* core);
+status_t update_animated_tiles(core_t* core);
+
+#endif /* ANIMATION_H */
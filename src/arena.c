@@ -0,0 +1,351 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <tmx.h>
+#include <libxml/parser.h>
+#include "arena.h"
+#include "core.h"
+
+#define ARENA_ALIGN        8
+#define ARENA_ROUND(size)  (((size) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_HEADER_SIZE  ARENA_ROUND(sizeof(size_t))
+#define ARENA_BLOCK_HEADER ARENA_ROUND(sizeof(struct arena_block))
+
+static SDL_TLSID tmx_arena = 0;
+
+static void*          allocate(arena_t* arena, size_t size);
+static arena_block_t* add_block(arena_block_t** list, size_t size, arena_t* arena);
+static arena_block_t* find_block(const void* address, arena_t* arena);
+static Uint8*         get_block_data(arena_block_t* block);
+static size_t         get_allocation_size(const void* address);
+static SDL_bool       is_last_allocation(const void* address, size_t size, arena_block_t* block);
+static void*          alloc_tmx_memory(void* address, size_t length);
+static void           free_tmx_memory(void* address);
+
+/* The arena is allocated from its own first block, which is freed
+ * last.
+ */
+arena_t* create_arena(void)
+{
+    arena_t  bootstrap;
+    arena_t* arena;
+
+    SDL_zero(bootstrap);
+    bootstrap.block_size = ARENA_BLOCK_SIZE;
+
+    arena = (arena_t*)allocate(&bootstrap, sizeof(struct arena));
+    if (! arena)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return NULL;
+    }
+    *arena = bootstrap;
+
+    return arena;
+}
+
+void free_arena(arena_t* arena)
+{
+    arena_block_t* block;
+    arena_block_t* large;
+    arena_block_t* next;
+
+    if (! arena)
+    {
+        return;
+    }
+
+    block = arena->block;
+    large = arena->large;
+
+    for (; large; large = next)
+    {
+        next = large->next;
+        free(large);
+    }
+    for (; block; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+}
+
+void* arena_calloc(arena_t* arena, size_t count, size_t size)
+{
+    void* address;
+
+    if (0 != size && count > (size_t)-1 / size)
+    {
+        return NULL;
+    }
+
+    address = allocate(arena, count * size);
+    if (address)
+    {
+        SDL_memset(address, 0, count * size);
+    }
+
+    return address;
+}
+
+/* The most recent allocation of the current block grows and shrinks
+ * in place; anything else is moved.
+ */
+void* arena_realloc(arena_t* arena, void* address, size_t size)
+{
+    arena_block_t* block = arena->block;
+    void*          moved;
+    size_t         previous_size;
+
+    if (! address)
+    {
+        return allocate(arena, size);
+    }
+
+    previous_size = get_allocation_size(address);
+
+    if (size < ARENA_LARGE_SIZE && is_last_allocation(address, previous_size, block) &&
+        (Uint8*)address + ARENA_ROUND(size) <= get_block_data(block) + block->size)
+    {
+        *(size_t*)((Uint8*)address - ARENA_HEADER_SIZE) = size;
+
+        block->used            = (size_t)((Uint8*)address - get_block_data(block)) + ARENA_ROUND(size);
+        arena->byte_count      = arena->byte_count - previous_size + size;
+        arena->peak_byte_count = SDL_max(arena->peak_byte_count, arena->byte_count);
+        return address;
+    }
+
+    moved = allocate(arena, size);
+    if (! moved)
+    {
+        return NULL;
+    }
+    SDL_memcpy(moved, address, SDL_min(previous_size, size));
+    arena_free(arena, address);
+
+    return moved;
+}
+
+/* Large allocations give their block back.  Otherwise only the most
+ * recent allocation of the current block is reclaimed; the rest stays
+ * until the arena is freed.
+ */
+void arena_free(arena_t* arena, void* address)
+{
+    arena_block_t** link;
+    size_t          size;
+
+    if (! address)
+    {
+        return;
+    }
+
+    size               = get_allocation_size(address);
+    arena->byte_count -= size;
+
+    for (link = &arena->large; *link; link = &(*link)->next)
+    {
+        if (get_block_data(*link) + ARENA_HEADER_SIZE == (Uint8*)address)
+        {
+            arena_block_t* block = *link;
+
+            *link                       = block->next;
+            arena->reserved_byte_count -= ARENA_BLOCK_HEADER + block->size;
+            arena->block_count         -= 1;
+            free(block);
+            return;
+        }
+    }
+
+    if (is_last_allocation(address, size, arena->block))
+    {
+        arena->block->used -= ARENA_HEADER_SIZE + ARENA_ROUND(size);
+    }
+}
+
+char* arena_strdup(arena_t* arena, const char* string)
+{
+    size_t length = SDL_strlen(string) + 1;
+    char*  copy   = (char*)allocate(arena, length);
+
+    if (copy)
+    {
+        SDL_memcpy(copy, string, length);
+    }
+
+    return copy;
+}
+
+void get_arena_stats(arena_stats_t* stats, arena_t* arena)
+{
+    SDL_zerop(stats);
+    if (! arena)
+    {
+        return;
+    }
+
+    stats->byte_count          = arena->byte_count;
+    stats->peak_byte_count     = arena->peak_byte_count;
+    stats->reserved_byte_count = arena->reserved_byte_count;
+    stats->block_count         = arena->block_count;
+}
+
+/* Route libtmx, and with it libxml2, through the arena hooks.  Has to
+ * be called on the main thread before any map is parsed.
+ */
+status_t init_tmx_allocator(void)
+{
+    if (tmx_arena)
+    {
+        return CORE_OK;
+    }
+
+    // libxml2 sets up its global state on first use; keep it out of the map arenas.
+    xmlInitParser();
+
+    tmx_arena = SDL_TLSCreate();
+    if (! tmx_arena)
+    {
+        dbgprint("Could not create thread-local storage: %s", SDL_GetError());
+        return CORE_ERROR;
+    }
+
+    tmx_alloc_func = alloc_tmx_memory;
+    tmx_free_func  = free_tmx_memory;
+
+    return CORE_OK;
+}
+
+/* Select the arena libtmx allocates from on the calling thread, or
+ * NULL for the heap.  Returns whether allocations now go to the arena.
+ */
+SDL_bool set_tmx_arena(arena_t* arena)
+{
+    if (! tmx_arena || 0 != SDL_TLSSet(tmx_arena, arena, NULL))
+    {
+        return SDL_FALSE;
+    }
+
+    return arena ? SDL_TRUE : SDL_FALSE;
+}
+
+static void* allocate(arena_t* arena, size_t size)
+{
+    size_t         total = ARENA_HEADER_SIZE + ARENA_ROUND(size);
+    arena_block_t* block = arena->block;
+    Uint8*         data;
+
+    if (size >= ARENA_LARGE_SIZE)
+    {
+        block = add_block(&arena->large, total, arena);
+    }
+    else if (! block || block->used + total > block->size)
+    {
+        block = add_block(&arena->block, arena->block_size, arena);
+        if (arena->block_size < ARENA_MAX_BLOCK_SIZE)
+        {
+            arena->block_size *= 2;
+        }
+    }
+
+    if (! block)
+    {
+        return NULL;
+    }
+
+    data                   = get_block_data(block) + block->used;
+    *(size_t*)data         = size;
+    block->used           += total;
+    arena->byte_count     += size;
+    arena->peak_byte_count = SDL_max(arena->peak_byte_count, arena->byte_count);
+
+    return data + ARENA_HEADER_SIZE;
+}
+
+static arena_block_t* add_block(arena_block_t** list, size_t size, arena_t* arena)
+{
+    arena_block_t* block = (arena_block_t*)malloc(ARENA_BLOCK_HEADER + size);
+
+    if (! block)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return NULL;
+    }
+
+    block->next                 = *list;
+    block->size                 = size;
+    block->used                 = 0;
+    *list                       = block;
+    arena->reserved_byte_count += ARENA_BLOCK_HEADER + size;
+    arena->block_count         += 1;
+
+    return block;
+}
+
+static arena_block_t* find_block(const void* address, arena_t* arena)
+{
+    arena_block_t* block;
+
+    for (block = arena->large; block; block = block->next)
+    {
+        if ((const Uint8*)address >= get_block_data(block) && (const Uint8*)address < get_block_data(block) + block->used)
+        {
+            return block;
+        }
+    }
+    for (block = arena->block; block; block = block->next)
+    {
+        if ((const Uint8*)address >= get_block_data(block) && (const Uint8*)address < get_block_data(block) + block->used)
+        {
+            return block;
+        }
+    }
+
+    return NULL;
+}
+
+static Uint8* get_block_data(arena_block_t* block)
+{
+    return (Uint8*)block + ARENA_BLOCK_HEADER;
+}
+
+static size_t get_allocation_size(const void* address)
+{
+    return *(const size_t*)((const Uint8*)address - ARENA_HEADER_SIZE);
+}
+
+static SDL_bool is_last_allocation(const void* address, size_t size, arena_block_t* block)
+{
+    if (block && (const Uint8*)address + ARENA_ROUND(size) == get_block_data(block) + block->used)
+    {
+        return SDL_TRUE;
+    }
+
+    return SDL_FALSE;
+}
+
+// tmx_alloc_func: realloc semantics, from the arena of the thread if any.
+static void* alloc_tmx_memory(void* address, size_t length)
+{
+    arena_t* arena = (arena_t*)SDL_TLSGet(tmx_arena);
+
+    if (arena && (! address || find_block(address, arena)))
+    {
+        return arena_realloc(arena, address, length);
+    }
+
+    return realloc(address, length);
+}
+
+static void free_tmx_memory(void* address)
+{
+    arena_t* arena = (arena_t*)SDL_TLSGet(tmx_arena);
+
+    if (arena && address && find_block(address, arena))
+    {
+        arena_free(arena, address);
+        return;
+    }
+
+    free(address);
+}
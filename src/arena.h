@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Map arena.
+ *
+ * Everything a map allocates for its lifetime, the map itself
+ * included, comes from its arena: a short list of blocks, each filled
+ * front to back.  Blocks start at ARENA_BLOCK_SIZE and double up to
+ * ARENA_MAX_BLOCK_SIZE; allocations of ARENA_LARGE_SIZE and more get a
+ * block of their own, which is given back to the system as soon as
+ * the allocation is freed.  Otherwise, freeing only reclaims the most
+ * recent allocation of a block, and everything else goes at once with
+ * free_arena.  That keeps the small heap of the device from
+ * fragmenting and makes unloading a map a matter of a few frees.
+ *
+ * While a TMX map is parsed, libtmx and libxml2 allocate from the arena
+ * of the map too, through tmx_alloc_func and tmx_free_func, see
+ * set_tmx_arena.  The arena is selected per thread, so the map loader
+ * thread can parse into its own arena.  libxml2's global state is set
+ * up once beforehand by init_tmx_allocator so that none of it ends up
+ * in an arena.  A map parsed this way must not be handed to
+ * tmx_map_free.
+ *
+ * Temporary buffers which are freed before a load returns stay on the
+ * heap, as do tileset resources (shared between maps, see cache.h) and
+ * chunk pixels (dropped when a map is cached, see reset_chunk_cache).
+ */
+
+#define ARENA_BLOCK_SIZE     (16 * 1024)
+#define ARENA_MAX_BLOCK_SIZE (256 * 1024)
+#define ARENA_LARGE_SIZE     (8 * 1024)
+
+typedef struct arena_stats
+{
+    size_t byte_count;
+    size_t peak_byte_count;
+    size_t reserved_byte_count;
+    Sint32 block_count;
+
+} arena_stats_t;
+
+arena_t* create_arena(void);
+void     free_arena(arena_t* arena);
+void*    arena_calloc(arena_t* arena, size_t count, size_t size);
+void*    arena_realloc(arena_t* arena, void* address, size_t size);
+void     arena_free(arena_t* arena, void* address);
+char*    arena_strdup(arena_t* arena, const char* string);
+void     get_arena_stats(arena_stats_t* stats, arena_t* arena);
+status_t init_tmx_allocator(void);
+SDL_bool set_tmx_arena(arena_t* arena);
+
+#endif /* ARENA_H */
@@ -0,0 +1,340 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include "arena.h"
+#include "blit.h"
+#include "core.h"
+#include "tile_flag.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define BLIT_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define BLIT_NEON
+#endif
+
+static void blit_row_opaque(Uint16* dst, const Uint16* src, Sint32 width);
+static void blit_row_keyed(Uint16* dst, const Uint16* src, Sint32 width);
+
+/* Convert a tileset image, before it is packed or turned into a
+ * texture.  Color-keyed pixels have already been made transparent by
+ * SDL when converting to ARGB4444.  Images with semi-transparent
+ * pixels are left without pixels.
+ */
+status_t load_blit_source(SDL_Surface* surface, Uint16** pixels)
+{
+    SDL_Surface* image = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB4444, 0);
+    Sint32       pos_x;
+    Sint32       pos_y;
+
+    *pixels = NULL;
+
+    if (! image)
+    {
+        dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+        return CORE_ERROR;
+    }
+
+    *pixels = (Uint16*)calloc((size_t)(image->w * image->h), sizeof(Uint16));
+    if (! *pixels)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        SDL_FreeSurface(image);
+        return CORE_ERROR;
+    }
+
+    SDL_LockSurface(image);
+    for (pos_y = 0; pos_y < image->h; pos_y += 1)
+    {
+        const Uint16* row = (const Uint16*)((const Uint8*)image->pixels + (pos_y * image->pitch));
+
+        for (pos_x = 0; pos_x < image->w; pos_x += 1)
+        {
+            Uint16 pixel = row[pos_x];
+
+            switch (pixel >> 12)
+            {
+                case 0x0:
+                    pixel = 0;
+                    break;
+                case 0xf:
+                    break;
+                default:
+                    SDL_UnlockSurface(image);
+                    SDL_FreeSurface(image);
+                    free(*pixels);
+                    *pixels = NULL;
+                    return CORE_OK;
+            }
+
+            (*pixels)[(pos_y * image->w) + pos_x] = pixel;
+        }
+    }
+    SDL_UnlockSurface(image);
+    SDL_FreeSurface(image);
+
+    return CORE_OK;
+}
+
+/* Take the pixels of a surface which is in the blitter's format
+ * already, such as a compiled texture, without converting them.
+ */
+status_t copy_blit_source(SDL_Surface* surface, Uint16** pixels)
+{
+    Sint32 pos_y;
+
+    *pixels = (Uint16*)malloc((size_t)(surface->w * surface->h) * sizeof(Uint16));
+    if (! *pixels)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    SDL_LockSurface(surface);
+    for (pos_y = 0; pos_y < surface->h; pos_y += 1)
+    {
+        SDL_memcpy(&(*pixels)[pos_y * surface->w], (const Uint8*)surface->pixels + (pos_y * surface->pitch), (size_t)surface->w * sizeof(Uint16));
+    }
+    SDL_UnlockSurface(surface);
+
+    return CORE_OK;
+}
+
+/* Look up the pixels of every tileset in its resource, then tag every
+ * gid whose tile has no transparent pixels.  Animated gids show other
+ * tiles over time and always take the color-keyed path.
+ */
+status_t init_tile_blitter(core_t* core)
+{
+    map_t*          map     = core->map;
+    render_list_t*  list    = &map->render_list;
+    tile_blitter_t* blitter = &map->blitter;
+    Sint32          index;
+    Sint32          gid;
+
+    if (! core->is_tile_blitter_enabled)
+    {
+        return CORE_OK;
+    }
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        resource_t* resource = map->tileset[index].resource;
+
+        if (! resource || ! resource->pixels[map->tileset[index].image])
+        {
+            dbgprint("Tileset %d cannot be blitted: tile blitter disabled.", index);
+            return CORE_OK;
+        }
+    }
+
+    blitter->pixels = (Uint16**)arena_calloc(map->arena, (size_t)map->tileset_count, sizeof(Uint16*));
+    blitter->size   = (SDL_Point*)arena_calloc(map->arena, (size_t)map->tileset_count, sizeof(SDL_Point));
+    if (! blitter->pixels || ! blitter->size)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+    blitter->tileset_count = map->tileset_count;
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        resource_t* resource = map->tileset[index].resource;
+
+        blitter->pixels[index] = resource->pixels[map->tileset[index].image];
+        blitter->size[index]   = resource->size[map->tileset[index].image];
+    }
+
+    blitter->is_opaque = (Uint8*)arena_calloc(map->arena, (size_t)list->gid_count, sizeof(Uint8));
+    if (! blitter->is_opaque)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    for (gid = 1; gid < list->gid_count; gid += 1)
+    {
+        Sint32        tileset   = list->gid_tileset[gid];
+        const Uint16* pixels    = blitter->pixels[tileset];
+        Sint32        pos_x     = list->position[gid].x;
+        Sint32        pos_y     = list->position[gid].y;
+        Sint32        index_x;
+        Sint32        index_y;
+        Uint8         is_opaque = 1;
+
+        if (get_tile_flags(gid, core) & TILE_FLAG_ANIMATED)
+        {
+            continue;
+        }
+        if (pos_x + list->tile_width > blitter->size[tileset].x || pos_y + list->tile_height > blitter->size[tileset].y)
+        {
+            continue;
+        }
+
+        for (index_y = pos_y; index_y < pos_y + list->tile_height && is_opaque; index_y += 1)
+        {
+            for (index_x = pos_x; index_x < pos_x + list->tile_width; index_x += 1)
+            {
+                if (! (BLIT_ALPHA & pixels[(index_y * blitter->size[tileset].x) + index_x]))
+                {
+                    is_opaque = 0;
+                    break;
+                }
+            }
+        }
+
+        blitter->is_opaque[gid] = is_opaque;
+    }
+
+    blitter->is_ready = SDL_TRUE;
+
+    return CORE_OK;
+}
+
+SDL_bool is_tile_blitter_ready(core_t* core)
+{
+    return core->map->blitter.is_ready;
+}
+
+// The current render draw color, as SDL_RenderClear would write it.
+Uint16 get_blit_clear_color(core_t* core)
+{
+    Uint8 red   = 0;
+    Uint8 green = 0;
+    Uint8 blue  = 0;
+    Uint8 alpha = 0;
+
+    SDL_GetRenderDrawColor(core->renderer, &red, &green, &blue, &alpha);
+
+    return (Uint16)(((red >> 4) << 8) | ((green >> 4) << 4) | (blue >> 4));
+}
+
+void fill_blit_rect(Uint16* dst, Sint32 dst_pitch, Sint32 width, Sint32 height, Uint16 color)
+{
+    Sint32 index_x;
+    Sint32 index_y;
+
+    for (index_y = 0; index_y < height; index_y += 1)
+    {
+        for (index_x = 0; index_x < width; index_x += 1)
+        {
+            dst[index_x] = color;
+        }
+        dst += dst_pitch;
+    }
+}
+
+/* Draw a tile at its current animation frame.  dst points to the
+ * top-left pixel of the tile and dst_pitch is given in pixels.  Source
+ * rectangles reaching outside of the tileset image are clipped, as SDL
+ * would.
+ */
+void blit_tile(Uint16 gid, Uint16* dst, Sint32 dst_pitch, core_t* core)
+{
+    render_list_t*  list    = &core->map->render_list;
+    tile_blitter_t* blitter = &core->map->blitter;
+    Sint32          tileset = list->gid_tileset[gid];
+    Sint32          src_x   = list->src[gid].x - core->map->tileset[tileset].offset.x;
+    Sint32          src_y   = list->src[gid].y - core->map->tileset[tileset].offset.y;
+    Sint32          width   = list->tile_width;
+    Sint32          height  = list->tile_height;
+    Sint32          pitch   = blitter->size[tileset].x;
+    const Uint16*   src;
+    Sint32          index;
+
+    if (src_x + width > blitter->size[tileset].x)
+    {
+        width = blitter->size[tileset].x - src_x;
+    }
+    if (src_y + height > blitter->size[tileset].y)
+    {
+        height = blitter->size[tileset].y - src_y;
+    }
+    if (0 >= width || 0 >= height)
+    {
+        return;
+    }
+
+    src = &blitter->pixels[tileset][(src_y * pitch) + src_x];
+
+    if (blitter->is_opaque[gid])
+    {
+        for (index = 0; index < height; index += 1)
+        {
+            blit_row_opaque(dst, src, width);
+            dst += dst_pitch;
+            src += pitch;
+        }
+    }
+    else
+    {
+        for (index = 0; index < height; index += 1)
+        {
+            blit_row_keyed(dst, src, width);
+            dst += dst_pitch;
+            src += pitch;
+        }
+    }
+}
+
+static void blit_row_opaque(Uint16* dst, const Uint16* src, Sint32 width)
+{
+    Sint32 index = 0;
+
+#if defined(BLIT_SSE2)
+    for (; index + 8 <= width; index += 8)
+    {
+        _mm_storeu_si128((__m128i*)&dst[index], _mm_loadu_si128((const __m128i*)&src[index]));
+    }
+#elif defined(BLIT_NEON)
+    for (; index + 8 <= width; index += 8)
+    {
+        vst1q_u16(&dst[index], vld1q_u16(&src[index]));
+    }
+#endif
+
+    for (; index < width; index += 1)
+    {
+        dst[index] = src[index];
+    }
+}
+
+static void blit_row_keyed(Uint16* dst, const Uint16* src, Sint32 width)
+{
+    Sint32 index = 0;
+
+#if defined(BLIT_SSE2)
+    const __m128i key  = _mm_set1_epi16((short)BLIT_ALPHA);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; index + 8 <= width; index += 8)
+    {
+        __m128i source      = _mm_loadu_si128((const __m128i*)&src[index]);
+        __m128i target      = _mm_loadu_si128((const __m128i*)&dst[index]);
+        __m128i transparent = _mm_cmpeq_epi16(_mm_and_si128(source, key), zero);
+
+        target = _mm_or_si128(_mm_and_si128(transparent, target), _mm_andnot_si128(transparent, source));
+        _mm_storeu_si128((__m128i*)&dst[index], target);
+    }
+#elif defined(BLIT_NEON)
+    const uint16x8_t key = vdupq_n_u16(BLIT_ALPHA);
+
+    for (; index + 8 <= width; index += 8)
+    {
+        uint16x8_t source = vld1q_u16(&src[index]);
+        uint16x8_t target = vld1q_u16(&dst[index]);
+        uint16x8_t opaque = vtstq_u16(source, key);
+
+        vst1q_u16(&dst[index], vbslq_u16(opaque, source, target));
+    }
+#endif
+
+    for (; index < width; index += 1)
+    {
+        if (src[index] & BLIT_ALPHA)
+        {
+            dst[index] = src[index];
+        }
+    }
+}
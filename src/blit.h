@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef BLIT_H
+#define BLIT_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Direct tile blitter for the software renderer.
+ *
+ * Chunk textures use SDL_PIXELFORMAT_RGB444, so with the blitter the
+ * tileset images are kept in system memory in that format and chunks
+ * are composited there, then uploaded to a streaming texture in one
+ * go.  This skips SDL's generic blit machinery (format conversion,
+ * blending and color-key checks) for every tile.
+ *
+ * Source pixels are stored as ARGB4444 with a binary alpha: opaque
+ * pixels as 0xfrgb and transparent ones as 0, so a color-keyed copy
+ * only has to test BLIT_ALPHA and the upper nibble is ignored by the
+ * RGB444 chunk textures.  Compiled textures (see texture_blob.h) are
+ * stored in this format and used as they are.  Tiles without
+ * transparent pixels are copied unconditionally.
+ * Rows are processed with SSE2 or NEON where available and with a
+ * scalar loop otherwise; all kernels produce identical output.
+ *
+ * Tilesets with semi-transparent pixels cannot be reproduced this way;
+ * the blitter then stays disabled and SDL renders the tiles.  The
+ * converted pixels belong to the tileset resources, see cache.h.
+ */
+
+#define BLIT_ALPHA 0xf000
+
+status_t load_blit_source(SDL_Surface* surface, Uint16** pixels);
+status_t copy_blit_source(SDL_Surface* surface, Uint16** pixels);
+status_t init_tile_blitter(core_t* core);
+SDL_bool is_tile_blitter_ready(core_t* core);
+Uint16   get_blit_clear_color(core_t* core);
+void     fill_blit_rect(Uint16* dst, Sint32 dst_pitch, Sint32 width, Sint32 height, Uint16 color);
+void     blit_tile(Uint16 gid, Uint16* dst, Sint32 dst_pitch, core_t* core);
+
+#endif /* BLIT_H */
@@ -0,0 +1,469 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <cwalk.h>
+#include "cache.h"
+#include "core.h"
+
+static void   free_resource(resource_t* resource);
+static size_t get_resource_size(resource_t* resource);
+
+status_t init_cache(core_t* core)
+{
+    core->cache = (cache_t*)calloc(1, sizeof(struct cache));
+    if (! core->cache)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    core->cache->lock = SDL_CreateMutex();
+    if (! core->cache->lock)
+    {
+        dbgprint("Could not create mutex: %s", SDL_GetError());
+        free(core->cache);
+        core->cache = NULL;
+        return CORE_ERROR;
+    }
+    core->cache->budget = CACHE_DEFAULT_BUDGET;
+
+    return CORE_OK;
+}
+
+// Drop all cached maps and resources.  Has to run on the main thread.
+void free_cache(core_t* core)
+{
+    cache_t* cache = core->cache;
+
+    if (! cache)
+    {
+        return;
+    }
+
+    cache->budget = 0;
+    trim_cache(core);
+
+    while (cache->resource)
+    {
+        resource_t* resource = cache->resource;
+
+        dbgprint("Resource '%s' still in use (%d).", resource->key, resource->ref_count);
+        cache->resource = resource->next;
+        free_resource(resource);
+    }
+
+    SDL_DestroyMutex(cache->lock);
+    free(cache);
+    core->cache = NULL;
+}
+
+// Normalized form of a path, to be freed by the caller.
+char* get_cache_key(const char* file_name)
+{
+    size_t length = cwk_path_normalize(file_name, NULL, 0);
+    char*  key    = (char*)calloc(1, length + 1);
+
+    if (! key)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return NULL;
+    }
+    cwk_path_normalize(file_name, key, length + 1);
+
+    return key;
+}
+
+// Take a reference to a published resource, or return NULL on a miss.
+resource_t* acquire_resource(const char* key, core_t* core)
+{
+    cache_t*    cache = core->cache;
+    resource_t* resource;
+
+    if (! cache)
+    {
+        return NULL;
+    }
+
+    SDL_LockMutex(cache->lock);
+    for (resource = cache->resource; resource; resource = resource->next)
+    {
+        if (0 == SDL_strcmp(resource->key, key))
+        {
+            break;
+        }
+    }
+
+    if (resource)
+    {
+        resource->ref_count       += 1;
+        cache->use_count          += 1;
+        resource->last_use         = cache->use_count;
+        cache->resource_hit_count += 1;
+    }
+    else
+    {
+        cache->resource_miss_count += 1;
+    }
+    SDL_UnlockMutex(cache->lock);
+
+    return resource;
+}
+
+/* A new, unpublished resource holding one reference.  Offsets, sizes
+ * and pixels of its images are set by the caller.
+ */
+resource_t* create_resource(const char* key, Sint32 image_count)
+{
+    resource_t* resource = (resource_t*)calloc(1, sizeof(struct resource));
+
+    if (! resource)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return NULL;
+    }
+
+    resource->key    = SDL_strdup(key);
+    resource->offset = (SDL_Point*)calloc((size_t)image_count, sizeof(SDL_Point));
+    resource->size   = (SDL_Point*)calloc((size_t)image_count, sizeof(SDL_Point));
+    resource->pixels = (Uint16**)calloc((size_t)image_count, sizeof(Uint16*));
+    if (! resource->key || ! resource->offset || ! resource->size || ! resource->pixels)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        free_resource(resource);
+        return NULL;
+    }
+    resource->image_count = image_count;
+    resource->ref_count   = 1;
+
+    return resource;
+}
+
+void retain_resource(resource_t* resource, core_t* core)
+{
+    if (core->cache)
+    {
+        SDL_LockMutex(core->cache->lock);
+    }
+    resource->ref_count += 1;
+    if (core->cache)
+    {
+        SDL_UnlockMutex(core->cache->lock);
+    }
+}
+
+/* Make a resource with a texture available to other maps.  If another
+ * one with the same key was published first, that one is used instead
+ * and *resource is replaced.  Has to run on the main thread.
+ */
+void publish_resource(resource_t** resource, core_t* core)
+{
+    cache_t*    cache = core->cache;
+    resource_t* published;
+
+    if (! cache || (*resource)->is_cached)
+    {
+        return;
+    }
+
+    SDL_LockMutex(cache->lock);
+    for (published = cache->resource; published; published = published->next)
+    {
+        if (0 == SDL_strcmp(published->key, (*resource)->key))
+        {
+            break;
+        }
+    }
+
+    if (published)
+    {
+        published->ref_count += (*resource)->ref_count;
+        SDL_UnlockMutex(cache->lock);
+
+        free_resource(*resource);
+        *resource = published;
+        return;
+    }
+
+    cache->use_count           += 1;
+    (*resource)->last_use       = cache->use_count;
+    (*resource)->byte_count     = get_resource_size(*resource);
+    (*resource)->is_cached      = SDL_TRUE;
+    (*resource)->next           = cache->resource;
+    cache->resource             = *resource;
+    cache->resource_count      += 1;
+    cache->resource_byte_count += (*resource)->byte_count;
+    SDL_UnlockMutex(cache->lock);
+}
+
+/* Drop a reference.  Published resources stay cached until evicted;
+ * unpublished ones have no texture yet and are freed right away, which
+ * is safe on any thread.
+ */
+void release_resource(resource_t* resource, core_t* core)
+{
+    cache_t* cache = core->cache;
+
+    if (! resource)
+    {
+        return;
+    }
+
+    if (cache)
+    {
+        SDL_LockMutex(cache->lock);
+    }
+    resource->ref_count -= 1;
+    if (resource->is_cached || 0 < resource->ref_count)
+    {
+        resource = NULL;
+    }
+    if (cache)
+    {
+        SDL_UnlockMutex(cache->lock);
+    }
+
+    if (resource)
+    {
+        free_resource(resource);
+    }
+}
+
+/* Remove a map from the cache and return it, or return NULL on a
+ * miss.  The caller owns the map again.
+ */
+map_t* take_cached_map(const char* key, core_t* core)
+{
+    cache_t*      cache = core->cache;
+    cached_map_t* entry;
+    cached_map_t* previous = NULL;
+    map_t*        map      = NULL;
+
+    if (! cache || ! key)
+    {
+        return NULL;
+    }
+
+    SDL_LockMutex(cache->lock);
+    for (entry = cache->map; entry; previous = entry, entry = entry->next)
+    {
+        if (0 == SDL_strcmp(entry->map->file_name, key))
+        {
+            break;
+        }
+    }
+
+    if (entry)
+    {
+        if (previous)
+        {
+            previous->next = entry->next;
+        }
+        else
+        {
+            cache->map = entry->next;
+        }
+        cache->map_count      -= 1;
+        cache->map_byte_count -= entry->byte_count;
+        cache->map_hit_count  += 1;
+        map                    = entry->map;
+        free(entry);
+    }
+    else
+    {
+        cache->map_miss_count += 1;
+    }
+    SDL_UnlockMutex(cache->lock);
+
+    return map;
+}
+
+/* Hand an unloaded map over to the cache.  byte_count is its estimated
+ * size.  If the map cannot be cached, it is freed.
+ */
+void store_cached_map(map_t* map, size_t byte_count, core_t* core)
+{
+    cache_t*      cache = core->cache;
+    cached_map_t* entry;
+
+    if (! cache)
+    {
+        free_map(map, core);
+        return;
+    }
+
+    entry = (cached_map_t*)calloc(1, sizeof(struct cached_map));
+    if (! entry)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        free_map(map, core);
+        return;
+    }
+    entry->map        = map;
+    entry->byte_count = byte_count;
+
+    SDL_LockMutex(cache->lock);
+    cache->use_count      += 1;
+    entry->last_use        = cache->use_count;
+    entry->next            = cache->map;
+    cache->map             = entry;
+    cache->map_count      += 1;
+    cache->map_byte_count += byte_count;
+    SDL_UnlockMutex(cache->lock);
+}
+
+/* Evict the least recently used cached maps and unused resources until
+ * the cache fits into its budget.  Has to run on the main thread.
+ */
+void trim_cache(core_t* core)
+{
+    cache_t* cache = core->cache;
+
+    if (! cache)
+    {
+        return;
+    }
+
+    SDL_LockMutex(cache->lock);
+    while (cache->map_byte_count + cache->resource_byte_count > cache->budget)
+    {
+        cached_map_t** map_link      = NULL;
+        resource_t**   resource_link = NULL;
+        cached_map_t** entry;
+        resource_t**   resource;
+        Uint32         oldest        = 0;
+
+        for (entry = &cache->map; *entry; entry = &(*entry)->next)
+        {
+            if (! map_link || (*entry)->last_use < oldest)
+            {
+                map_link = entry;
+                oldest   = (*entry)->last_use;
+            }
+        }
+
+        for (resource = &cache->resource; *resource; resource = &(*resource)->next)
+        {
+            if (0 < (*resource)->ref_count)
+            {
+                continue;
+            }
+            if ((! map_link && ! resource_link) || (*resource)->last_use < oldest)
+            {
+                map_link      = NULL;
+                resource_link = resource;
+                oldest        = (*resource)->last_use;
+            }
+        }
+
+        if (resource_link)
+        {
+            resource_t* evicted = *resource_link;
+
+            *resource_link              = evicted->next;
+            cache->resource_count      -= 1;
+            cache->resource_byte_count -= evicted->byte_count;
+            free_resource(evicted);
+        }
+        else if (map_link)
+        {
+            cached_map_t* evicted = *map_link;
+
+            *map_link              = evicted->next;
+            cache->map_count      -= 1;
+            cache->map_byte_count -= evicted->byte_count;
+
+            // Freeing the map releases its resources, which takes the lock.
+            SDL_UnlockMutex(cache->lock);
+            free_map(evicted->map, core);
+            free(evicted);
+            SDL_LockMutex(cache->lock);
+        }
+        else
+        {
+            break;
+        }
+    }
+    SDL_UnlockMutex(cache->lock);
+}
+
+void set_cache_budget(size_t budget, core_t* core)
+{
+    if (! core->cache)
+    {
+        return;
+    }
+
+    core->cache->budget = budget;
+    trim_cache(core);
+}
+
+void get_cache_stats(cache_stats_t* stats, core_t* core)
+{
+    cache_t* cache = core->cache;
+
+    SDL_zerop(stats);
+    if (! cache)
+    {
+        return;
+    }
+
+    SDL_LockMutex(cache->lock);
+    stats->budget              = cache->budget;
+    stats->resource_byte_count = cache->resource_byte_count;
+    stats->map_byte_count      = cache->map_byte_count;
+    stats->resource_count      = cache->resource_count;
+    stats->map_count           = cache->map_count;
+    stats->resource_hit_count  = cache->resource_hit_count;
+    stats->resource_miss_count = cache->resource_miss_count;
+    stats->map_hit_count       = cache->map_hit_count;
+    stats->map_miss_count      = cache->map_miss_count;
+    SDL_UnlockMutex(cache->lock);
+}
+
+static void free_resource(resource_t* resource)
+{
+    Sint32 index;
+
+    if (resource->texture)
+    {
+        SDL_DestroyTexture(resource->texture);
+    }
+    if (resource->pixels)
+    {
+        for (index = 0; index < resource->image_count; index += 1)
+        {
+            free(resource->pixels[index]);
+        }
+    }
+
+    free(resource->pixels);
+    free(resource->size);
+    free(resource->offset);
+    SDL_free(resource->key);
+    free(resource);
+}
+
+// Texture memory plus the pixels kept for the tile blitter.
+static size_t get_resource_size(resource_t* resource)
+{
+    size_t size = 0;
+    Uint32 format;
+    int    width;
+    int    height;
+    Sint32 index;
+
+    if (resource->texture && 0 == SDL_QueryTexture(resource->texture, &format, NULL, &width, &height))
+    {
+        size += (size_t)width * (size_t)height * SDL_BYTESPERPIXEL(format);
+    }
+
+    for (index = 0; index < resource->image_count; index += 1)
+    {
+        if (resource->pixels[index])
+        {
+            size += (size_t)(resource->size[index].x * resource->size[index].y) * sizeof(Uint16);
+        }
+    }
+
+    return size;
+}
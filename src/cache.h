@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Resource and map cache.
+ *
+ * Tileset textures are shared between maps as reference-counted
+ * resources, keyed by the normalized path of their image, see
+ * resource_t.  A resource is created unpublished by the map loading
+ * it, possibly on the map loader thread, and published once its
+ * texture exists; a resource with the same key published in the
+ * meantime takes its place.  Unused resources are not destroyed right
+ * away but kept for the next map needing them.
+ *
+ * Unloaded maps are kept in the cache as they are, minus their chunk
+ * textures, so that going back to a map needs neither parsing nor
+ * decoding.  Cached maps keep their resources in use.
+ *
+ * Both are evicted in least recently used order by trim_cache, while
+ * the estimated size of everything the cache holds exceeds its budget.
+ * Resources in use by the current map are counted but never evicted.
+ * Textures may only be destroyed on the main thread, so eviction only
+ * happens there.
+ */
+
+#define CACHE_DEFAULT_BUDGET (4 * 1024 * 1024)
+
+typedef struct cache_stats
+{
+    size_t budget;
+    size_t resource_byte_count;
+    size_t map_byte_count;
+    Sint32 resource_count;
+    Sint32 map_count;
+    Uint32 resource_hit_count;
+    Uint32 resource_miss_count;
+    Uint32 map_hit_count;
+    Uint32 map_miss_count;
+
+} cache_stats_t;
+
+status_t    init_cache(core_t* core);
+void        free_cache(core_t* core);
+char*       get_cache_key(const char* file_name);
+resource_t* acquire_resource(const char* key, core_t* core);
+resource_t* create_resource(const char* key, Sint32 image_count);
+void        retain_resource(resource_t* resource, core_t* core);
+void        publish_resource(resource_t** resource, core_t* core);
+void        release_resource(resource_t* resource, core_t* core);
+map_t*      take_cached_map(const char* key, core_t* core);
+void        store_cached_map(map_t* map, size_t byte_count, core_t* core);
+void        trim_cache(core_t* core);
+void        set_cache_budget(size_t budget, core_t* core);
+void        get_cache_stats(cache_stats_t* stats, core_t* core);
+
+#endif /* CACHE_H */
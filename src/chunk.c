@@ -0,0 +1,772 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include "arena.h"
+#include "blit.h"
+#include "chunk.h"
+#include "core.h"
+#include "job.h"
+#include "profile.h"
+#include "render_list.h"
+#include "tiled.h"
+
+#define CHUNK_BAKE_BATCH_MAX (JOB_THREAD_MAX + 1)
+
+typedef struct chunk_bake
+{
+    chunk_t**      batch;
+    chunk_cache_t* cache;
+    core_t*        core;
+    Uint16         clear_color;
+
+} chunk_bake_t;
+
+static status_t bake_chunk(chunk_t* chunk, chunk_cache_t* cache, core_t* core);
+static status_t bake_chunks(chunk_t** batch, Sint32 batch_count, chunk_cache_t* cache, core_t* core);
+static void     blit_chunk_job(void* data, Sint32 index);
+static void     draw_tile(Uint16 gid, SDL_Rect* dst, core_t* core);
+static status_t create_chunk_texture(chunk_t* chunk, chunk_cache_t* cache, core_t* core);
+static status_t update_chunk_texture(chunk_t* chunk, const SDL_Rect* rect, core_t* core);
+#ifdef TILE_BATCH_SUPPORTED
+static status_t batch_tile(Uint16 gid, Sint32 pos_x, Sint32 pos_y, core_t* core);
+static status_t flush_tile_batch(core_t* core);
+#endif
+
+status_t init_chunk_cache(chunk_cache_t* cache, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    Sint32         index;
+
+    cache->chunk_width   = list->tile_width  * CHUNK_SIZE;
+    cache->chunk_height  = list->tile_height * CHUNK_SIZE;
+    cache->chunk_count_x = list->chunk_count_x;
+    cache->chunk_count_y = list->chunk_count_y;
+
+    /* A viewport of w pixels overlaps at most ceil(w / chunk_width) + 1
+     * chunks per axis.  Visible chunks are consecutive, so mapping
+     * them into a ring of that size never lets two of them collide.
+     */
+    cache->ring_width  = (176 + cache->chunk_width  - 1) / cache->chunk_width  + 1;
+    cache->ring_height = (208 + cache->chunk_height - 1) / cache->chunk_height + 1;
+
+    if (cache->ring_width > cache->chunk_count_x)
+    {
+        cache->ring_width = cache->chunk_count_x;
+    }
+    if (cache->ring_height > cache->chunk_count_y)
+    {
+        cache->ring_height = cache->chunk_count_y;
+    }
+
+    cache->chunk = (chunk_t*)arena_calloc(core->map->arena, (size_t)(cache->ring_width * cache->ring_height), sizeof(struct chunk));
+    if (! cache->chunk)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    for (index = 0; index < cache->ring_width * cache->ring_height; index += 1)
+    {
+        cache->chunk[index].index_x = -1;
+        cache->chunk[index].index_y = -1;
+    }
+
+    return CORE_OK;
+}
+
+/* Drop the textures and pixels of all chunks, which get baked again
+ * when visible.  Used for maps kept in the map cache.
+ */
+void reset_chunk_cache(chunk_cache_t* cache)
+{
+    Sint32 index;
+
+    if (! cache->chunk)
+    {
+        return;
+    }
+
+    for (index = 0; index < cache->ring_width * cache->ring_height; index += 1)
+    {
+        if (cache->chunk[index].texture)
+        {
+            SDL_DestroyTexture(cache->chunk[index].texture);
+        }
+        free(cache->chunk[index].pixels);
+
+        cache->chunk[index].texture = NULL;
+        cache->chunk[index].pixels  = NULL;
+        cache->chunk[index].index_x  = -1;
+        cache->chunk[index].index_y  = -1;
+        cache->chunk[index].is_baked = SDL_FALSE;
+    }
+}
+
+void get_visible_chunks(chunk_cache_t* cache, SDL_Rect* range, core_t* core)
+{
+    Sint32 view_x = core->camera.view_x - core->map->pos_x;
+    Sint32 view_y = core->camera.view_y - core->map->pos_y;
+    Sint32 last_x;
+    Sint32 last_y;
+
+    range->x = view_x / cache->chunk_width;
+    range->y = view_y / cache->chunk_height;
+    last_x   = (view_x + 176 - 1) / cache->chunk_width;
+    last_y   = (view_y + 208 - 1) / cache->chunk_height;
+
+    if (range->x < 0)
+    {
+        range->x = 0;
+    }
+    if (range->y < 0)
+    {
+        range->y = 0;
+    }
+    if (last_x >= cache->chunk_count_x)
+    {
+        last_x = cache->chunk_count_x - 1;
+    }
+    if (last_y >= cache->chunk_count_y)
+    {
+        last_y = cache->chunk_count_y - 1;
+    }
+
+    range->w = last_x - range->x + 1;
+    range->h = last_y - range->y + 1;
+}
+
+/* Assign the chunks that have just scrolled into view to their ring
+ * slots and bake pending chunks, closest to the center of the view
+ * first.  With progressive baking, this stops once the frame's bake
+ * budget is spent and asks for another frame to carry on.
+ */
+status_t update_chunk_cache(chunk_cache_t* cache, core_t* core)
+{
+    SDL_Rect range;
+    Sint32   center_x  = core->camera.view_x - core->map->pos_x + (176 / 2);
+    Sint32   center_y  = core->camera.view_y - core->map->pos_y + (208 / 2);
+    Sint32   batch_max = 1;
+    Sint32   index_x;
+    Sint32   index_y;
+
+    get_visible_chunks(cache, &range, core);
+
+    for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+    {
+        for (index_x = range.x; index_x < range.x + range.w; index_x += 1)
+        {
+            chunk_t* chunk = &cache->chunk[((index_y % cache->ring_height) * cache->ring_width) + (index_x % cache->ring_width)];
+
+            if (chunk->index_x == index_x && chunk->index_y == index_y)
+            {
+                continue;
+            }
+
+            chunk->index_x  = index_x;
+            chunk->index_y  = index_y;
+            chunk->is_baked = SDL_FALSE;
+        }
+    }
+
+    /* With the tile blitter, the nearest chunks are baked in batches of
+     * one per thread, see bake_chunks.  Streamed chunks are baked one at
+     * a time, as reading a chunk may evict another one of the batch.
+     */
+    if (is_tile_blitter_ready(core) && ! core->map->render_list.stream)
+    {
+        batch_max = SDL_min(get_job_thread_count(core) + 1, CHUNK_BAKE_BATCH_MAX);
+    }
+
+    for (;;)
+    {
+        chunk_t* batch[CHUNK_BAKE_BATCH_MAX];
+        Sint32   batch_distance[CHUNK_BAKE_BATCH_MAX];
+        Sint32   batch_count = 0;
+        Sint32   index;
+
+        for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+        {
+            for (index_x = range.x; index_x < range.x + range.w; index_x += 1)
+            {
+                chunk_t* chunk = &cache->chunk[((index_y % cache->ring_height) * cache->ring_width) + (index_x % cache->ring_width)];
+                Sint32   delta_x;
+                Sint32   delta_y;
+                Sint32   distance;
+
+                if (chunk->is_baked)
+                {
+                    continue;
+                }
+
+                delta_x  = (index_x * cache->chunk_width)  + (cache->chunk_width  / 2) - center_x;
+                delta_y  = (index_y * cache->chunk_height) + (cache->chunk_height / 2) - center_y;
+                distance = (delta_x * delta_x) + (delta_y * delta_y);
+
+                // Keep the batch sorted, nearest first.
+                for (index = batch_count; index > 0 && batch_distance[index - 1] > distance; index -= 1)
+                {
+                    if (index < batch_max)
+                    {
+                        batch[index]          = batch[index - 1];
+                        batch_distance[index] = batch_distance[index - 1];
+                    }
+                }
+
+                if (index < batch_max)
+                {
+                    batch[index]          = chunk;
+                    batch_distance[index] = distance;
+                    batch_count           = SDL_min(batch_count + 1, batch_max);
+                }
+            }
+        }
+
+        if (0 == batch_count)
+        {
+            break;
+        }
+
+        if (core->is_progressive_bake_enabled && 0 < core->frame_bake_count && SDL_GetPerformanceCounter() >= core->bake_deadline)
+        {
+            request_redraw(RENDER_CHANGE_BAKE, core);
+            break;
+        }
+
+        if (CORE_OK != bake_chunks(batch, batch_count, cache, core))
+        {
+            for (index = 0; index < batch_count; index += 1)
+            {
+                batch[index]->index_x = -1;
+                batch[index]->index_y = -1;
+            }
+            return CORE_ERROR;
+        }
+
+        for (index = 0; index < batch_count; index += 1)
+        {
+            batch[index]->is_baked = SDL_TRUE;
+        }
+        core->frame_bake_count += batch_count;
+    }
+
+    return CORE_OK;
+}
+
+// Start the bake budget of a frame.
+void start_chunk_baking(core_t* core)
+{
+    core->bake_deadline    = SDL_GetPerformanceCounter() + ((core->timer.frequency * core->bake_budget_us) / 1000000);
+    core->frame_bake_count = 0;
+}
+
+status_t draw_chunk_cache(chunk_cache_t* cache, core_t* core)
+{
+    SDL_Rect range;
+    Sint32   index_x;
+    Sint32   index_y;
+
+    get_visible_chunks(cache, &range, core);
+
+    for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+    {
+        for (index_x = range.x; index_x < range.x + range.w; index_x += 1)
+        {
+            chunk_t* chunk = &cache->chunk[((index_y % cache->ring_height) * cache->ring_width) + (index_x % cache->ring_width)];
+            SDL_Rect dst;
+
+            dst.x = core->map->pos_x + (index_x * cache->chunk_width)  - core->camera.view_x;
+            dst.y = core->map->pos_y + (index_y * cache->chunk_height) - core->camera.view_y;
+            dst.w = cache->chunk_width;
+            dst.h = cache->chunk_height;
+
+            if (chunk->is_baked)
+            {
+                if (0 > render_copy(chunk->texture, NULL, &dst, core))
+                {
+                    dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+                    return CORE_ERROR;
+                }
+                continue;
+            }
+
+            // Not baked yet: draw the tiles straight from the tilesets.
+            SDL_RenderFillRect(core->renderer, &dst);
+            if (CORE_OK != render_chunk((index_y * cache->chunk_count_x) + index_x, dst.x, dst.y, core))
+            {
+                return CORE_ERROR;
+            }
+            cache->direct_draw_count += 1;
+        }
+    }
+
+    return CORE_OK;
+}
+
+/* Redraw the full layer stack of a single tile inside a resident
+ * chunk.  Unless the chunk is composited by the tile blitter, the
+ * chunk texture has to be the current render target.
+ */
+void redraw_chunk_tile(chunk_t* chunk, Sint32 tile_x, Sint32 tile_y, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    SDL_Rect       dst;
+    Sint32         layer_index;
+
+    dst.w = list->tile_width;
+    dst.h = list->tile_height;
+    dst.x = (tile_x - (chunk->index_x * CHUNK_SIZE)) * dst.w;
+    dst.y = (tile_y - (chunk->index_y * CHUNK_SIZE)) * dst.h;
+
+    if (chunk->pixels)
+    {
+        Sint32  pitch  = list->tile_width * CHUNK_SIZE;
+        Uint16* pixels = &chunk->pixels[(dst.y * pitch) + dst.x];
+
+        fill_blit_rect(pixels, pitch, dst.w, dst.h, get_blit_clear_color(core));
+
+        for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+        {
+            Uint16 gid = get_render_list_gid(list, layer_index, tile_x, tile_y);
+
+            if (gid)
+            {
+                blit_tile(gid, pixels, pitch, core);
+            }
+        }
+
+        update_chunk_texture(chunk, &dst, core);
+        return;
+    }
+
+    SDL_RenderFillRect(core->renderer, &dst);
+
+    for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+    {
+        Uint16 gid = get_render_list_gid(list, layer_index, tile_x, tile_y);
+
+        if (gid)
+        {
+            draw_tile(gid, &dst, core);
+        }
+    }
+}
+
+/* The batch buffers are sized for the chunk with the most non-empty
+ * cells.  Without batching support in SDL, tiles are always drawn one
+ * by one.
+ */
+status_t init_tile_batch(core_t* core)
+{
+#ifdef TILE_BATCH_SUPPORTED
+    render_list_t* list  = &core->map->render_list;
+    tile_batch_t*  batch = &core->map->tile_batch;
+    Sint32         chunk_index;
+    Sint32         index;
+
+    // A streamed chunk can hold a cell for every tile of every layer.
+    if (list->stream)
+    {
+        batch->quad_max = list->layer_count * CHUNK_SIZE * CHUNK_SIZE;
+    }
+    else if (! list->cell)
+    {
+        return CORE_OK;
+    }
+
+    for (chunk_index = 0; ! list->stream && chunk_index < list->chunk_count_x * list->chunk_count_y; chunk_index += 1)
+    {
+        Sint32 cell_count = (Sint32)(list->cell_offset[chunk_index + 1] - list->cell_offset[chunk_index]);
+
+        if (cell_count > batch->quad_max)
+        {
+            batch->quad_max = cell_count;
+        }
+    }
+
+    if (0 == batch->quad_max)
+    {
+        return CORE_OK;
+    }
+
+    batch->vertex = (SDL_Vertex*)arena_calloc(core->map->arena, (size_t)batch->quad_max * 4, sizeof(SDL_Vertex));
+    batch->index  = (int*)arena_calloc(core->map->arena, (size_t)batch->quad_max * 6, sizeof(int));
+    if (! batch->vertex || ! batch->index)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    // Two triangles per quad: top left, top right, bottom left, bottom right.
+    for (index = 0; index < batch->quad_max; index += 1)
+    {
+        Sint32 corner;
+
+        batch->index[(index * 6) + 0] = (index * 4) + 0;
+        batch->index[(index * 6) + 1] = (index * 4) + 1;
+        batch->index[(index * 6) + 2] = (index * 4) + 2;
+        batch->index[(index * 6) + 3] = (index * 4) + 2;
+        batch->index[(index * 6) + 4] = (index * 4) + 1;
+        batch->index[(index * 6) + 5] = (index * 4) + 3;
+
+        for (corner = 0; corner < 4; corner += 1)
+        {
+            SDL_Color* color = &batch->vertex[(index * 4) + corner].color;
+
+            color->r = 0xff;
+            color->g = 0xff;
+            color->b = 0xff;
+            color->a = 0xff;
+        }
+    }
+#endif
+
+    return CORE_OK;
+}
+
+size_t get_chunk_cache_size(chunk_cache_t* cache)
+{
+    size_t size = 0;
+    Sint32 index;
+
+    if (! cache->chunk)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < cache->ring_width * cache->ring_height; index += 1)
+    {
+        if (cache->chunk[index].texture)
+        {
+            size += (size_t)(cache->chunk_width * cache->chunk_height) * SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_RGB444);
+        }
+        if (cache->chunk[index].pixels)
+        {
+            size += (size_t)(cache->chunk_width * cache->chunk_height) * sizeof(Uint16);
+        }
+    }
+
+    return size;
+}
+
+/* Composite the cells of a chunk into a pixel buffer of the tile
+ * blitter.  pitch is given in pixels.
+ */
+void blit_chunk(Sint32 chunk_index, Uint16* pixels, Sint32 pitch, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    render_cell_t* cells;
+    Sint32         cell_count;
+    Sint32         index;
+
+    cells = get_render_list_cells(list, chunk_index, &cell_count);
+
+    for (index = 0; index < cell_count; index += 1)
+    {
+        render_cell_t* cell = &cells[index];
+
+        blit_tile(cell->gid, &pixels[(cell->pos_y * list->tile_height * pitch) + (cell->pos_x * list->tile_width)], pitch, core);
+    }
+}
+
+/* Draw the cells of a chunk to the current render target, with its
+ * top-left corner at pos_x, pos_y.
+ */
+status_t render_chunk(Sint32 chunk_index, Sint32 pos_x, Sint32 pos_y, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    render_cell_t* cells;
+    Sint32         cell_count;
+    Sint32         index;
+    SDL_Rect       dst;
+
+    cells = get_render_list_cells(list, chunk_index, &cell_count);
+    if (! cells)
+    {
+        return CORE_OK;
+    }
+
+#ifdef TILE_BATCH_SUPPORTED
+    if (core->is_tile_batch_enabled && core->map->tile_batch.vertex)
+    {
+        for (index = 0; index < cell_count; index += 1)
+        {
+            render_cell_t* cell = &cells[index];
+
+            if (CORE_OK != batch_tile(cell->gid, pos_x + (cell->pos_x * list->tile_width), pos_y + (cell->pos_y * list->tile_height), core))
+            {
+                return CORE_ERROR;
+            }
+        }
+
+        return flush_tile_batch(core);
+    }
+#endif
+
+    dst.w = list->tile_width;
+    dst.h = list->tile_height;
+
+    for (index = 0; index < cell_count; index += 1)
+    {
+        render_cell_t* cell = &cells[index];
+
+        dst.x = pos_x + (cell->pos_x * list->tile_width);
+        dst.y = pos_y + (cell->pos_y * list->tile_height);
+
+        draw_tile(cell->gid, &dst, core);
+    }
+
+    return CORE_OK;
+}
+
+static status_t bake_chunk(chunk_t* chunk, chunk_cache_t* cache, core_t* core)
+{
+    Sint32 chunk_index = (chunk->index_y * cache->chunk_count_x) + chunk->index_x;
+
+    if (CORE_OK != create_chunk_texture(chunk, cache, core))
+    {
+        return CORE_ERROR;
+    }
+
+    cache->bake_count += 1;
+
+    // With the tile blitter, the chunk is composited in system memory and uploaded at once.
+    if (chunk->pixels)
+    {
+        fill_blit_rect(chunk->pixels, cache->chunk_width, cache->chunk_width, cache->chunk_height, get_blit_clear_color(core));
+        blit_chunk(chunk_index, chunk->pixels, cache->chunk_width, core);
+
+        return update_chunk_texture(chunk, NULL, core);
+    }
+
+    if (0 > set_render_target(chunk->texture, core))
+    {
+        dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+        return CORE_ERROR;
+    }
+    SDL_RenderClear(core->renderer);
+
+    return render_chunk(chunk_index, 0, 0, core);
+}
+
+/* Bake the chunks of a batch.  Their pixels are composited in parallel
+ * by the job system; textures are only touched on the calling thread.
+ */
+static status_t bake_chunks(chunk_t** batch, Sint32 batch_count, chunk_cache_t* cache, core_t* core)
+{
+    chunk_bake_t bake;
+    Sint32       index;
+
+    if (1 == batch_count)
+    {
+        return bake_chunk(batch[0], cache, core);
+    }
+
+    for (index = 0; index < batch_count; index += 1)
+    {
+        if (CORE_OK != create_chunk_texture(batch[index], cache, core))
+        {
+            return CORE_ERROR;
+        }
+        cache->bake_count += 1;
+    }
+
+    bake.batch       = batch;
+    bake.cache       = cache;
+    bake.core        = core;
+    bake.clear_color = get_blit_clear_color(core);
+
+    run_jobs(blit_chunk_job, &bake, batch_count, 1, core);
+
+    for (index = 0; index < batch_count; index += 1)
+    {
+        if (CORE_OK != update_chunk_texture(batch[index], NULL, core))
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    return CORE_OK;
+}
+
+static void blit_chunk_job(void* data, Sint32 index)
+{
+    chunk_bake_t*  bake  = (chunk_bake_t*)data;
+    chunk_cache_t* cache = bake->cache;
+    chunk_t*       chunk = bake->batch[index];
+
+    fill_blit_rect(chunk->pixels, cache->chunk_width, cache->chunk_width, cache->chunk_height, bake->clear_color);
+    blit_chunk((chunk->index_y * cache->chunk_count_x) + chunk->index_x, chunk->pixels, cache->chunk_width, bake->core);
+}
+
+#ifdef TILE_BATCH_SUPPORTED
+/* Append a tile to the batch.  Cells are sorted by layer, so the batch
+ * is flushed whenever the source texture changes to keep the order in
+ * which overlapping tiles are drawn.
+ */
+static status_t batch_tile(Uint16 gid, Sint32 pos_x, Sint32 pos_y, core_t* core)
+{
+    render_list_t* list    = &core->map->render_list;
+    tile_batch_t*  batch   = &core->map->tile_batch;
+    SDL_Texture*   texture = core->map->tileset[list->gid_tileset[gid]].texture;
+    SDL_Vertex*    vertex;
+    float          left;
+    float          top;
+    float          right;
+    float          bottom;
+    float          src_left;
+    float          src_top;
+    float          src_right;
+    float          src_bottom;
+
+    if (texture != batch->texture)
+    {
+        int width;
+        int height;
+
+        if (CORE_OK != flush_tile_batch(core))
+        {
+            return CORE_ERROR;
+        }
+
+        if (0 > SDL_QueryTexture(texture, NULL, NULL, &width, &height))
+        {
+            dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+            return CORE_ERROR;
+        }
+
+        batch->texture      = texture;
+        batch->texel_width  = 1.f / (float)width;
+        batch->texel_height = 1.f / (float)height;
+    }
+
+    left       = (float)pos_x;
+    top        = (float)pos_y;
+    right      = (float)(pos_x + list->tile_width);
+    bottom     = (float)(pos_y + list->tile_height);
+    src_left   = (float)list->src[gid].x * batch->texel_width;
+    src_top    = (float)list->src[gid].y * batch->texel_height;
+    src_right  = (float)(list->src[gid].x + list->tile_width)  * batch->texel_width;
+    src_bottom = (float)(list->src[gid].y + list->tile_height) * batch->texel_height;
+
+    vertex = &batch->vertex[batch->quad_count * 4];
+
+    vertex[0].position.x  = left;
+    vertex[0].position.y  = top;
+    vertex[0].tex_coord.x = src_left;
+    vertex[0].tex_coord.y = src_top;
+    vertex[1].position.x  = right;
+    vertex[1].position.y  = top;
+    vertex[1].tex_coord.x = src_right;
+    vertex[1].tex_coord.y = src_top;
+    vertex[2].position.x  = left;
+    vertex[2].position.y  = bottom;
+    vertex[2].tex_coord.x = src_left;
+    vertex[2].tex_coord.y = src_bottom;
+    vertex[3].position.x  = right;
+    vertex[3].position.y  = bottom;
+    vertex[3].tex_coord.x = src_right;
+    vertex[3].tex_coord.y = src_bottom;
+
+    batch->quad_count += 1;
+
+    return CORE_OK;
+}
+
+static status_t flush_tile_batch(core_t* core)
+{
+    tile_batch_t* batch  = &core->map->tile_batch;
+    status_t      status = CORE_OK;
+
+    if (0 < batch->quad_count)
+    {
+        if (0 > render_geometry(batch->texture, batch->vertex, batch->quad_count * 4, batch->index, batch->quad_count * 6, core))
+        {
+            dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+            status = CORE_ERROR;
+        }
+    }
+
+    batch->quad_count = 0;
+    batch->texture    = NULL;
+
+    return status;
+}
+#endif
+
+// Draw a tile at its current animation frame.
+static void draw_tile(Uint16 gid, SDL_Rect* dst, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    SDL_Rect       src;
+
+    src.x = list->src[gid].x;
+    src.y = list->src[gid].y;
+    src.w = dst->w;
+    src.h = dst->h;
+
+    render_copy(core->map->tileset[list->gid_tileset[gid]].texture, &src, dst, core);
+}
+
+static status_t create_chunk_texture(chunk_t* chunk, chunk_cache_t* cache, core_t* core)
+{
+    SDL_bool is_blitted = is_tile_blitter_ready(core);
+
+    if (chunk->texture)
+    {
+        return CORE_OK;
+    }
+
+    if (is_blitted && ! chunk->pixels)
+    {
+        chunk->pixels = (Uint16*)calloc((size_t)(cache->chunk_width * cache->chunk_height), sizeof(Uint16));
+        if (! chunk->pixels)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            return CORE_ERROR;
+        }
+    }
+
+    chunk->texture = SDL_CreateTexture(
+        core->renderer,
+        SDL_PIXELFORMAT_RGB444,
+        is_blitted ? SDL_TEXTUREACCESS_STREAMING : SDL_TEXTUREACCESS_TARGET,
+        cache->chunk_width,
+        cache->chunk_height);
+
+    if (! chunk->texture)
+    {
+        dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+        return CORE_ERROR;
+    }
+
+    if (0 > SDL_SetTextureBlendMode(chunk->texture, SDL_BLENDMODE_BLEND))
+    {
+        dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+        SDL_DestroyTexture(chunk->texture);
+        chunk->texture = NULL;
+        return CORE_ERROR;
+    }
+
+    return CORE_OK;
+}
+
+// Upload the composited pixels of a chunk, or of a part of it.
+static status_t update_chunk_texture(chunk_t* chunk, const SDL_Rect* rect, core_t* core)
+{
+    Sint32        pitch  = core->map->render_list.tile_width * CHUNK_SIZE;
+    const Uint16* pixels = chunk->pixels;
+
+    if (rect)
+    {
+        pixels += (rect->y * pitch) + rect->x;
+    }
+
+    if (0 > SDL_UpdateTexture(chunk->texture, rect, pixels, pitch * (int)sizeof(Uint16)))
+    {
+        dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+        return CORE_ERROR;
+    }
+    PROFILE_COUNT(PROFILE_TEXTURE_BYTES, (rect ? rect->w * rect->h : pitch * core->map->render_list.tile_height * CHUNK_SIZE) * (Sint32)sizeof(Uint16), core);
+
+    return CORE_OK;
+}
@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <SDL.h>
+#include "core.h"
+
+status_t init_chunk_cache(chunk_cache_t* cache, core_t* core);
+void     reset_chunk_cache(chunk_cache_t* cache);
+void     get_visible_chunks(chunk_cache_t* cache, SDL_Rect* range, core_t* core);
+status_t update_chunk_cache(chunk_cache_t* cache, core_t* core);
+void     start_chunk_baking(core_t* core);
+status_t draw_chunk_cache(chunk_cache_t* cache, core_t* core);
+void     blit_chunk(Sint32 chunk_index, Uint16* pixels, Sint32 pitch, core_t* core);
+status_t render_chunk(Sint32 chunk_index, Sint32 pos_x, Sint32 pos_y, core_t* core);
+void     redraw_chunk_tile(chunk_t* chunk, Sint32 tile_x, Sint32 tile_y, core_t* core);
+size_t   get_chunk_cache_size(chunk_cache_t* cache);
+status_t init_tile_batch(core_t* core);
+
+#endif /* CHUNK_H */
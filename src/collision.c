@@ -0,0 +1,507 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include "arena.h"
+#include "collision.h"
+#include "core.h"
+#include "render_list.h"
+#include "tile_flag.h"
+
+static Sint32   get_cell_index(Sint32 pos, Sint32 size);
+static Sint32   find_solid_cell(const collision_grid_t* grid, Sint32 index_y, Sint32 first_x, Sint32 last_x, SDL_bool is_backward);
+static SDL_bool get_cell_range(const SDL_Rect* rect, SDL_Rect* range, core_t* core);
+static Sint32   sweep_x(const SDL_Rect* box, Sint32 delta, Uint32* hit, core_t* core);
+static Sint32   sweep_y(const SDL_Rect* box, Sint32 delta, Uint32* hit, core_t* core);
+
+/* Built from the render list and tile flags, so it is the same for
+ * Tiled and compiled maps.  Layers are walked one after another to
+ * read their tiles in order.
+ */
+status_t load_collision_grid(core_t* core)
+{
+    map_t*            map  = core->map;
+    render_list_t*    list = &map->render_list;
+    collision_grid_t* grid = &map->collision;
+    Sint32            layer_index;
+    Sint32            index_x;
+    Sint32            index_y;
+
+    grid->width  = list->width;
+    grid->height = list->height;
+    grid->pitch  = (list->width + COLLISION_WORD_BITS - 1) / COLLISION_WORD_BITS;
+
+    // Streamed maps are never resident as a whole, see stream.h.
+    if (0 >= grid->width || 0 >= grid->height || ! map->tile_properties || list->stream)
+    {
+        return CORE_OK;
+    }
+
+    grid->word = (Uint32*)arena_calloc(map->arena, (size_t)grid->pitch * (size_t)grid->height, sizeof(Uint32));
+    if (! grid->word)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+    {
+        const Uint16* layer_tile = &list->layer_tile[layer_index * list->width * list->height];
+
+        for (index_y = 0; index_y < grid->height; index_y += 1)
+        {
+            Uint32* row = &grid->word[index_y * grid->pitch];
+
+            for (index_x = 0; index_x < grid->width; index_x += 1)
+            {
+                if (map->tile_properties[layer_tile[(index_y * list->width) + index_x]] & TILE_FLAG_SOLID)
+                {
+                    row[index_x / COLLISION_WORD_BITS] |= 1u << (index_x % COLLISION_WORD_BITS);
+                }
+            }
+        }
+    }
+
+    return CORE_OK;
+}
+
+// Derive a range of cells from their tiles again.
+void update_collision_cells(const SDL_Rect* range, core_t* core)
+{
+    collision_grid_t* grid = &core->map->collision;
+    Sint32            first_x;
+    Sint32            first_y;
+    Sint32            last_x;
+    Sint32            last_y;
+    Sint32            index_x;
+    Sint32            index_y;
+
+    if (! grid->word)
+    {
+        return;
+    }
+
+    first_x = SDL_max(range->x, 0);
+    first_y = SDL_max(range->y, 0);
+    last_x  = SDL_min(range->x + range->w, grid->width);
+    last_y  = SDL_min(range->y + range->h, grid->height);
+
+    for (index_y = first_y; index_y < last_y; index_y += 1)
+    {
+        Uint32* row = &grid->word[index_y * grid->pitch];
+
+        for (index_x = first_x; index_x < last_x; index_x += 1)
+        {
+            Uint32 bit = 1u << (index_x % COLLISION_WORD_BITS);
+
+            if (get_cell_flags(index_x, index_y, core) & TILE_FLAG_SOLID)
+            {
+                row[index_x / COLLISION_WORD_BITS] |= bit;
+            }
+            else
+            {
+                row[index_x / COLLISION_WORD_BITS] &= ~bit;
+            }
+        }
+    }
+}
+
+SDL_bool is_solid_at(Sint32 pos_x, Sint32 pos_y, core_t* core)
+{
+    collision_grid_t* grid = &core->map->collision;
+    render_list_t*    list = &core->map->render_list;
+    Sint32            index_x;
+    Sint32            index_y;
+
+    pos_x -= core->map->pos_x;
+    pos_y -= core->map->pos_y;
+
+    if (! grid->word || 0 > pos_x || 0 > pos_y)
+    {
+        return SDL_FALSE;
+    }
+
+    index_x = pos_x / list->tile_width;
+    index_y = pos_y / list->tile_height;
+
+    if (index_x >= grid->width || index_y >= grid->height)
+    {
+        return SDL_FALSE;
+    }
+
+    return (grid->word[(index_y * grid->pitch) + (index_x / COLLISION_WORD_BITS)] >> (index_x % COLLISION_WORD_BITS)) & 1u ? SDL_TRUE : SDL_FALSE;
+}
+
+SDL_bool is_rect_solid(const SDL_Rect* rect, core_t* core)
+{
+    collision_grid_t* grid = &core->map->collision;
+    SDL_Rect          range;
+    Sint32            index_y;
+
+    if (! grid->word || ! get_cell_range(rect, &range, core))
+    {
+        return SDL_FALSE;
+    }
+
+    for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+    {
+        if (0 <= find_solid_cell(grid, index_y, range.x, range.x + range.w - 1, SDL_FALSE))
+        {
+            return SDL_TRUE;
+        }
+    }
+
+    return SDL_FALSE;
+}
+
+Uint32 sweep_rect(const SDL_Rect* rect, SDL_Point* delta, core_t* core)
+{
+    SDL_Rect box = *rect;
+    Uint32   hit = 0;
+
+    if (! core->map->collision.word || 0 >= box.w || 0 >= box.h)
+    {
+        return 0;
+    }
+
+    box.x -= core->map->pos_x;
+    box.y -= core->map->pos_y;
+
+    if (0 != delta->x)
+    {
+        delta->x  = sweep_x(&box, delta->x, &hit, core);
+        box.x    += delta->x;
+    }
+
+    if (0 != delta->y)
+    {
+        delta->y = sweep_y(&box, delta->y, &hit, core);
+    }
+
+    return hit;
+}
+
+/* Walk the rows the segment crosses.  Within a row, the segment covers
+ * a single span of cells, which is tested a word at a time; the first
+ * solid cell in the direction of the ray is where it hits.
+ */
+SDL_bool cast_ray(const SDL_Point* from, const SDL_Point* to, SDL_Point* hit, core_t* core)
+{
+    collision_grid_t* grid        = &core->map->collision;
+    render_list_t*    list        = &core->map->render_list;
+    Sint32            from_x      = from->x - core->map->pos_x;
+    Sint32            from_y      = from->y - core->map->pos_y;
+    Sint32            delta_x     = to->x - from->x;
+    Sint32            delta_y     = to->y - from->y;
+    SDL_bool          is_backward = (0 > delta_x) ? SDL_TRUE : SDL_FALSE;
+    Sint32            first_row   = get_cell_index(from_y, list->tile_height);
+    Sint32            last_row    = get_cell_index(from_y + delta_y, list->tile_height);
+    Sint32            step        = (0 > delta_y) ? -1 : 1;
+    Sint32            index_y;
+
+    if (! grid->word)
+    {
+        return SDL_FALSE;
+    }
+
+    // Skip the rows outside of the map.
+    if (0 < step)
+    {
+        first_row = SDL_max(first_row, 0);
+        last_row  = SDL_min(last_row, grid->height - 1);
+    }
+    else
+    {
+        first_row = SDL_min(first_row, grid->height - 1);
+        last_row  = SDL_max(last_row, 0);
+    }
+
+    if ((last_row - first_row) * step < 0)
+    {
+        return SDL_FALSE;
+    }
+
+    for (index_y = first_row; ; index_y += step)
+    {
+        Sint32 enter_y = from_y;
+        Sint32 leave_y = from_y;
+        Sint32 enter_x = from_x;
+        Sint32 leave_x = from_x + delta_x;
+        Sint32 first_x;
+        Sint32 last_x;
+        Sint32 index_x;
+
+        // Part of the segment within the row.
+        if (0 != delta_y)
+        {
+            Sint32 top    = index_y * list->tile_height;
+            Sint32 bottom = top + list->tile_height - 1;
+
+            enter_y = (0 < step) ? SDL_max(from_y, top)              : SDL_min(from_y, bottom);
+            leave_y = (0 < step) ? SDL_min(from_y + delta_y, bottom) : SDL_max(from_y + delta_y, top);
+            enter_x = from_x + (Sint32)(((Sint64)(enter_y - from_y) * delta_x) / delta_y);
+            leave_x = from_x + (Sint32)(((Sint64)(leave_y - from_y) * delta_x) / delta_y);
+        }
+
+        first_x = get_cell_index(SDL_min(enter_x, leave_x), list->tile_width);
+        last_x  = get_cell_index(SDL_max(enter_x, leave_x), list->tile_width);
+        first_x = SDL_max(first_x, 0);
+        last_x  = SDL_min(last_x, grid->width - 1);
+
+        if (first_x <= last_x)
+        {
+            index_x = find_solid_cell(grid, index_y, first_x, last_x, is_backward);
+
+            if (0 <= index_x)
+            {
+                // Entered from the row above or below, or from the side.
+                if (index_x == get_cell_index(enter_x, list->tile_width))
+                {
+                    hit->x = enter_x;
+                    hit->y = enter_y;
+                }
+                else
+                {
+                    hit->x = index_x * list->tile_width;
+                    if (is_backward)
+                    {
+                        hit->x += list->tile_width - 1;
+                    }
+                    hit->y = from_y + (Sint32)(((Sint64)(hit->x - from_x) * delta_y) / delta_x);
+                    hit->y = SDL_clamp(hit->y, SDL_min(enter_y, leave_y), SDL_max(enter_y, leave_y));
+                }
+
+                hit->x += core->map->pos_x;
+                hit->y += core->map->pos_y;
+
+                return SDL_TRUE;
+            }
+        }
+
+        if (index_y == last_row)
+        {
+            break;
+        }
+    }
+
+    return SDL_FALSE;
+}
+
+// Cell of a position, rounding down for positions left of or above the map.
+static Sint32 get_cell_index(Sint32 pos, Sint32 size)
+{
+    if (0 > pos)
+    {
+        return ((pos + 1) / size) - 1;
+    }
+    return pos / size;
+}
+
+/* Index of the first solid cell of a row between first_x and last_x,
+ * both included and inside of the map, or of the last one if
+ * is_backward is set.  Returns -1 if there is none.
+ */
+static Sint32 find_solid_cell(const collision_grid_t* grid, Sint32 index_y, Sint32 first_x, Sint32 last_x, SDL_bool is_backward)
+{
+    const Uint32* row        = &grid->word[index_y * grid->pitch];
+    Sint32        first_word = first_x / COLLISION_WORD_BITS;
+    Sint32        last_word  = last_x  / COLLISION_WORD_BITS;
+    Sint32        index      = is_backward ? last_word : first_word;
+    Sint32        step       = is_backward ? -1 : 1;
+
+    for (;;)
+    {
+        Uint32 word = row[index];
+
+        if (index == first_word)
+        {
+            word &= 0xffffffffu << (first_x % COLLISION_WORD_BITS);
+        }
+        if (index == last_word)
+        {
+            word &= 0xffffffffu >> (COLLISION_WORD_BITS - 1 - (last_x % COLLISION_WORD_BITS));
+        }
+
+        if (0 != word)
+        {
+            if (! is_backward)
+            {
+                word &= ~word + 1; // Lowest bit only.
+            }
+            return (index * COLLISION_WORD_BITS) + SDL_MostSignificantBitIndex32(word);
+        }
+
+        if (index == (is_backward ? first_word : last_word))
+        {
+            return -1;
+        }
+        index += step;
+    }
+}
+
+// Cells overlapped by a rectangle in world pixels, clipped to the map.
+static SDL_bool get_cell_range(const SDL_Rect* rect, SDL_Rect* range, core_t* core)
+{
+    collision_grid_t* grid = &core->map->collision;
+    render_list_t*    list = &core->map->render_list;
+    Sint32            first_x;
+    Sint32            first_y;
+    Sint32            last_x;
+    Sint32            last_y;
+
+    if (0 >= rect->w || 0 >= rect->h)
+    {
+        return SDL_FALSE;
+    }
+
+    first_x = SDL_max(get_cell_index(rect->x - core->map->pos_x, list->tile_width), 0);
+    first_y = SDL_max(get_cell_index(rect->y - core->map->pos_y, list->tile_height), 0);
+    last_x  = SDL_min(get_cell_index(rect->x - core->map->pos_x + rect->w - 1, list->tile_width),  grid->width  - 1);
+    last_y  = SDL_min(get_cell_index(rect->y - core->map->pos_y + rect->h - 1, list->tile_height), grid->height - 1);
+
+    if (first_x > last_x || first_y > last_y)
+    {
+        return SDL_FALSE;
+    }
+
+    range->x = first_x;
+    range->y = first_y;
+    range->w = last_x - first_x + 1;
+    range->h = last_y - first_y + 1;
+
+    return SDL_TRUE;
+}
+
+/* Move a box in map pixels along x: the columns its leading edge
+ * enters are searched in every row it spans, and the nearest solid
+ * cell, or the map border, limits the distance.
+ */
+static Sint32 sweep_x(const SDL_Rect* box, Sint32 delta, Uint32* hit, core_t* core)
+{
+    collision_grid_t* grid      = &core->map->collision;
+    render_list_t*    list      = &core->map->render_list;
+    Sint32            first_row = SDL_max(get_cell_index(box->y, list->tile_height), 0);
+    Sint32            last_row  = SDL_min(get_cell_index(box->y + box->h - 1, list->tile_height), grid->height - 1);
+    Sint32            edge;
+    Sint32            target;
+    Sint32            stop;
+    Sint32            index_y;
+
+    if (0 < delta)
+    {
+        edge   = box->x + box->w - 1;
+        target = get_cell_index(edge + delta, list->tile_width);
+        stop   = SDL_min(target + 1, grid->width); // No stop before target + 1.
+
+        for (index_y = first_row; index_y <= last_row; index_y += 1)
+        {
+            Sint32 first_x = SDL_max(get_cell_index(edge, list->tile_width) + 1, 0);
+            Sint32 index_x;
+
+            if (first_x > stop - 1)
+            {
+                break;
+            }
+
+            index_x = find_solid_cell(grid, index_y, first_x, stop - 1, SDL_FALSE);
+            if (0 <= index_x)
+            {
+                stop = index_x;
+            }
+        }
+
+        if (stop <= target)
+        {
+            *hit  |= COLLISION_HIT_X;
+            delta  = SDL_max((stop * list->tile_width) - 1 - edge, 0);
+        }
+    }
+    else
+    {
+        edge   = box->x;
+        target = get_cell_index(edge + delta, list->tile_width);
+        stop   = SDL_max(target - 1, -1);
+
+        for (index_y = first_row; index_y <= last_row; index_y += 1)
+        {
+            Sint32 last_x = SDL_min(get_cell_index(edge, list->tile_width) - 1, grid->width - 1);
+            Sint32 index_x;
+
+            if (last_x < stop + 1)
+            {
+                break;
+            }
+
+            index_x = find_solid_cell(grid, index_y, stop + 1, last_x, SDL_TRUE);
+            if (0 <= index_x)
+            {
+                stop = index_x;
+            }
+        }
+
+        if (stop >= target)
+        {
+            *hit  |= COLLISION_HIT_X;
+            delta  = SDL_min(((stop + 1) * list->tile_width) - edge, 0);
+        }
+    }
+
+    return delta;
+}
+
+/* Move a box in map pixels along y: the rows its leading edge enters
+ * are tested in turn, each over the columns the box spans.
+ */
+static Sint32 sweep_y(const SDL_Rect* box, Sint32 delta, Uint32* hit, core_t* core)
+{
+    collision_grid_t* grid    = &core->map->collision;
+    render_list_t*    list    = &core->map->render_list;
+    Sint32            first_x = SDL_max(get_cell_index(box->x, list->tile_width), 0);
+    Sint32            last_x  = SDL_min(get_cell_index(box->x + box->w - 1, list->tile_width), grid->width - 1);
+    Sint32            edge;
+    Sint32            target;
+    Sint32            stop;
+    Sint32            index_y;
+
+    if (0 < delta)
+    {
+        edge   = box->y + box->h - 1;
+        target = get_cell_index(edge + delta, list->tile_height);
+        stop   = SDL_min(target + 1, grid->height);
+
+        for (index_y = SDL_max(get_cell_index(edge, list->tile_height) + 1, 0); index_y < stop && first_x <= last_x; index_y += 1)
+        {
+            if (0 <= find_solid_cell(grid, index_y, first_x, last_x, SDL_FALSE))
+            {
+                stop = index_y;
+            }
+        }
+
+        if (stop <= target)
+        {
+            *hit  |= COLLISION_HIT_Y;
+            delta  = SDL_max((stop * list->tile_height) - 1 - edge, 0);
+        }
+    }
+    else
+    {
+        edge   = box->y;
+        target = get_cell_index(edge + delta, list->tile_height);
+        stop   = SDL_max(target - 1, -1);
+
+        for (index_y = SDL_min(get_cell_index(edge, list->tile_height) - 1, grid->height - 1); index_y > stop && first_x <= last_x; index_y -= 1)
+        {
+            if (0 <= find_solid_cell(grid, index_y, first_x, last_x, SDL_FALSE))
+            {
+                stop = index_y;
+            }
+        }
+
+        if (stop >= target)
+        {
+            *hit  |= COLLISION_HIT_Y;
+            delta  = SDL_min(((stop + 1) * list->tile_height) - edge, 0);
+        }
+    }
+
+    return delta;
+}
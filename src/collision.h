@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Collision bitgrid of the map.
+ *
+ * A cell is solid if a tile of any layer has the is_solid flag, see
+ * tile_flag.h.  The grid holds one bit per cell, rows padded to whole
+ * words, so that a query tests up to COLLISION_WORD_BITS cells of a
+ * row with a single mask instead of one tile at a time.
+ *
+ * Queries take world positions in pixels, like those of tile_flag.h.
+ * The area outside of the map is solid for sweeps, so entities cannot
+ * leave the map, while rays are clipped to the map.  After tiles have
+ * changed, call update_collision_cells.  Streamed maps, see stream.h,
+ * have no grid: nothing is solid.
+ *
+ * sweep_rect moves a rectangle by delta, along x first and then along
+ * y, and shortens delta to where it stops in front of a solid cell.
+ * Cells the rectangle already overlaps do not stop it.  It returns
+ * the axes it was stopped on, as COLLISION_HIT_X and COLLISION_HIT_Y.
+ *
+ * cast_ray returns whether the segment from from to to enters a solid
+ * cell and, if so, the first position inside of it in hit.
+ */
+
+#define COLLISION_WORD_BITS 32
+#define COLLISION_HIT_X     0x00000001
+#define COLLISION_HIT_Y     0x00000002
+
+status_t load_collision_grid(core_t* core);
+void     update_collision_cells(const SDL_Rect* range, core_t* core);
+SDL_bool is_solid_at(Sint32 pos_x, Sint32 pos_y, core_t* core);
+SDL_bool is_rect_solid(const SDL_Rect* rect, core_t* core);
+Uint32   sweep_rect(const SDL_Rect* rect, SDL_Point* delta, core_t* core);
+SDL_bool cast_ray(const SDL_Point* from, const SDL_Point* to, SDL_Point* hit, core_t* core);
+
+#endif /* COLLISION_H */
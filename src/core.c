@@ -1,11 +1,49 @@
 // Spdx-License-Identifier: MIT
 
 #include <SDL.h>
+#include "animation.h"
+#include "arena.h"
+#include "blit.h"
+#include "cache.h"
+#include "chunk.h"
+#include "collision.h"
 #include "core.h"
+#include "input.h"
+#include "job.h"
+#include "map_blob.h"
+#include "object.h"
+#include "path.h"
+#include "profile.h"
+#include "property.h"
+#include "render_list.h"
+#include "stream.h"
+#include "tile_flag.h"
+#include "tiled.h"
+#include "tileset.h"
+
+// Mark the scene for rendering in the next frame.
+void request_redraw(Uint32 change, core_t* core)
+{
+    core->render_change |= change;
+}
+
+static map_t*   find_cached_map(const char* file_name, core_t* core);
+static void     set_map(map_t* map, core_t* core);
+static size_t   get_map_size(core_t* core);
+static status_t load_map_data(const char* file_name, core_t* core);
+static void     destroy_map(core_t* core);
+static void     log_map_memory(core_t* core);
+static int      load_map_thread(void* data);
+static void     update_map_loader(core_t* core);
+static void     free_map_loader(core_t* core);
+static void     init_frame_timer(core_t* core);
+static void     update_simulation(core_t* core);
+static void     limit_frame_rate(core_t* core);
 
 status_t init_core(const char* title, core_t** core)
 {
-    status_t status = CORE_OK;
+    status_t         status = CORE_OK;
+    SDL_RendererInfo info;
 
     *core = (core_t*)calloc(1, sizeof(struct core));
     if (NULL == *core)
@@ -47,91 +85,172 @@ status_t init_core(const char* title, core_t** core)
         status = CORE_WARNING;
     }
 
-    (*core)->is_active = SDL_TRUE;
+    (*core)->is_active                = SDL_TRUE;
+    if (0 == SDL_GetRendererInfo((*core)->renderer, &info))
+    {
+        (*core)->max_texture_size.x = info.max_texture_width;
+        (*core)->max_texture_size.y = info.max_texture_height;
+    }
+    if (0 >= (*core)->max_texture_size.x || 0 >= (*core)->max_texture_size.y)
+    {
+        (*core)->max_texture_size.x = 4096;
+        (*core)->max_texture_size.y = 4096;
+    }
+
+    if (CORE_OK != init_tmx_allocator())
+    {
+        dbgprint("TMX maps are parsed into the heap.");
+        status = CORE_WARNING;
+    }
+
+    if (CORE_OK != init_cache(*core))
+    {
+        dbgprint("Map and resource cache disabled.");
+        status = CORE_WARNING;
+    }
+
+    if (CORE_OK != init_job_system(JOB_THREAD_AUTO, *core))
+    {
+        dbgprint("Jobs run on the calling thread only.");
+        status = CORE_WARNING;
+    }
+
+#ifdef PROFILE_ENABLED
+    if (CORE_OK != init_profiler(*core))
+    {
+        dbgprint("Profiler disabled.");
+        status = CORE_WARNING;
+    }
+#endif
+
+    init_frame_timer(*core);
+    request_redraw(RENDER_CHANGE_ALL, *core);
+
+    (*core)->is_tileset_atlas_enabled    = SDL_TRUE;
+    (*core)->is_tile_blitter_enabled     = SDL_TRUE;
+    (*core)->is_progressive_bake_enabled = SDL_TRUE;
+    (*core)->bake_budget_us              = CHUNK_BAKE_BUDGET_US;
+    (*core)->stream_radius               = STREAM_RADIUS;
+    (*core)->stream_budget               = STREAM_BUDGET;
+#ifdef TILE_BATCH_SUPPORTED
+    (*core)->is_tile_batch_enabled       = SDL_TRUE;
+#endif
 
     return status;
 }
 
 status_t update_core(core_t* core)
 {
-    status_t  status     = CORE_OK;
-    SDL_Event event;
-    Uint32    delta_time = 0;
+    frame_timer_t* timer  = &core->timer;
+    status_t       status = CORE_OK;
+    Uint64         now    = SDL_GetPerformanceCounter();
+    Uint64         simulated_ms;
+    Sint32         step_index;
 
-    (void)core;
+    PROFILE_BEGIN_FRAME(core);
 
-    if (SDL_PollEvent(&event))
-    {
-        switch (event.key.keysym.sym)
-        {
-            case SDLK_BACKSPACE:
-                status = CORE_EXIT;
-                goto exit;
-            case SDLK_UP:
-                core->camera.pos_y -= 10;
-                break;
-            case SDLK_DOWN:
-                core->camera.pos_y += 10;
-                break;
-            case SDLK_LEFT:
-                core->camera.pos_x -= 10;
-                break;
-            case SDLK_RIGHT:
-                core->camera.pos_x += 10;
-                break;
-            default:
-                break;
-        }
-    }
+    // [1] Time elapsed since the previous frame, input and maps loaded in the background.
+    timer->accumulator += now - timer->frame_start;
+    timer->frame_start  = now;
 
-    if (core->camera.pos_x <= 0)
-    {
-        core->camera.pos_x = 0;
-    }
-    if (core->camera.pos_x >= core->map->width - 176)
+    update_map_loader(core);
+
+    status = update_input(core);
+    if (CORE_OK != status || is_input_pressed(INPUT_BACK, core))
     {
-        core->camera.pos_x = core->map->width - 176;
+        status = CORE_EXIT;
+        goto exit;
     }
-    if (core->camera.pos_y <= 0)
+
+    // [2] Fixed simulation steps, dropping time when too far behind.
+    simulated_ms = (timer->step_count * 1000) / CORE_STEP_RATE;
+
+    for (step_index = 0; step_index < CORE_MAX_STEPS && timer->accumulator >= timer->step_ticks; step_index += 1)
     {
-        core->camera.pos_y = 0;
+        update_simulation(core);
+        timer->accumulator -= timer->step_ticks;
+        timer->step_count  += 1;
     }
-    if (core->camera.pos_y >= core->map->height - 208)
+
+    if (timer->accumulator >= timer->step_ticks)
     {
-        core->camera.pos_y = core->map->height - 208;
+        timer->dropped_step_count += timer->accumulator / timer->step_ticks;
+        timer->accumulator        %= timer->step_ticks;
     }
 
-    core->time_b = core->time_a;
-    core->time_a = SDL_GetTicks();
+    core->time_since_last_frame = (Uint32)(((timer->step_count * 1000) / CORE_STEP_RATE) - simulated_ms);
+    timer->alpha                = (Sint32)((timer->accumulator * 256) / timer->step_ticks);
+
+    // [3] Render from the interpolated camera position, if anything changed.
+    core->camera.view_x = core->camera.prev_pos_x + (((core->camera.pos_x - core->camera.prev_pos_x) * timer->alpha) / 256);
+    core->camera.view_y = core->camera.prev_pos_y + (((core->camera.pos_y - core->camera.prev_pos_y) * timer->alpha) / 256);
 
-    if (core->time_a > core->time_b)
+    if (core->camera.view_x != core->camera.last_view_x || core->camera.view_y != core->camera.last_view_y)
     {
-        core->time_a = core->time_b;
+        request_redraw(RENDER_CHANGE_CAMERA, core);
     }
 
-    delta_time                   = (Uint32)(core->time_b - core->time_a) / 1000;
-    core->time_since_last_frame  = 17 - delta_time;
+    // Streamed chunks around the view are read, and animated tiles patched into the resident chunks before they get composited.
+    if (is_map_loaded(core))
+    {
+        update_stream(core);
 
-    // Delay? Probably not.
+        PROFILE_BEGIN(PROFILE_ANIMATION, core);
+        status = update_animated_tiles(core);
+        PROFILE_END(PROFILE_ANIMATION, core);
+        if (CORE_OK != status)
+        {
+            goto exit;
+        }
+    }
 
-    if (! is_map_loaded(core))
+    if (RENDER_CHANGE_NONE == core->render_change)
     {
-        return;
+        core->skipped_frame_count += 1;
     }
-
-    status = render_scene(core);
-    if (CORE_OK != status)
+    else
     {
-        goto exit;
+        // Changes requested while rendering, e.g. pending chunk bakes, carry over to the next frame.
+        core->render_change = RENDER_CHANGE_NONE;
+
+        if (is_map_loaded(core))
+        {
+            PROFILE_BEGIN(PROFILE_RENDER_SCENE, core);
+            status = render_scene(core);
+            PROFILE_END(PROFILE_RENDER_SCENE, core);
+            if (CORE_OK != status)
+            {
+                goto exit;
+            }
+        }
+        PROFILE_BEGIN(PROFILE_DRAW_SCENE, core);
+        status = draw_scene(core);
+        PROFILE_END(PROFILE_DRAW_SCENE, core);
+
+        core->camera.last_view_x = core->camera.view_x;
+        core->camera.last_view_y = core->camera.view_y;
     }
-    status = draw_scene(core);
+
+    // [4] Sleep off the rest of the frame.
+    PROFILE_END_FRAME(core);
+    limit_frame_rate(core);
+
+    return status;
 
 exit:
+    PROFILE_END_FRAME(core);
     return status;
 }
 
 void free_core(core_t *core)
 {
+    free_map_loader(core);
+    free_job_system(core);
+    free_cache(core);
+#ifdef PROFILE_ENABLED
+    free_profiler(core);
+#endif
+
     if (core->window)
     {
         SDL_DestroyWindow(core->window);
@@ -153,7 +272,7 @@ void free_core(core_t *core)
 
 status_t load_map(const char* file_name, core_t* core)
 {
-    char* tileset_image_source = NULL;
+    map_t* map;
 
     if (is_map_loaded(core))
     {
@@ -161,18 +280,136 @@ status_t load_map(const char* file_name, core_t* core)
         return CORE_WARNING;
     }
 
+    map = find_cached_map(file_name, core);
+    if (map)
+    {
+        set_map(map, core);
+        return CORE_OK;
+    }
+
+    if (CORE_OK != load_map_data(file_name, core))
+    {
+        return CORE_WARNING;
+    }
+
+    if (CORE_OK != upload_tileset_textures(core))
+    {
+        unload_map(core);
+        return CORE_WARNING;
+    }
+
+    request_redraw(RENDER_CHANGE_ALL, core);
+
+    return CORE_OK;
+}
+
+/* Start loading a map on a background thread.  The current map, if
+ * any, keeps being updated and rendered until the new one is ready and
+ * gets swapped in by update_core.
+ */
+status_t load_map_async(const char* file_name, core_t* core)
+{
+    map_loader_t* loader = &core->loader;
+    map_t*        map;
+
+    if (loader->thread)
+    {
+        dbgprint("A map is already being loaded.");
+        return CORE_WARNING;
+    }
+
+    // Cached maps are ready right away.
+    map = find_cached_map(file_name, core);
+    if (map)
+    {
+        if (is_map_loaded(core))
+        {
+            unload_map(core);
+        }
+        set_map(map, core);
+        return CORE_OK;
+    }
+
+    loader->staging   = (core_t*)calloc(1, sizeof(struct core));
+    loader->file_name = SDL_strdup(file_name);
+    if (! loader->staging || ! loader->file_name)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        free_map_loader(core);
+        return CORE_WARNING;
+    }
+
+    // The staging core shares renderer and settings, but not the map.
+    *loader->staging               = *core;
+    loader->staging->map           = NULL;
+    loader->staging->is_map_loaded = SDL_FALSE;
+    SDL_zero(loader->staging->loader);
+#ifdef PROFILE_ENABLED
+    loader->staging->profiler      = NULL;
+#endif
+
+    SDL_AtomicSet(&loader->is_done, 0);
+    loader->status = CORE_OK;
+    loader->thread = SDL_CreateThread(load_map_thread, "map_loader", loader);
+    if (! loader->thread)
+    {
+        dbgprint("Could not create thread: %s", SDL_GetError());
+        free_map_loader(core);
+        return CORE_WARNING;
+    }
+
+    return CORE_OK;
+}
+
+SDL_bool is_map_loading(core_t* core)
+{
+    return core->loader.thread ? SDL_TRUE : SDL_FALSE;
+}
+
+/* Everything up to texture creation, which does not touch the renderer
+ * and may run on the map loader thread.
+ */
+static status_t load_map_data(const char* file_name, core_t* core)
+{
+    arena_t* arena;
+    char*    key;
+    Sint32   index;
+
     // Load map file and allocate required memory.
 
-    // [1] Map.
-    core->map = (map_t*)calloc(1, sizeof(struct map));
-    if (! core->map)
+    // [1] Map, allocated from its arena like everything else it holds.
+    arena = create_arena();
+    if (! arena)
     {
-        dbgprint("%s: error allocating memory.", __FUNCTION__);
         return CORE_WARNING;
     }
 
-    // [2] Tiled map.
-    if (CORE_OK != load_tiled_map(file_name, core))
+    core->map = (map_t*)arena_calloc(arena, 1, sizeof(struct map));
+    key       = get_cache_key(file_name);
+    if (core->map && key)
+    {
+        core->map->arena     = arena;
+        core->map->file_name = arena_strdup(arena, key);
+    }
+    free(key);
+
+    if (! core->map || ! core->map->file_name)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        free_arena(arena);
+        core->map = NULL;
+        return CORE_WARNING;
+    }
+
+    // [2] Tiled map or compiled map.
+    if (is_compiled_map(file_name))
+    {
+        if (CORE_OK != open_map_blob(file_name, &core->map->blob))
+        {
+            goto warning;
+        }
+    }
+    else if (CORE_OK != load_tiled_map(file_name, core))
     {
         goto warning;
     }
@@ -184,45 +421,398 @@ status_t load_map(const char* file_name, core_t* core)
         goto warning;
     }
 
-    // [4] Tileset.
-    if (CORE_OK != load_tileset(core))
+    // [4] Tilesets.
+    if (CORE_OK != load_tileset_table(core))
+    {
+        goto warning;
+    }
+
+    if (CORE_OK != load_tileset_images(core))
+    {
+        goto warning;
+    }
+
+    // [5] Properties.
+    if (CORE_OK != load_property_table(core))
+    {
+        goto warning;
+    }
+
+    // [6] Render lists, animated tiles, tile flags, tile blitter, layer chunk caches and tile batch.
+    if (CORE_OK != load_render_list(core))
+    {
+        goto warning;
+    }
+
+    core->map->height = core->map->render_list.height * core->map->render_list.tile_height;
+    core->map->width  = core->map->render_list.width  * core->map->render_list.tile_width;
+
+    if (CORE_OK != load_animated_tiles(core))
+    {
+        goto warning;
+    }
+
+    if (CORE_OK != load_tile_flags(file_name, core))
+    {
+        goto warning;
+    }
+
+    if (CORE_OK != init_tile_blitter(core))
+    {
+        goto warning;
+    }
+
+    for (index = 0; index < MAP_LAYER_MAX; index += 1)
+    {
+        if (CORE_OK != init_chunk_cache(&core->map->chunk_cache[index], core))
+        {
+            goto warning;
+        }
+    }
+
+    if (CORE_OK != init_tile_batch(core))
+    {
+        goto warning;
+    }
+
+    // [7] Objects and their grid.
+    if (CORE_OK != load_objects(core))
+    {
+        goto warning;
+    }
+
+    // [8] Collision grid and path grid.
+    if (CORE_OK != load_collision_grid(core))
+    {
+        goto warning;
+    }
+
+    if (CORE_OK != load_path_grid(core))
     {
         goto warning;
     }
 
-    core->map->height = (Sint32)((Sint32)core->map->handle->height * get_tile_height(core->map->handle));
-    core->map->width  = (Sint32)((Sint32)core->map->handle->width  * get_tile_width(core->map->handle));
+    log_map_memory(core);
 
     return CORE_OK;
 warning:
-    unload_map(core);
+    // Not through unload_map: the map may not count as loaded yet.
+    destroy_map(core);
     return CORE_WARNING;
 }
 
+/* Complete maps are kept in the map cache, without their chunk
+ * textures, until evicted.
+ */
 void unload_map(core_t* core)
 {
+    map_t* map = core->map;
+    Sint32 index;
+
     if (! is_map_loaded(core))
     {
         dbgprint("No map has been loaded.");
         return;
     }
+
+    if (! map->is_complete || ! core->cache)
+    {
+        destroy_map(core);
+        return;
+    }
+
     core->is_map_loaded = SDL_FALSE;
+    request_redraw(RENDER_CHANGE_ALL, core);
+    log_map_memory(core);
 
-    // Free up allocated memory in reverse order.
+    for (index = 0; index < MAP_LAYER_MAX; index += 1)
+    {
+        reset_chunk_cache(&map->chunk_cache[index]);
+    }
+    destroy_render_targets(core);
 
-    // [4] Tileset.
-    if (core->map->tileset_texture)
+    store_cached_map(map, get_map_size(core), core);
+    core->map = NULL;
+
+    trim_cache(core);
+}
+
+// Free a map which is not the current one, e.g. when evicted from the map cache.
+void free_map(map_t* map, core_t* core)
+{
+    core_t owner = *core;
+
+    owner.map           = map;
+    owner.is_map_loaded = SDL_TRUE;
+
+    destroy_map(&owner);
+}
+
+static void destroy_map(core_t* core)
+{
+    Sint32 index;
+
+    core->is_map_loaded = SDL_FALSE;
+    request_redraw(RENDER_CHANGE_ALL, core);
+
+    /* Free up allocated memory in reverse order.  Only what does not
+     * live in the map arena is released step by step: textures,
+     * tileset resources, path graph and the map file.
+     */
+
+    // [8] Path graph and cached paths.
+    free_path_grid(core);
+
+    // [6] Chunk textures and pixels, render targets.
+    for (index = 0; index < MAP_LAYER_MAX; index += 1)
     {
-        SDL_DestroyTexture(core->map->tileset_texture);
-        core->map->tileset_texture = NULL;
+        reset_chunk_cache(&core->map->chunk_cache[index]);
     }
+    destroy_render_targets(core);
 
-    // [3] Paths and file locations.
-    free(core->map->path);
+    // [4] Tilesets.
+    free_tilesets(core);
 
-    // [2] Tiled map.
+    // [2] Tiled map or compiled map.
     unload_tiled_map(core);
+    close_map_blob(&core->map->blob);
+
+    // [1] Map and everything else.
+    free_arena(core->map->arena);
+    core->map = NULL;
+}
+
+static void log_map_memory(core_t* core)
+{
+    arena_stats_t stats;
+
+    get_arena_stats(&stats, core->map->arena);
+    dbgprint("Map %s: %u byte(s) in use, %u peak, %u reserved in %d block(s).",
+             core->map->file_name,
+             (unsigned)stats.byte_count,
+             (unsigned)stats.peak_byte_count,
+             (unsigned)stats.reserved_byte_count,
+             stats.block_count);
+}
+
+void set_frame_rate_cap(Sint32 max_frame_rate, core_t* core)
+{
+    if (0 >= max_frame_rate)
+    {
+        core->timer.frame_ticks = 0;
+        return;
+    }
+    core->timer.frame_ticks = core->timer.frequency / (Uint64)max_frame_rate;
+}
+
+static void init_frame_timer(core_t* core)
+{
+    frame_timer_t* timer = &core->timer;
+
+    timer->frequency   = SDL_GetPerformanceFrequency();
+    timer->step_ticks  = timer->frequency / CORE_STEP_RATE;
+    timer->frame_start = SDL_GetPerformanceCounter();
+
+    set_frame_rate_cap(CORE_MAX_FRAME_RATE, core);
+}
+
+/* One fixed simulation step.  The camera moves while a direction is
+ * held, by the same distance per step whatever the frame rate.
+ */
+static void update_simulation(core_t* core)
+{
+    Sint32 distance = CORE_CAMERA_SPEED / CORE_STEP_RATE;
+
+    core->camera.prev_pos_x = core->camera.pos_x;
+    core->camera.prev_pos_y = core->camera.pos_y;
+
+    if (! is_map_loaded(core))
+    {
+        return;
+    }
+
+    if (is_input_held(INPUT_UP, core))
+    {
+        core->camera.pos_y -= distance;
+    }
+    if (is_input_held(INPUT_DOWN, core))
+    {
+        core->camera.pos_y += distance;
+    }
+    if (is_input_held(INPUT_LEFT, core))
+    {
+        core->camera.pos_x -= distance;
+    }
+    if (is_input_held(INPUT_RIGHT, core))
+    {
+        core->camera.pos_x += distance;
+    }
+
+    if (core->camera.pos_x <= 0)
+    {
+        core->camera.pos_x = 0;
+    }
+    if (core->camera.pos_x >= core->map->width - 176)
+    {
+        core->camera.pos_x = core->map->width - 176;
+    }
+    if (core->camera.pos_y <= 0)
+    {
+        core->camera.pos_y = 0;
+    }
+    if (core->camera.pos_y >= core->map->height - 208)
+    {
+        core->camera.pos_y = core->map->height - 208;
+    }
+}
+
+/* Sleep instead of spinning until the frame has taken at least
+ * frame_ticks.  SDL_Delay has a granularity of 1 ms, so the frame may
+ * end up to 1 ms early.
+ */
+static void limit_frame_rate(core_t* core)
+{
+    frame_timer_t* timer   = &core->timer;
+    Uint64         elapsed = SDL_GetPerformanceCounter() - timer->frame_start;
+
+    if (0 == timer->frame_ticks || elapsed >= timer->frame_ticks)
+    {
+        return;
+    }
+
+    SDL_Delay((Uint32)(((timer->frame_ticks - elapsed) * 1000) / timer->frequency));
+}
+
+// Take a map out of the map cache, if it holds one for this file.
+static map_t* find_cached_map(const char* file_name, core_t* core)
+{
+    map_t* map;
+    char*  key;
+
+    if (! core->cache)
+    {
+        return NULL;
+    }
+
+    key = get_cache_key(file_name);
+    map = take_cached_map(key, core);
+    free(key);
+
+    return map;
+}
+
+static void set_map(map_t* map, core_t* core)
+{
+    core->map           = map;
+    core->is_map_loaded = SDL_TRUE;
+
+    request_redraw(RENDER_CHANGE_ALL, core);
+}
+
+/* Memory held by a map kept in the map cache: its arena, which covers
+ * the libtmx handle too, and its compiled map, if any.
+ */
+static size_t get_map_size(core_t* core)
+{
+    map_t*        map  = core->map;
+    size_t        size = 0;
+    arena_stats_t stats;
+    Sint32        index;
+
+    get_arena_stats(&stats, map->arena);
+    size += stats.reserved_byte_count;
+
+    if (map->blob.data)
+    {
+        size += map->blob.size;
+    }
+
+    for (index = 0; index < MAP_LAYER_MAX; index += 1)
+    {
+        size += get_chunk_cache_size(&map->chunk_cache[index]);
+    }
+
+    return size;
+}
+
+static int load_map_thread(void* data)
+{
+    map_loader_t* loader = (map_loader_t*)data;
+
+    loader->status = load_map_data(loader->file_name, loader->staging);
+    SDL_AtomicSet(&loader->is_done, 1);
+
+    return 0;
+}
+
+/* Once the loader thread is done, upload the tileset textures of the
+ * new map and swap it in between two frames.
+ */
+static void update_map_loader(core_t* core)
+{
+    map_loader_t* loader = &core->loader;
+    core_t*       staging;
+
+    if (! loader->thread || ! SDL_AtomicGet(&loader->is_done))
+    {
+        return;
+    }
+
+    SDL_WaitThread(loader->thread, NULL);
+    loader->thread = NULL;
+    staging        = loader->staging;
+
+    if (CORE_OK != loader->status)
+    {
+        dbgprint("Could not load %s.", loader->file_name);
+        free_map_loader(core);
+        return;
+    }
+
+    if (CORE_OK != upload_tileset_textures(staging))
+    {
+        dbgprint("Could not load %s.", loader->file_name);
+        free_map_loader(core);
+        return;
+    }
+
+    if (is_map_loaded(core))
+    {
+        unload_map(core);
+    }
+
+    set_map(staging->map, core);
+    staging->map           = NULL;
+    staging->is_map_loaded = SDL_FALSE;
+
+    free_map_loader(core);
+}
+
+// Wait for a pending load, if any, and drop whatever it staged.
+static void free_map_loader(core_t* core)
+{
+    map_loader_t* loader = &core->loader;
+
+    if (loader->thread)
+    {
+        SDL_WaitThread(loader->thread, NULL);
+        loader->thread = NULL;
+    }
+
+    if (loader->staging)
+    {
+        if (is_map_loaded(loader->staging))
+        {
+            unload_map(loader->staging);
+        }
+        else if (loader->staging->map)
+        {
+            destroy_map(loader->staging);
+        }
+        free(loader->staging);
+        loader->staging = NULL;
+    }
 
-    // [1] Map.
-    free(core->map);
+    SDL_free(loader->file_name);
+    loader->file_name = NULL;
 }
@@ -14,6 +14,13 @@
 #  endif
 #endif
 
+#if defined(__SYMBIAN32__)
+#  define RES_PREFIX "E:\\"
+#else
+#  define RES_PREFIX ""
+#  define dbgprint   SDL_Log
+#endif
+
 typedef enum
 {
     MAP_LAYER_BG = 0,
@@ -30,67 +37,742 @@ typedef enum
 
 } render_layer;
 
+/* Reasons for the scene to be rendered again.  Frames without any
+ * pending change skip composition and presentation altogether.
+ */
+typedef enum
+{
+    RENDER_CHANGE_NONE      = 0x00,
+    RENDER_CHANGE_CAMERA    = 0x01,
+    RENDER_CHANGE_ANIMATION = 0x02,
+    RENDER_CHANGE_TILE      = 0x04,
+    RENDER_CHANGE_OVERLAY   = 0x08,
+    RENDER_CHANGE_BAKE      = 0x10,
+    RENDER_CHANGE_ALL       = 0xff
+
+} render_change;
+
+typedef struct animation_frame
+{
+    Uint32 tile_id;
+    Uint32 duration;
+
+} animation_frame_t;
+
+typedef struct animation
+{
+    const animation_frame_t* frame;
+    Sint32                   gid;
+    Sint32                   animation_length;
+    Sint32                   current_frame;
+    Sint32                   id;
+    Uint32                   next_change; // Simulated time of the next frame, in ms.
+    SDL_bool                 has_changed;
+
+} animation_t;
+
+// A cell showing at least one animated tile, on any layer.
 typedef struct animated_tile
 {
-    Sint32 dst_x;
-    Sint32 dst_y;
-    Sint32 animation_length;
-    Sint32 current_frame;
-    Sint32 gid;
-    Sint32 id;
+    Sint32 index_x;
+    Sint32 index_y;
+    Uint32 patch_tick; // Tick it was last patched in.
 
 } animated_tile_t;
 
+/* Baked map layers are split into square chunks of CHUNK_SIZE x
+ * CHUNK_SIZE tiles.  Only the chunks intersecting the camera are kept
+ * in a small ring of textures, so texture memory depends on the size
+ * of the viewport instead of the size of the map.
+ *
+ * Chunks are baked progressively: each frame bakes the chunks closest
+ * to the center of the view until CHUNK_BAKE_BUDGET_US have passed,
+ * but at least one.  Chunks that are not baked yet are drawn directly
+ * from the tilesets, so a frame never waits for the whole view to be
+ * baked.
+ */
+#define CHUNK_SIZE           8
+#define CHUNK_BAKE_BUDGET_US 4000
+
+typedef struct chunk
+{
+    SDL_Texture* texture;
+    Uint16*      pixels; // Composited chunk, with the tile blitter.
+    Sint32       index_x;
+    Sint32       index_y;
+    SDL_bool     is_baked;
+
+} chunk_t;
+
+typedef struct chunk_cache
+{
+    chunk_t*     chunk;
+    Sint32       ring_width;
+    Sint32       ring_height;
+    Sint32       chunk_width;
+    Sint32       chunk_height;
+    Sint32       chunk_count_x;
+    Sint32       chunk_count_y;
+    Uint32       bake_count;
+    Uint32       direct_draw_count;
+
+} chunk_cache_t;
+
+/* Chunks are baked with one SDL_RenderGeometry call per run of tiles
+ * sharing a source texture instead of one SDL_RenderCopy per tile,
+ * i.e. with a single call per chunk when the tilesets are packed into
+ * an atlas.  The buffers hold the quads of the largest chunk; colors
+ * and indices never change and are set up once.
+ */
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#  define TILE_BATCH_SUPPORTED
+#endif
+
+#ifdef TILE_BATCH_SUPPORTED
+typedef struct tile_batch
+{
+    SDL_Vertex*  vertex;
+    int*         index;
+    SDL_Texture* texture;
+    float        texel_width;
+    float        texel_height;
+    Sint32       quad_count;
+    Sint32       quad_max;
+
+} tile_batch_t;
+#endif
+
+/* Tileset images and per-gid opacity for the direct tile blitter, see
+ * blit.h.
+ */
+typedef struct tile_blitter
+{
+    Uint16**   pixels;
+    SDL_Point* size;
+    Uint8*     is_opaque;
+    Sint32     tileset_count;
+    SDL_bool   is_ready;
+
+} tile_blitter_t;
+
+/* A texture shared between maps through the resource cache, keyed by
+ * the resolved path of its image or, for an atlas, the paths of all
+ * images packed into it.  Each image has its position in the texture
+ * and, with the tile blitter, its pixels.  Resources are reference
+ * counted; unused ones stay cached until evicted, see cache.h.
+ */
+typedef struct resource
+{
+    struct resource* next;
+    char*            key;
+    SDL_Texture*     texture;
+    SDL_Point*       offset;
+    SDL_Point*       size;
+    Uint16**         pixels;
+    Sint32           image_count;
+    Sint32           ref_count;
+    size_t           byte_count;
+    Uint32           last_use;
+    SDL_bool         is_cached;
+
+} resource_t;
+
+/* One entry per tileset of the map.  The render list maps every gid
+ * to its tileset in constant time.  The image of a tileset is image
+ * in resource; when the tileset images are packed into a single atlas,
+ * every tileset shares map->atlas and offset is the position of its
+ * image inside of the atlas.
+ */
+typedef struct tileset
+{
+    SDL_Texture* texture;
+    SDL_Surface* surface; // Decoded image, until uploaded.
+    resource_t*  resource;
+    Sint32       image;
+    Sint32       first_gid;
+    Sint32       tile_count;
+    SDL_Point    offset;
+
+} tileset_t;
+
+/* Load-time compiled form of the tile layers.  Each visible tile
+ * layer is stored as a dense grid of 16-bit gids and, for rendering,
+ * as a flat list of non-empty cells sorted by chunk and layer, so
+ * that baking a chunk is a linear walk over cell_offset[chunk] up to
+ * cell_offset[chunk + 1].  position holds the position of each gid
+ * in its tileset image, gid_tileset the index of its tileset and src
+ * the source position currently shown for each gid in the texture it
+ * is drawn from, which is rewritten by tile animations.
+ */
+typedef struct render_cell
+{
+    Uint8  pos_x;
+    Uint8  pos_y;
+    Uint16 gid;
+
+} render_cell_t;
+
+typedef struct render_list
+{
+    Uint16*        layer_tile;
+    render_cell_t* cell;
+    Uint32*        cell_offset;
+    SDL_Point*     position;
+    SDL_Point*     src;
+    Uint8*         gid_tileset;
+    Sint32         layer_count;
+    Sint32         gid_count;
+    Sint32         width;
+    Sint32         height;
+    Sint32         tile_width;
+    Sint32         tile_height;
+    Sint32         chunk_count_x;
+    Sint32         chunk_count_y;
+    struct stream* stream; // Streamed maps only, see stream.h.
+    SDL_bool       is_in_place;
+
+} render_list_t;
+
+/* A compiled map blob, either memory mapped or read into a single
+ * buffer.  See map_blob.h for the format.
+ */
+typedef struct map_blob
+{
+    const struct map_blob_header* header;
+    void*                         data;
+    size_t                        size;
+    SDL_RWops*                    file;        // Kept open to read chunks, if not mapped.
+    Uint32                        string_size; // Validated size of the string pool.
+    SDL_bool                      is_mapped;
+
+} map_blob_t;
+
+/* Streamed maps keep the chunks around the camera in a ring of pages,
+ * much like the chunk cache: chunk x, y lives in page
+ * ((y % ring_size) * ring_size) + (x % ring_size), so finding the page
+ * of a cell takes no search.  A page holds the gids of its chunk and
+ * the cell list of each render chunk inside of it, with the same
+ * layout as the render list.  See stream.h.
+ *
+ * Chunks within STREAM_RADIUS of the chunk at the center of the view
+ * are kept resident, but the ring is made smaller if its pages would
+ * take more than STREAM_BUDGET bytes.
+ */
+#define STREAM_RADIUS 2
+#define STREAM_BUDGET (256 * 1024)
+
+typedef struct stream_page
+{
+    Uint16*        layer_tile;
+    render_cell_t* cell;
+    Uint32*        cell_offset;
+    Sint32         index_x; // -1 if the page is free.
+    Sint32         index_y;
+    SDL_bool       is_empty; // Chunk not in the map, nothing to draw.
+
+} stream_page_t;
+
+typedef struct stream
+{
+    map_blob_t*                   blob;
+    const struct map_blob_chunk*  chunk; // Non-empty chunks, by row.
+    Sint32                        chunk_count;
+    Sint32                        chunk_size;
+    Sint32                        chunk_count_x;
+    Sint32                        chunk_count_y;
+    Sint32                        layer_count;
+    Sint32                        gid_count;
+    stream_page_t*                page;
+    Sint32                        ring_size;
+    Sint32                        radius;
+    Uint32                        load_count;
+    Uint32                        empty_count;
+
+} stream_t;
+
+/* Properties of the map, its layers, objects and tiles, indexed once
+ * at load in an open-addressing hash table.  Entries are keyed by the
+ * owner they belong to and the hash of their name; empty slots have
+ * the type PT_NONE.
+ */
+typedef struct property_entry
+{
+    Uint64 hash;
+    Uint32 owner;
+    Uint32 type;
+
+    union
+    {
+        Sint32      integer;
+        float       decimal;
+        const char* string;
+
+    } value;
+
+} property_entry_t;
+
+typedef struct property_table
+{
+    property_entry_t* entry;
+    Uint32            capacity;
+    Uint32            count;
+
+} property_table_t;
+
+/* Objects of the object layers, stored as parallel arrays so that a
+ * query only walks the bounds.  Bounds are in map pixels, with the
+ * layer offsets applied, and at least one pixel wide and high.  name
+ * and type_name point into the Tiled map or the map blob.
+ *
+ * A uniform grid of OBJECT_CELL_SIZE pixel cells indexes them: the
+ * objects overlapping each cell are listed in cell_object, from
+ * cell_offset[cell] to cell_offset[cell + 1].  See object.h.
+ */
+typedef struct object_store
+{
+    Sint32*      pos_x;
+    Sint32*      pos_y;
+    Sint32*      width;
+    Sint32*      height;
+    Uint32*      id;
+    Uint32*      gid;
+    Uint64*      type_hash;
+    const char** name;
+    const char** type_name;
+    Sint32       count;
+
+    Sint32*      cell_offset;
+    Sint32*      cell_object;
+    Sint32       cell_count_x;
+    Sint32       cell_count_y;
+
+} object_store_t;
+
+/* Hierarchical pathfinding, see path.h.  Nodes are entrances between
+ * clusters, PATH_NODE_MAX slots per cluster; link is the node across
+ * the border, side the border the node is on.  distance holds the
+ * costs between the nodes of a cluster, row by row, and is rebuilt
+ * whenever the cluster is.
+ */
+typedef struct path_node
+{
+    Sint16 index_x;
+    Sint16 index_y;
+    Sint32 link;
+    Uint16 link_cost;
+    Uint8  side;
+
+} path_node_t;
+
+typedef struct path_cluster
+{
+    Uint32*  distance;
+    Sint32   node_count;
+    Uint32   changed_at; // Epoch of the last change of its cells.
+    SDL_bool is_dirty;
+
+} path_cluster_t;
+
+/* A* state over nodes 0 to capacity - 1.  A node's entries are only
+ * valid if its stamp is current, so a search starts without clearing.
+ */
+typedef struct path_search
+{
+    Uint32* cost;
+    Uint32* score;
+    Sint32* parent;
+    Sint32* heap;
+    Sint32* heap_index;
+    Uint32* stamp;
+    Uint32  current;
+    Sint32  heap_count;
+    Sint32  capacity;
+
+} path_search_t;
+
+typedef struct path_entry
+{
+    SDL_Point* point;
+    Sint32     count;
+    Sint32     start;
+    Sint32     goal;
+    Uint32     epoch;
+
+} path_entry_t;
+
+typedef struct path_grid
+{
+    Uint8*          cost;     // Per cell, 0 if blocked.
+    Uint8*          gid_cost;
+    Sint32          width;
+    Sint32          height;
+    path_cluster_t* cluster;
+    path_node_t*    node;
+    Sint32          cluster_count_x;
+    Sint32          cluster_count_y;
+    SDL_bool        has_dirty_cluster;
+    Uint32          epoch;
+    path_search_t   abstract; // Over the nodes, plus one for the goal.
+    path_search_t   local;    // Over the cells of a cluster.
+    path_entry_t*   cache;    // Cached paths live on the heap.
+    Uint32          hit_count;
+    Uint32          miss_count;
+
+} path_grid_t;
+
+/* Solid cells of the map, see collision.h.  Each row takes pitch
+ * words; bit n of word w of a row is cell (w * 32) + n, and bits past
+ * the width are clear.
+ */
+typedef struct collision_grid
+{
+    Uint32* word;
+    Sint32  width;
+    Sint32  height;
+    Sint32  pitch;
+
+} collision_grid_t;
+
+/* Per-frame input state, one bit per button: held while the key is
+ * down, pressed and released in the frame the key went down or up.
+ */
+typedef enum
+{
+    INPUT_UP = 0,
+    INPUT_DOWN,
+    INPUT_LEFT,
+    INPUT_RIGHT,
+    INPUT_BACK,
+    INPUT_OVERLAY,
+    INPUT_MAX
+
+} input_button;
+
+#define INPUT_BIT(button) (1u << (button))
+
+typedef struct input
+{
+    Uint32 held;
+    Uint32 pressed;
+    Uint32 released;
+
+} input_t;
+
+/* pos is the simulated camera position and prev_pos its value before
+ * the last simulation step.  view is the position the scene is drawn
+ * from, interpolated between the two, and last_view the one it was
+ * last drawn from.
+ */
 typedef struct camera
 {
     Sint32  pos_x;
     Sint32  pos_y;
+    Sint32  prev_pos_x;
+    Sint32  prev_pos_y;
+    Sint32  view_x;
+    Sint32  view_y;
+    Sint32  last_view_x;
+    Sint32  last_view_y;
     Sint32  max_pos_x;
     Sint32  max_pos_y;
 
 } camera_t;
 
+/* Fixed-timestep loop.  The simulation advances in steps of
+ * 1 / CORE_STEP_RATE seconds, measured with the performance counter.
+ * Elapsed frame time is collected in accumulator and consumed one step
+ * at a time; when more than CORE_MAX_STEPS steps are due in a single
+ * frame, the rest is dropped instead of letting the loop fall further
+ * behind.  alpha is the fraction of a step left over, in 1/256 units,
+ * used to interpolate rendering.  frame_ticks is the minimum duration
+ * of a frame, 0 for an uncapped frame rate.
+ */
+#define CORE_STEP_RATE      60
+#define CORE_CAMERA_SPEED   300 // In pixels per second.
+#define CORE_MAX_FRAME_RATE 60
+#define CORE_MAX_STEPS      5
+
+typedef struct frame_timer
+{
+    Uint64 frequency;
+    Uint64 step_ticks;
+    Uint64 frame_ticks;
+    Uint64 frame_start;
+    Uint64 accumulator;
+    Uint64 step_count;
+    Uint64 dropped_step_count;
+    Sint32 alpha;
+
+} frame_timer_t;
+
+/* Frame profiler, see profile.h.  Only part of the build with
+ * PROFILE_ENABLED.  The last PROFILE_FRAME_MAX frames and
+ * PROFILE_EVENT_MAX zones are kept in rings; zone times are inclusive,
+ * e.g. render_scene contains both render_map levels.
+ */
+#ifdef PROFILE_ENABLED
+#define PROFILE_FRAME_MAX 1024
+#define PROFILE_EVENT_MAX 16384
+
+typedef enum
+{
+    PROFILE_UPDATE_CORE = 0,
+    PROFILE_ANIMATION,
+    PROFILE_RENDER_SCENE,
+    PROFILE_RENDER_MAP_BG,
+    PROFILE_RENDER_MAP_FG,
+    PROFILE_DRAW_SCENE,
+    PROFILE_ZONE_MAX
+
+} profile_zone;
+
+typedef enum
+{
+    PROFILE_RENDER_COPY = 0,
+    PROFILE_TARGET_SWITCH,
+    PROFILE_TEXTURE_BYTES,
+    PROFILE_COUNTER_MAX
+
+} profile_counter;
+
+typedef struct profile_frame
+{
+    Uint64 start;
+    Uint64 zone_ticks[PROFILE_ZONE_MAX];
+    Uint32 counter[PROFILE_COUNTER_MAX];
+
+} profile_frame_t;
+
+typedef struct profile_event
+{
+    Uint64 start;
+    Uint64 end;
+    Uint32 frame;
+    Sint32 zone;
+
+} profile_event_t;
+
+typedef struct profiler
+{
+    profile_frame_t* frame;
+    profile_event_t* event;
+    SDL_Rect*        overlay_rect;
+    Uint64           zone_start[PROFILE_ZONE_MAX];
+    Uint64           frequency;
+    Uint64           origin;
+    Uint32           frame_count;
+    Uint32           event_count;
+    SDL_bool         is_overlay_visible;
+
+} profiler_t;
+#endif
+
+/* Map-lifetime memory, see arena.h.  Blocks are filled front to back
+ * up to used; every allocation is preceded by its size.
+ */
+typedef struct arena_block
+{
+    struct arena_block* next;
+    size_t              size;
+    size_t              used;
+
+} arena_block_t;
+
+typedef struct arena
+{
+    arena_block_t* block; // Block being filled first.
+    arena_block_t* large; // One block per large allocation.
+    size_t         block_size;
+    size_t         byte_count;
+    size_t         peak_byte_count;
+    size_t         reserved_byte_count;
+    Sint32         block_count;
+
+} arena_t;
+
 typedef struct map
 {
-    tmx_map*         handle;
-    Uint64           hash_query;
-    size_t           path_length;
-    char*            path;
+    arena_t*           arena; // Holds the map and everything it allocates.
+    char*              file_name; // Resolved, the key of the map cache.
+    SDL_bool           is_complete;
+    tmx_map*           handle;
+    SDL_bool           is_handle_in_arena;
+    map_blob_t         blob;
+    size_t             path_length;
+    char*              path;
 
-    Sint32           width;
-    Sint32           height;
-    Sint32           pos_x;
-    Sint32           pos_y;
+    Sint32             width;
+    Sint32             height;
+    Sint32             pos_x;
+    Sint32             pos_y;
 
-    animated_tile_t* animated_tile;
-    Sint32           animated_tile_fps;
-    Sint32           animated_tile_index;
-    Uint32           time_since_last_anim_frame;
+    animation_t*       animation;
+    animation_frame_t* animation_frame;
+    Sint32             animation_count;
+    animated_tile_t*   animated_tile;
+    Sint32*            animated_tile_offset;  // Per chunk, into animated_tile.
+    Sint32*            animation_tile;        // Animated cells of each animation, into animated_tile.
+    Sint32*            animation_tile_offset; // Per animation, into animation_tile.
+    Sint32*            animation_of_gid; // Streamed maps only, animation + 1 per gid.
+    Sint32             animated_tile_index;
+    Sint32*            animation_queue;   // Min-heap of animations by next_change.
+    Sint32             animation_queue_count;
+    Sint32*            changed_animation; // Animations changed by the last tick.
+    Sint32             changed_animation_count;
+    Uint32             animation_time;    // Simulated time since the map was loaded, in ms.
+    Uint32             animation_tick;    // Ticks with changes, see patch_tick.
 
-    SDL_Texture*     animated_tile_texture;
-    SDL_Texture*     layer_texture[MAP_LAYER_MAX];
-    SDL_Texture*     render_target[RENDER_LAYER_MAX];
-    SDL_Texture*     tileset_texture;
+    render_list_t      render_list;
+    stream_t           stream;
+    chunk_cache_t      chunk_cache[MAP_LAYER_MAX];
+#ifdef TILE_BATCH_SUPPORTED
+    tile_batch_t       tile_batch;
+#endif
+    SDL_Texture*       render_target[RENDER_LAYER_MAX];
+    tileset_t*         tileset;
+    Sint32             tileset_count;
+    resource_t*        atlas;           // Atlas of all tilesets, if packed.
+    SDL_Texture*       tileset_texture; // Texture of the atlas.
+    SDL_Surface*       tileset_surface; // Packed atlas, until uploaded.
+    tile_blitter_t     blitter;
 
-    SDL_bool         boolean_property;
-    double           decimal_property;
-    Sint32           integer_property;
-    const char*      string_property;
-    Uint32*          tile_properties;
+    property_table_t   property;
+    Uint32*            tile_properties; // Per-gid tile flags, see tile_flag.h.
+    object_store_t     object;
+    collision_grid_t   collision;
+    path_grid_t        path_grid;
 
 } map_t;
 
+/* Resource and map cache, see cache.h.  Shared by the main core and
+ * the staging core of the map loader, hence the lock.
+ */
+typedef struct cached_map
+{
+    struct cached_map* next;
+    struct map*        map;
+    size_t             byte_count;
+    Uint32             last_use;
+
+} cached_map_t;
+
+typedef struct cache
+{
+    SDL_mutex*    lock;
+    resource_t*   resource;
+    cached_map_t* map;
+    size_t        budget;
+    size_t        resource_byte_count;
+    size_t        map_byte_count;
+    Sint32        resource_count;
+    Sint32        map_count;
+    Uint32        use_count;
+    Uint32        resource_hit_count;
+    Uint32        resource_miss_count;
+    Uint32        map_hit_count;
+    Uint32        map_miss_count;
+
+} cache_t;
+
+/* Work-stealing job system, see job.h.  Each worker thread owns a
+ * deque of jobs, and so does each run_jobs call from another thread,
+ * in one of JOB_CALLER_MAX caller deques claimed for the duration of
+ * the call.  A deque is a ring of JOB_QUEUE_SIZE jobs between top,
+ * where thieves take the oldest job, and bottom, where its owner
+ * pushes and pops.  Shared by the main core and the staging core of
+ * the map loader.
+ */
+#define JOB_THREAD_MAX 8
+#define JOB_CALLER_MAX 4
+#define JOB_QUEUE_SIZE 64
+
+typedef struct job
+{
+    void          (*func)(void* data, Sint32 index);
+    void*         data;
+    Sint32        first;
+    Sint32        last;
+    Sint32        grain;
+    SDL_atomic_t* pending; // Indices of the whole run not done yet.
+    SDL_sem*      done;    // Posted once pending drops to 0.
+
+} job_t;
+
+typedef struct job_queue
+{
+    job_t        job[JOB_QUEUE_SIZE];
+    Sint32       top;
+    Sint32       bottom;
+    SDL_SpinLock lock;
+    SDL_sem*     done;       // Caller deques only.
+    SDL_atomic_t is_claimed; // Caller deques only.
+
+} job_queue_t;
+
+typedef struct job_worker
+{
+    struct job_system* system;
+    SDL_Thread*        thread;
+    Sint32             queue_index;
+
+} job_worker_t;
+
+typedef struct job_system
+{
+    job_worker_t worker[JOB_THREAD_MAX];
+    job_queue_t  queue[JOB_THREAD_MAX + JOB_CALLER_MAX]; // Workers, then callers.
+    SDL_sem*     wake;
+    SDL_atomic_t is_running;
+    SDL_atomic_t steal_count;
+    Sint32       thread_count;
+
+} job_system_t;
+
+/* Background map loading, see load_map_async.  The map is parsed and
+ * its tileset images are decoded on a thread, using a staging core
+ * that shares the renderer and settings of the main one.  Textures are
+ * created and the map is swapped in on the main thread.
+ */
+typedef struct map_loader
+{
+    SDL_Thread*  thread;
+    struct core* staging;
+    char*        file_name;
+    SDL_atomic_t is_done;
+    Sint32       status;
+
+} map_loader_t;
+
 typedef struct core
 {
     SDL_Renderer* renderer;
     SDL_Window*   window;
     map_t*        map;
+    cache_t*      cache;
+    job_system_t* jobs;
+#ifdef PROFILE_ENABLED
+    profiler_t*   profiler;
+#endif
+    map_loader_t  loader;
     struct camera camera;
+    input_t       input;
     SDL_bool      is_active;
     SDL_bool      is_map_loaded;
-    Uint32        time_since_last_frame;
-    Uint32        time_a;
-    Uint32        time_b;
+    frame_timer_t timer;
+    Uint32        time_since_last_frame; // Simulated time of the last frame in ms.
+    Uint32        render_change;
+    Uint32        skipped_frame_count;
+    Uint32        render_copy_count;
+    Uint64        bake_deadline;
+    Uint32        bake_budget_us;
+    Uint32        frame_bake_count;
+    Sint32        stream_radius;
+    size_t        stream_budget;
+    SDL_Point     max_texture_size;
+    SDL_bool      is_tileset_atlas_enabled;
+    SDL_bool      is_tile_batch_enabled;
+    SDL_bool      is_tile_blitter_enabled;
+    SDL_bool      is_progressive_bake_enabled;
 
 } core_t;
 
@@ -106,7 +788,12 @@ typedef enum status
 status_t init_core(const char* title, core_t** core);
 status_t update_core(core_t* core);
 void     free_core(core_t *core);
+void     set_frame_rate_cap(Sint32 max_frame_rate, core_t* core);
+void     request_redraw(Uint32 change, core_t* core);
 status_t load_map(const char* file_name, core_t* core);
+status_t load_map_async(const char* file_name, core_t* core);
+SDL_bool is_map_loading(core_t* core);
 void     unload_map(core_t* core);
+void     free_map(map_t* map, core_t* core);
 
 #endif /* CORE_H */
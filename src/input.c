@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include "core.h"
+#include "input.h"
+
+static const SDL_Scancode input_scancode[INPUT_MAX] =
+{
+    SDL_SCANCODE_UP,
+    SDL_SCANCODE_DOWN,
+    SDL_SCANCODE_LEFT,
+    SDL_SCANCODE_RIGHT,
+    SDL_SCANCODE_BACKSPACE,
+    SDL_SCANCODE_0
+};
+
+static Uint32 get_input_bit(SDL_Scancode scancode);
+
+/* Drain all pending events and sample the keyboard once per frame.
+ * held comes from the keyboard state; key events additionally latch
+ * presses and releases that begin and end between two frames, so that
+ * short taps are never lost.
+ */
+status_t update_input(core_t* core)
+{
+    input_t*     input    = &core->input;
+    const Uint8* keyboard;
+    Uint32       held     = 0;
+    Uint32       pressed  = 0;
+    Uint32       released = 0;
+    status_t     status   = CORE_OK;
+    SDL_Event    event;
+    Sint32       index;
+
+    while (SDL_PollEvent(&event))
+    {
+        switch (event.type)
+        {
+            case SDL_QUIT:
+                status = CORE_EXIT;
+                break;
+            case SDL_WINDOWEVENT:
+                request_redraw(RENDER_CHANGE_ALL, core);
+                break;
+            case SDL_KEYDOWN:
+                if (! event.key.repeat)
+                {
+                    pressed |= get_input_bit(event.key.keysym.scancode);
+                }
+                break;
+            case SDL_KEYUP:
+                released |= get_input_bit(event.key.keysym.scancode);
+                break;
+            default:
+                break;
+        }
+    }
+
+    keyboard = SDL_GetKeyboardState(NULL);
+    for (index = 0; index < INPUT_MAX; index += 1)
+    {
+        if (keyboard[input_scancode[index]])
+        {
+            held |= INPUT_BIT(index);
+        }
+    }
+
+    input->pressed  = (held & ~input->held) | pressed;
+    input->released = (input->held & ~held) | released;
+    input->held     = held;
+
+    return status;
+}
+
+SDL_bool is_input_held(input_button button, core_t* core)
+{
+    return (core->input.held & INPUT_BIT(button)) ? SDL_TRUE : SDL_FALSE;
+}
+
+SDL_bool is_input_pressed(input_button button, core_t* core)
+{
+    return (core->input.pressed & INPUT_BIT(button)) ? SDL_TRUE : SDL_FALSE;
+}
+
+SDL_bool is_input_released(input_button button, core_t* core)
+{
+    return (core->input.released & INPUT_BIT(button)) ? SDL_TRUE : SDL_FALSE;
+}
+
+static Uint32 get_input_bit(SDL_Scancode scancode)
+{
+    Sint32 index;
+
+    for (index = 0; index < INPUT_MAX; index += 1)
+    {
+        if (input_scancode[index] == scancode)
+        {
+            return INPUT_BIT(index);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL.h>
+#include "core.h"
+
+status_t update_input(core_t* core);
+SDL_bool is_input_held(input_button button, core_t* core);
+SDL_bool is_input_pressed(input_button button, core_t* core);
+SDL_bool is_input_released(input_button button, core_t* core);
+
+#endif /* INPUT_H */
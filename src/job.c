@@ -0,0 +1,345 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include "core.h"
+#include "job.h"
+
+static Sint32   claim_caller_queue(job_system_t* system);
+static SDL_bool find_job(job_system_t* system, Sint32 queue_index, const SDL_atomic_t* pending, job_t* job);
+static SDL_bool is_queue_used(job_system_t* system, Sint32 queue_index);
+static SDL_bool pop_job(job_queue_t* queue, job_t* job);
+static SDL_bool push_job(job_queue_t* queue, const job_t* job);
+static void     run_job(job_system_t* system, Sint32 queue_index, job_t* job);
+static int      run_worker(void* data);
+static SDL_bool steal_job(job_queue_t* queue, const SDL_atomic_t* pending, job_t* job);
+
+status_t init_job_system(Sint32 thread_count, core_t* core)
+{
+    job_system_t* system;
+    Sint32        index;
+
+    if (JOB_THREAD_AUTO == thread_count)
+    {
+        thread_count = SDL_GetCPUCount() - 1;
+    }
+    thread_count = SDL_clamp(thread_count, 0, JOB_THREAD_MAX);
+
+    system = (job_system_t*)calloc(1, sizeof(struct job_system));
+    if (! system)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+    core->jobs = system;
+
+    if (0 == thread_count)
+    {
+        return CORE_OK;
+    }
+
+    system->wake = SDL_CreateSemaphore(0);
+    if (! system->wake)
+    {
+        dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+        return CORE_WARNING;
+    }
+
+    for (index = JOB_THREAD_MAX; index < JOB_THREAD_MAX + JOB_CALLER_MAX; index += 1)
+    {
+        system->queue[index].done = SDL_CreateSemaphore(0);
+        if (! system->queue[index].done)
+        {
+            dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+            return CORE_WARNING;
+        }
+    }
+
+    SDL_AtomicSet(&system->is_running, 1);
+
+    for (index = 0; index < thread_count; index += 1)
+    {
+        job_worker_t* worker = &system->worker[index];
+
+        worker->system      = system;
+        worker->queue_index = index;
+        worker->thread      = SDL_CreateThread(run_worker, "job_worker", worker);
+        if (! worker->thread)
+        {
+            dbgprint("Could not create thread: %s", SDL_GetError());
+            break;
+        }
+        system->thread_count += 1;
+    }
+
+    dbgprint("Run jobs on %d worker thread(s).", system->thread_count);
+
+    return system->thread_count == thread_count ? CORE_OK : CORE_WARNING;
+}
+
+void free_job_system(core_t* core)
+{
+    job_system_t* system = core->jobs;
+    Sint32        index;
+
+    if (! system)
+    {
+        return;
+    }
+
+    SDL_AtomicSet(&system->is_running, 0);
+
+    for (index = 0; index < system->thread_count; index += 1)
+    {
+        SDL_SemPost(system->wake);
+    }
+
+    for (index = 0; index < system->thread_count; index += 1)
+    {
+        SDL_WaitThread(system->worker[index].thread, NULL);
+    }
+
+    for (index = JOB_THREAD_MAX; index < JOB_THREAD_MAX + JOB_CALLER_MAX; index += 1)
+    {
+        if (system->queue[index].done)
+        {
+            SDL_DestroySemaphore(system->queue[index].done);
+        }
+    }
+
+    if (system->wake)
+    {
+        SDL_DestroySemaphore(system->wake);
+    }
+
+    free(system);
+    core->jobs = NULL;
+}
+
+Sint32 get_job_thread_count(core_t* core)
+{
+    return core->jobs ? core->jobs->thread_count : 0;
+}
+
+void run_jobs(job_func_t func, void* data, Sint32 count, Sint32 grain, core_t* core)
+{
+    job_system_t* system      = core->jobs;
+    Sint32        queue_index = -1;
+    SDL_atomic_t  pending;
+    job_t         job;
+    Sint32        index;
+
+    grain = SDL_max(grain, 1);
+
+    if (system && 0 < system->thread_count && count > grain)
+    {
+        queue_index = claim_caller_queue(system);
+    }
+
+    if (0 > queue_index)
+    {
+        for (index = 0; index < count; index += 1)
+        {
+            func(data, index);
+        }
+        return;
+    }
+
+    SDL_AtomicSet(&pending, count);
+
+    job.func    = func;
+    job.data    = data;
+    job.first   = 0;
+    job.last    = count;
+    job.grain   = grain;
+    job.pending = &pending;
+    job.done    = system->queue[queue_index].done;
+
+    run_job(system, queue_index, &job);
+
+    /* Help out with the jobs of this run only, so that a frame never
+     * runs the jobs of a map loading in the background, then sleep
+     * until the jobs stolen from us are done.
+     */
+    while (0 < SDL_AtomicGet(&pending) && find_job(system, queue_index, &pending, &job))
+    {
+        run_job(system, queue_index, &job);
+    }
+
+    SDL_SemWait(system->queue[queue_index].done);
+    SDL_AtomicSet(&system->queue[queue_index].is_claimed, 0);
+}
+
+// A caller deque is claimed per run; if all are in use, the run is inline.
+static Sint32 claim_caller_queue(job_system_t* system)
+{
+    Sint32 index;
+
+    for (index = JOB_THREAD_MAX; index < JOB_THREAD_MAX + JOB_CALLER_MAX; index += 1)
+    {
+        if (SDL_AtomicCAS(&system->queue[index].is_claimed, 0, 1))
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+/* Own deque first, newest job, then the oldest job of any other deque.
+ * With pending set, only jobs of that run are taken, and only from the
+ * deques of workers: a caller deque holds the jobs of its own run.
+ */
+static SDL_bool find_job(job_system_t* system, Sint32 queue_index, const SDL_atomic_t* pending, job_t* job)
+{
+    Sint32 queue_count = JOB_THREAD_MAX + JOB_CALLER_MAX;
+    Sint32 index;
+
+    if (pop_job(&system->queue[queue_index], job))
+    {
+        return SDL_TRUE;
+    }
+
+    for (index = 1; index < queue_count; index += 1)
+    {
+        Sint32 victim = (queue_index + index) % queue_count;
+
+        if (! is_queue_used(system, victim) || (pending && JOB_THREAD_MAX <= victim))
+        {
+            continue;
+        }
+
+        if (steal_job(&system->queue[victim], pending, job))
+        {
+            SDL_AtomicAdd(&system->steal_count, 1);
+            return SDL_TRUE;
+        }
+    }
+
+    return SDL_FALSE;
+}
+
+// Deques of workers that were never started stay empty.
+static SDL_bool is_queue_used(job_system_t* system, Sint32 queue_index)
+{
+    return (queue_index < system->thread_count || JOB_THREAD_MAX <= queue_index) ? SDL_TRUE : SDL_FALSE;
+}
+
+static SDL_bool pop_job(job_queue_t* queue, job_t* job)
+{
+    SDL_bool is_found = SDL_FALSE;
+
+    SDL_AtomicLock(&queue->lock);
+    if (queue->bottom > queue->top)
+    {
+        queue->bottom -= 1;
+        *job           = queue->job[queue->bottom % JOB_QUEUE_SIZE];
+        is_found       = SDL_TRUE;
+
+        if (queue->bottom == queue->top)
+        {
+            queue->bottom = 0;
+            queue->top    = 0;
+        }
+    }
+    SDL_AtomicUnlock(&queue->lock);
+
+    return is_found;
+}
+
+static SDL_bool push_job(job_queue_t* queue, const job_t* job)
+{
+    SDL_bool is_pushed = SDL_FALSE;
+
+    SDL_AtomicLock(&queue->lock);
+    if (queue->bottom - queue->top < JOB_QUEUE_SIZE)
+    {
+        queue->job[queue->bottom % JOB_QUEUE_SIZE] = *job;
+        queue->bottom += 1;
+        is_pushed      = SDL_TRUE;
+    }
+    SDL_AtomicUnlock(&queue->lock);
+
+    return is_pushed;
+}
+
+/* Split off the upper half of the job until it is no larger than its
+ * grain, for idle threads to steal, then run what is left.  If the
+ * deque is full, the job runs unsplit.  Whoever finishes the last
+ * index of a run wakes its caller.
+ */
+static void run_job(job_system_t* system, Sint32 queue_index, job_t* job)
+{
+    Sint32 count;
+    Sint32 index;
+
+    while (job->last - job->first > job->grain)
+    {
+        job_t half = *job;
+
+        half.first = job->first + ((job->last - job->first) / 2);
+        if (! push_job(&system->queue[queue_index], &half))
+        {
+            break;
+        }
+        job->last = half.first;
+
+        if (SDL_SemValue(system->wake) < (Uint32)system->thread_count)
+        {
+            SDL_SemPost(system->wake);
+        }
+    }
+
+    for (index = job->first; index < job->last; index += 1)
+    {
+        job->func(job->data, index);
+    }
+
+    count = job->last - job->first;
+    if (count == SDL_AtomicAdd(job->pending, -count))
+    {
+        SDL_SemPost(job->done);
+    }
+}
+
+static int run_worker(void* data)
+{
+    job_worker_t* worker = (job_worker_t*)data;
+    job_system_t* system = worker->system;
+    job_t         job;
+
+    while (SDL_AtomicGet(&system->is_running))
+    {
+        if (find_job(system, worker->queue_index, NULL, &job))
+        {
+            run_job(system, worker->queue_index, &job);
+            continue;
+        }
+
+        SDL_SemWait(system->wake);
+    }
+
+    return 0;
+}
+
+// With pending set, only a job of that run is taken.
+static SDL_bool steal_job(job_queue_t* queue, const SDL_atomic_t* pending, job_t* job)
+{
+    SDL_bool is_found = SDL_FALSE;
+
+    SDL_AtomicLock(&queue->lock);
+    if (queue->bottom > queue->top && (! pending || pending == queue->job[queue->top % JOB_QUEUE_SIZE].pending))
+    {
+        *job        = queue->job[queue->top % JOB_QUEUE_SIZE];
+        queue->top += 1;
+        is_found    = SDL_TRUE;
+
+        if (queue->bottom == queue->top)
+        {
+            queue->bottom = 0;
+            queue->top    = 0;
+        }
+    }
+    SDL_AtomicUnlock(&queue->lock);
+
+    return is_found;
+}
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef JOB_H
+#define JOB_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Work-stealing job system.
+ *
+ * run_jobs calls func(data, index) for every index from 0 to count - 1
+ * and returns once all calls are done.  The whole range starts as one
+ * job; a thread running a job of more than grain indices first splits
+ * off its upper half onto its own deque, where idle threads steal it
+ * from.  Jobs stolen first are the oldest and hence the largest, so a
+ * few steals spread the work over all threads.
+ *
+ * The calling thread runs jobs of its own run as well while it waits,
+ * never those of another thread's run, e.g. a frame never runs the
+ * jobs of a map loading in the background; once none are left, it
+ * sleeps until the stolen ones are done.  Without worker threads, e.g.
+ * on the single core of the N-Gage, or with more than JOB_CALLER_MAX
+ * threads calling at once, everything runs in order on the calling
+ * thread, so callers need no fallback.
+ *
+ * A job may only write what no other index writes and must not use the
+ * renderer.  Worker threads sleep while there is nothing to do.
+ */
+
+#define JOB_THREAD_AUTO -1 // One worker per core but the calling one.
+
+typedef void (*job_func_t)(void* data, Sint32 index);
+
+status_t init_job_system(Sint32 thread_count, core_t* core);
+void     free_job_system(core_t* core);
+Sint32   get_job_thread_count(core_t* core);
+void     run_jobs(job_func_t func, void* data, Sint32 count, Sint32 grain, core_t* core);
+
+#endif /* JOB_H */
@@ -1,6 +1,7 @@
 // Spdx-License-Identifier: MIT
 
 #include "core.h"
+#include "profile.h"
 
 int main(int argc, char *argv[])
 {
@@ -13,10 +14,14 @@ int main(int argc, char *argv[])
         goto quit;
     }
 
-    load_map("E:\\demo.tmx", core);
+    load_map(RES_PREFIX "demo.tmx", core);
 
     while(CORE_OK == update_core(core));
 
+#ifdef PROFILE_ENABLED
+    dump_profile(RES_PREFIX "profile.csv", RES_PREFIX "profile.json", core);
+#endif
+
     quit:
     unload_map(core);
     free_core(core);
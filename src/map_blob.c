@@ -0,0 +1,437 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <tmx.h>
+#include "core.h"
+#include "map_blob.h"
+
+#if defined(__unix__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+static SDL_bool is_section_valid(map_blob_t* blob, Uint32 offset, Uint32 count, Uint32 element_size);
+static status_t validate_map_blob(map_blob_t* blob, size_t file_size);
+static status_t validate_map_blob_cells(map_blob_t* blob, Uint32 chunk_count, Uint32 tile_count);
+static status_t validate_map_blob_chunks(map_blob_t* blob, size_t file_size);
+
+SDL_bool is_compiled_map(const char* file_name)
+{
+    size_t length           = SDL_strlen(file_name);
+    size_t extension_length = SDL_strlen(MAP_BLOB_EXTENSION);
+
+    if (length < extension_length)
+    {
+        return SDL_FALSE;
+    }
+
+    if (0 == SDL_strcmp(&file_name[length - extension_length], MAP_BLOB_EXTENSION))
+    {
+        return SDL_TRUE;
+    }
+
+    return SDL_FALSE;
+}
+
+status_t open_map_blob(const char* file_name, map_blob_t* blob)
+{
+    size_t file_size;
+#if defined(__unix__)
+    struct stat file_stat;
+    int         fd = open(file_name, O_RDONLY);
+
+    if (0 > fd)
+    {
+        dbgprint("%s: %s not found.", FUNCTION_NAME, file_name);
+        return CORE_WARNING;
+    }
+
+    if (0 != fstat(fd, &file_stat) || 0 >= file_stat.st_size)
+    {
+        dbgprint("%s: could not stat %s.", FUNCTION_NAME, file_name);
+        close(fd);
+        return CORE_WARNING;
+    }
+
+    blob->size = (size_t)file_stat.st_size;
+    blob->data = mmap(NULL, blob->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == blob->data)
+    {
+        dbgprint("%s: could not map %s.", FUNCTION_NAME, file_name);
+        blob->data = NULL;
+        return CORE_WARNING;
+    }
+    blob->is_mapped = SDL_TRUE;
+    file_size       = blob->size;
+#else
+    /* No memory mapping on the device: read the whole blob into one
+     * contiguous buffer instead.  The chunk data of a streamed map is
+     * left in the file, which is kept open to read chunks from.
+     */
+    SDL_RWops*        rw = SDL_RWFromFile(file_name, "rb");
+    map_blob_header_t header;
+    Sint64            size;
+
+    if (! rw)
+    {
+        dbgprint("%s: %s not found.", FUNCTION_NAME, file_name);
+        return CORE_WARNING;
+    }
+
+    size = SDL_RWsize(rw);
+    if ((Sint64)sizeof(map_blob_header_t) > size || 1 != SDL_RWread(rw, &header, sizeof(map_blob_header_t), 1))
+    {
+        dbgprint("%s: could not read %s.", FUNCTION_NAME, file_name);
+        SDL_RWclose(rw);
+        return CORE_WARNING;
+    }
+
+    file_size  = (size_t)size;
+    blob->size = file_size;
+    if (0 != header.stream_chunk_size && header.stream_data_offset < file_size)
+    {
+        blob->size = header.stream_data_offset;
+    }
+
+    blob->data = malloc(blob->size);
+    if (! blob->data)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        SDL_RWclose(rw);
+        return CORE_ERROR;
+    }
+
+    if (0 > SDL_RWseek(rw, 0, RW_SEEK_SET) || 1 != SDL_RWread(rw, blob->data, blob->size, 1))
+    {
+        dbgprint("%s: could not read %s.", FUNCTION_NAME, file_name);
+        SDL_RWclose(rw);
+        close_map_blob(blob);
+        return CORE_WARNING;
+    }
+
+    if (blob->size < file_size)
+    {
+        blob->file = rw;
+    }
+    else
+    {
+        SDL_RWclose(rw);
+    }
+#endif
+
+    blob->header = (const map_blob_header_t*)blob->data;
+
+    if (CORE_OK != validate_map_blob(blob, file_size))
+    {
+        dbgprint("%s: %s is not a valid compiled map.", FUNCTION_NAME, file_name);
+        close_map_blob(blob);
+        return CORE_WARNING;
+    }
+
+    return CORE_OK;
+}
+
+void close_map_blob(map_blob_t* blob)
+{
+    if (! blob->data)
+    {
+        return;
+    }
+
+#if defined(__unix__)
+    if (blob->is_mapped)
+    {
+        munmap(blob->data, blob->size);
+    }
+    else
+#endif
+    {
+        free(blob->data);
+    }
+
+    if (blob->file)
+    {
+        SDL_RWclose(blob->file);
+    }
+
+    blob->header      = NULL;
+    blob->file        = NULL;
+    blob->data        = NULL;
+    blob->size        = 0;
+    blob->string_size = 0;
+    blob->is_mapped   = SDL_FALSE;
+}
+
+const void* get_map_blob_section(map_blob_t* blob, Uint32 offset)
+{
+    return (const Uint8*)blob->data + offset;
+}
+
+const char* get_map_blob_string(map_blob_t* blob, Uint32 offset)
+{
+    return (const char*)blob->data + blob->header->string_offset + offset;
+}
+
+/* Read size bytes at offset of the blob into data, from the file if
+ * they have not been read at load.
+ */
+status_t read_map_blob_data(map_blob_t* blob, Uint32 offset, void* data, size_t size)
+{
+    if ((size_t)offset + size <= blob->size)
+    {
+        SDL_memcpy(data, (const Uint8*)blob->data + offset, size);
+        return CORE_OK;
+    }
+
+    if (! blob->file || 0 > SDL_RWseek(blob->file, (Sint64)offset, RW_SEEK_SET) || 1 != SDL_RWread(blob->file, data, size, 1))
+    {
+        dbgprint("%s: could not read %u byte(s) at %u.", FUNCTION_NAME, (unsigned)size, offset);
+        return CORE_ERROR;
+    }
+
+    return CORE_OK;
+}
+
+static SDL_bool is_section_valid(map_blob_t* blob, Uint32 offset, Uint32 count, Uint32 element_size)
+{
+    if (0 != offset % MAP_BLOB_ALIGNMENT)
+    {
+        return SDL_FALSE;
+    }
+
+    if ((size_t)offset > blob->size)
+    {
+        return SDL_FALSE;
+    }
+
+    if ((Uint64)count * element_size > (Uint64)(blob->size - offset))
+    {
+        return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+static status_t validate_map_blob(map_blob_t* blob, size_t file_size)
+{
+    const map_blob_header_t*  header = blob->header;
+    const map_blob_tileset_t* tileset;
+    const Uint8*              gid_tileset;
+    Uint64                    chunk_count;
+    Uint64                    tile_count;
+    Uint32                    string_end;
+    Uint32                    string_size;
+    Uint32                    index;
+
+    if (blob->size < sizeof(map_blob_header_t))
+    {
+        return CORE_ERROR;
+    }
+
+    if (MAP_BLOB_MAGIC != header->magic || MAP_BLOB_VERSION != header->version)
+    {
+        return CORE_ERROR;
+    }
+
+    if (header->size != file_size || CHUNK_SIZE != header->chunk_size)
+    {
+        return CORE_ERROR;
+    }
+
+    if (0x10000 < header->gid_count || 0 == header->tile_width || 0 == header->tile_height)
+    {
+        return CORE_ERROR;
+    }
+
+    /* Sizes are computed in 64 bits, so that a forged header cannot wrap
+     * them around to fit a truncated file.  The render list indexes its
+     * layer grid with Sint32.
+     */
+    if (SDL_MAX_SINT32 < header->width || SDL_MAX_SINT32 < header->height || MAP_BLOB_LAYER_MAX < header->layer_count)
+    {
+        return CORE_ERROR;
+    }
+
+    // Streamed maps have no layer grid and cell list.
+    chunk_count  = ((Uint64)header->width  + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunk_count *= ((Uint64)header->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    tile_count   = (Uint64)header->layer_count * header->width * header->height;
+    string_end   = (Uint32)blob->size;
+
+    if (0 != header->stream_chunk_size)
+    {
+        if (CORE_OK != validate_map_blob_chunks(blob, file_size))
+        {
+            return CORE_ERROR;
+        }
+        chunk_count = 0;
+        tile_count  = 0;
+        string_end  = header->stream_data_offset;
+    }
+
+    if (SDL_MAX_SINT32 <= chunk_count || SDL_MAX_SINT32 < tile_count)
+    {
+        return CORE_ERROR;
+    }
+
+    if (! is_section_valid(blob, header->layer_tile_offset,  (Uint32)tile_count,       sizeof(Uint16))                 ||
+        ! is_section_valid(blob, header->cell_offset_offset, (Uint32)chunk_count + 1,  sizeof(Uint32))                 ||
+        ! is_section_valid(blob, header->cell_list_offset,   header->cell_count,       sizeof(render_cell_t))          ||
+        ! is_section_valid(blob, header->position_offset,    header->gid_count,        sizeof(SDL_Point))              ||
+        ! is_section_valid(blob, header->gid_tileset_offset, header->gid_count,        sizeof(Uint8))                  ||
+        ! is_section_valid(blob, header->tile_flag_offset,   header->gid_count,        sizeof(Uint32))                 ||
+        ! is_section_valid(blob, header->tileset_offset,     header->tileset_count,    sizeof(map_blob_tileset_t))     ||
+        ! is_section_valid(blob, header->animation_offset,   header->animation_count,  sizeof(map_blob_animation_t))   ||
+        ! is_section_valid(blob, header->frame_offset,       header->frame_count,      sizeof(animation_frame_t))      ||
+        ! is_section_valid(blob, header->property_offset,    header->property_count,   sizeof(map_blob_property_t))    ||
+        ! is_section_valid(blob, header->object_offset,      header->object_count,     sizeof(map_blob_object_t))      ||
+        ! is_section_valid(blob, header->string_offset,      0,                        1))
+    {
+        return CORE_ERROR;
+    }
+
+    // The string pool runs to the end of the blob, or to the chunk data, and must be terminated.
+    if (header->string_offset >= string_end || string_end > blob->size)
+    {
+        return CORE_ERROR;
+    }
+    string_size = string_end - header->string_offset;
+    if ('\0' != ((const char*)blob->data)[string_end - 1])
+    {
+        return CORE_ERROR;
+    }
+    blob->string_size = string_size;
+
+    if (0 == header->tileset_count || 255 < header->tileset_count)
+    {
+        return CORE_ERROR;
+    }
+
+    tileset = (const map_blob_tileset_t*)get_map_blob_section(blob, header->tileset_offset);
+    for (index = 0; index < header->tileset_count; index += 1)
+    {
+        if (tileset[index].image_source >= string_size ||
+            (Uint64)tileset[index].first_gid + tileset[index].tile_count > header->gid_count)
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    gid_tileset = (const Uint8*)get_map_blob_section(blob, header->gid_tileset_offset);
+    for (index = 0; index < header->gid_count; index += 1)
+    {
+        if (gid_tileset[index] >= header->tileset_count)
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    return validate_map_blob_cells(blob, (Uint32)chunk_count, (Uint32)tile_count);
+}
+
+/* The renderer uses the layer grid and the cell list in place: every
+ * gid indexes the per-gid tables and every cell offset the cell list,
+ * so they are all checked once, at load.
+ */
+static status_t validate_map_blob_cells(map_blob_t* blob, Uint32 chunk_count, Uint32 tile_count)
+{
+    const map_blob_header_t* header = blob->header;
+    const Uint16*            layer_tile;
+    const Uint32*            cell_offset;
+    const render_cell_t*     cell;
+    Uint32                   index;
+
+    if (0 == chunk_count)
+    {
+        return CORE_OK;
+    }
+
+    layer_tile = (const Uint16*)get_map_blob_section(blob, header->layer_tile_offset);
+    for (index = 0; index < tile_count; index += 1)
+    {
+        if (layer_tile[index] >= header->gid_count)
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    cell_offset = (const Uint32*)get_map_blob_section(blob, header->cell_offset_offset);
+    if (0 != cell_offset[0] || header->cell_count != cell_offset[chunk_count])
+    {
+        return CORE_ERROR;
+    }
+    for (index = 0; index < chunk_count; index += 1)
+    {
+        if (cell_offset[index] > cell_offset[index + 1] || cell_offset[index + 1] > header->cell_count)
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    cell = (const render_cell_t*)get_map_blob_section(blob, header->cell_list_offset);
+    for (index = 0; index < header->cell_count; index += 1)
+    {
+        if (cell[index].gid >= header->gid_count || CHUNK_SIZE <= cell[index].pos_x || CHUNK_SIZE <= cell[index].pos_y)
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    return CORE_OK;
+}
+
+/* The chunk index of a streamed map has to be sorted, for lookups by
+ * binary search, and every chunk has to lie within the chunk data.
+ * The gids themselves are checked when a chunk is read.
+ */
+static status_t validate_map_blob_chunks(map_blob_t* blob, size_t file_size)
+{
+    const map_blob_header_t* header = blob->header;
+    const map_blob_chunk_t*  chunk;
+    Uint32                   chunk_size;
+    Uint32                   data_size;
+    Uint32                   index;
+
+    if (0 != header->stream_chunk_size % CHUNK_SIZE || 256 < header->stream_chunk_size ||
+        0 != header->width % header->stream_chunk_size || 0 != header->height % header->stream_chunk_size ||
+        header->stream_data_offset > file_size || header->stream_data_offset > blob->size)
+    {
+        return CORE_ERROR;
+    }
+
+    if (! is_section_valid(blob, header->chunk_offset, header->stream_chunk_count, sizeof(map_blob_chunk_t)))
+    {
+        return CORE_ERROR;
+    }
+
+    chunk_size = header->stream_chunk_size;
+    data_size  = header->layer_count * chunk_size * chunk_size * (Uint32)sizeof(Uint16);
+    chunk      = (const map_blob_chunk_t*)get_map_blob_section(blob, header->chunk_offset);
+
+    for (index = 0; index < header->stream_chunk_count; index += 1)
+    {
+        if (chunk[index].index_x >= header->width / chunk_size || chunk[index].index_y >= header->height / chunk_size)
+        {
+            return CORE_ERROR;
+        }
+
+        if (chunk[index].data_offset < header->stream_data_offset || 0 != chunk[index].data_offset % sizeof(Uint16) ||
+            (Uint64)chunk[index].data_offset + data_size > (Uint64)file_size)
+        {
+            return CORE_ERROR;
+        }
+
+        if (0 < index &&
+            (chunk[index].index_y < chunk[index - 1].index_y ||
+             (chunk[index].index_y == chunk[index - 1].index_y && chunk[index].index_x <= chunk[index - 1].index_x)))
+        {
+            return CORE_ERROR;
+        }
+    }
+
+    return CORE_OK;
+}
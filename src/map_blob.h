@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef MAP_BLOB_H
+#define MAP_BLOB_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Compiled map format.
+ *
+ * A compiled map (.cmap) is produced offline by demo_mapc from a Tiled
+ * map and its tilesets.  It is a single little-endian blob: a header
+ * followed by sections whose offsets are given in the header, each
+ * aligned to MAP_BLOB_ALIGNMENT bytes from the start of the blob.  The
+ * blob is mapped read-only and used in place, e.g. the layer gid grids
+ * and the per-chunk cell lists are read directly by the renderer.
+ *
+ * Sections:
+ *   layer_tile  Uint16[layer_count * width * height]
+ *   cell_offset Uint32[chunk_count_x * chunk_count_y + 1]
+ *   cell        render_cell_t[cell_count]
+ *   position    SDL_Point[gid_count]
+ *   gid_tileset Uint8[gid_count]
+ *   tile_flag   Uint32[gid_count], see tile_flag.h
+ *   tileset     map_blob_tileset_t[tileset_count]
+ *   animation   map_blob_animation_t[animation_count]
+ *   frame       animation_frame_t[frame_count]
+ *   property    map_blob_property_t[property_count]
+ *   object      map_blob_object_t[object_count]
+ *   chunk       map_blob_chunk_t[stream_chunk_count]
+ *   string      NUL-terminated strings, referenced by offset
+ *   stream      Chunk data of streamed maps, see below
+ *
+ * Infinite Tiled maps are compiled into streamed maps, whose layers
+ * are too large to be kept in memory (see stream.h).  Their
+ * stream_chunk_size is the side of a chunk in tiles, a multiple of
+ * CHUNK_SIZE, and width and height cover all chunks, the first of
+ * which starts at cell 0.  The layer_tile and cell sections are empty;
+ * instead, the chunk section lists the non-empty chunks sorted by row
+ * and column, each with the offset of its gids in the stream section:
+ * Uint16[layer_count * stream_chunk_size * stream_chunk_size], layer
+ * by layer, row by row.  The stream section starts at
+ * stream_data_offset and is the only part of the blob that is not
+ * read at load.
+ */
+
+#define MAP_BLOB_MAGIC     0x50414d43 /* "CMAP" */
+#define MAP_BLOB_VERSION   6
+#define MAP_BLOB_ALIGNMENT 8
+#define MAP_BLOB_EXTENSION ".cmap"
+#define MAP_BLOB_LAYER_MAX 256
+
+typedef struct map_blob_header
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 size;
+    Uint32 chunk_size;
+
+    Uint32 width;
+    Uint32 height;
+    Uint32 tile_width;
+    Uint32 tile_height;
+    Uint32 gid_count;
+    Uint32 tileset_count;
+    Uint32 layer_count;
+    Uint32 cell_count;
+    Uint32 animation_count;
+    Uint32 frame_count;
+    Uint32 property_count;
+    Uint32 object_count;
+
+    Uint32 layer_tile_offset;
+    Uint32 cell_offset_offset;
+    Uint32 cell_list_offset;
+    Uint32 position_offset;
+    Uint32 gid_tileset_offset;
+    Uint32 tile_flag_offset;
+    Uint32 tileset_offset;
+    Uint32 animation_offset;
+    Uint32 frame_offset;
+    Uint32 property_offset;
+    Uint32 object_offset;
+    Uint32 string_offset;
+
+    Uint32 stream_chunk_size;
+    Uint32 stream_chunk_count;
+    Uint32 chunk_offset;
+    Uint32 stream_data_offset;
+
+} map_blob_header_t;
+
+// image_source is relative to the directory of the map.
+typedef struct map_blob_tileset
+{
+    Uint32 first_gid;
+    Uint32 tile_count;
+    Uint32 image_source;
+    Uint32 reserved;
+
+} map_blob_tileset_t;
+
+typedef struct map_blob_animation
+{
+    Uint32 gid;
+    Uint32 first_frame;
+    Uint32 frame_count;
+    Uint32 reserved;
+
+} map_blob_animation_t;
+
+/* Properties of the map, its layers, objects and tiles.  owner is
+ * one of the PROPERTY_OWNER_* values of property.h.
+ */
+typedef struct map_blob_property
+{
+    Uint64 hash;
+    Uint32 owner;
+    Uint32 type;
+
+    union
+    {
+        Sint32 integer;
+        float  decimal;
+        Uint32 string;
+
+    } value;
+
+    Uint32 reserved;
+
+} map_blob_property_t;
+
+/* Objects of the object layers, as in the object store.  name and
+ * type are string offsets.
+ */
+typedef struct map_blob_object
+{
+    Uint64 type_hash;
+    Sint32 pos_x;
+    Sint32 pos_y;
+    Sint32 width;
+    Sint32 height;
+    Uint32 id;
+    Uint32 gid;
+    Uint32 name;
+    Uint32 type;
+
+} map_blob_object_t;
+
+// A chunk of a streamed map, in chunks from the top-left one.
+typedef struct map_blob_chunk
+{
+    Uint32 index_x;
+    Uint32 index_y;
+    Uint32 data_offset;
+    Uint32 reserved;
+
+} map_blob_chunk_t;
+
+SDL_bool    is_compiled_map(const char* file_name);
+status_t    open_map_blob(const char* file_name, map_blob_t* blob);
+void        close_map_blob(map_blob_t* blob);
+const void* get_map_blob_section(map_blob_t* blob, Uint32 offset);
+const char* get_map_blob_string(map_blob_t* blob, Uint32 offset);
+status_t    read_map_blob_data(map_blob_t* blob, Uint32 offset, void* data, size_t size);
+
+#endif /* MAP_BLOB_H */
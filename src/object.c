@@ -0,0 +1,438 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <tmx.h>
+#include "arena.h"
+#include "core.h"
+#include "map_blob.h"
+#include "object.h"
+#include "tiled.h"
+
+static status_t allocate_objects(Sint32 count, map_t* map);
+static status_t load_objects_from_blob(core_t* core);
+static status_t load_objects_from_tiled_map(core_t* core);
+static Sint32   count_tiled_objects(tmx_layer* layer, core_t* core);
+static void     add_tiled_objects(tmx_layer* layer, Sint32 offset_x, Sint32 offset_y, core_t* core);
+static void     get_tiled_object_bounds(tmx_object* object, SDL_Rect* bounds);
+static status_t build_object_grid(map_t* map);
+static Sint32   get_cell(Sint32 pos, Sint32 cell_count);
+static void     get_cell_range(const object_store_t* store, Sint32 pos_x, Sint32 pos_y, Sint32 width, Sint32 height, SDL_Rect* range);
+
+status_t load_objects(core_t* core)
+{
+    map_t*          map   = core->map;
+    object_store_t* store = &map->object;
+    status_t        status;
+
+    // [1] Objects.
+    if (map->blob.data)
+    {
+        status = load_objects_from_blob(core);
+    }
+    else
+    {
+        status = load_objects_from_tiled_map(core);
+    }
+
+    if (CORE_OK != status || 0 >= store->count)
+    {
+        return status;
+    }
+
+    // [2] Grid.
+    if (CORE_OK != build_object_grid(map))
+    {
+        return CORE_ERROR;
+    }
+
+    dbgprint("Load %d object(s), %dx%d grid cell(s).", store->count, store->cell_count_x, store->cell_count_y);
+
+    return CORE_OK;
+}
+
+Sint32 query_objects_in_rect(const SDL_Rect* rect, Sint32* result, Sint32 max_count, core_t* core)
+{
+    const object_store_t* store = &core->map->object;
+    SDL_Rect              range;
+    Sint32                found = 0;
+    Sint32                cell_x;
+    Sint32                cell_y;
+    Sint32                entry;
+
+    if (! store->cell_offset || 0 >= rect->w || 0 >= rect->h)
+    {
+        return 0;
+    }
+
+    get_cell_range(store, rect->x, rect->y, rect->w, rect->h, &range);
+
+    for (cell_y = range.y; cell_y < range.y + range.h; cell_y += 1)
+    {
+        for (cell_x = range.x; cell_x < range.x + range.w; cell_x += 1)
+        {
+            Sint32 cell = (cell_y * store->cell_count_x) + cell_x;
+
+            for (entry = store->cell_offset[cell]; entry < store->cell_offset[cell + 1]; entry += 1)
+            {
+                Sint32 object = store->cell_object[entry];
+                Sint32 left   = SDL_max(store->pos_x[object], rect->x);
+                Sint32 top    = SDL_max(store->pos_y[object], rect->y);
+
+                if (store->pos_x[object] >= rect->x + rect->w || rect->x >= store->pos_x[object] + store->width[object] ||
+                    store->pos_y[object] >= rect->y + rect->h || rect->y >= store->pos_y[object] + store->height[object])
+                {
+                    continue;
+                }
+
+                // Only the cell holding the top-left corner of the overlap reports the object.
+                if (get_cell(left, store->cell_count_x) != cell_x || get_cell(top, store->cell_count_y) != cell_y)
+                {
+                    continue;
+                }
+
+                if (found < max_count)
+                {
+                    result[found] = object;
+                }
+                found += 1;
+            }
+        }
+    }
+
+    return found;
+}
+
+Sint32 query_objects_at_point(Sint32 pos_x, Sint32 pos_y, Sint32* result, Sint32 max_count, core_t* core)
+{
+    const object_store_t* store = &core->map->object;
+    Sint32                found = 0;
+    Sint32                cell;
+    Sint32                entry;
+
+    if (! store->cell_offset)
+    {
+        return 0;
+    }
+
+    cell = (get_cell(pos_y, store->cell_count_y) * store->cell_count_x) + get_cell(pos_x, store->cell_count_x);
+
+    for (entry = store->cell_offset[cell]; entry < store->cell_offset[cell + 1]; entry += 1)
+    {
+        Sint32 object = store->cell_object[entry];
+
+        if (pos_x <  store->pos_x[object] || pos_x >= store->pos_x[object] + store->width[object] ||
+            pos_y <  store->pos_y[object] || pos_y >= store->pos_y[object] + store->height[object])
+        {
+            continue;
+        }
+
+        if (found < max_count)
+        {
+            result[found] = object;
+        }
+        found += 1;
+    }
+
+    return found;
+}
+
+// Objects overlapping the camera, as drawn in the current frame.
+Sint32 query_objects_in_view(Sint32* result, Sint32 max_count, core_t* core)
+{
+    SDL_Rect view;
+
+    view.x = core->camera.view_x - core->map->pos_x;
+    view.y = core->camera.view_y - core->map->pos_y;
+    view.w = 176;
+    view.h = 208;
+
+    return query_objects_in_rect(&view, result, max_count, core);
+}
+
+void get_object_rect(Sint32 index, SDL_Rect* rect, core_t* core)
+{
+    const object_store_t* store = &core->map->object;
+
+    rect->x = store->pos_x[index];
+    rect->y = store->pos_y[index];
+    rect->w = store->width[index];
+    rect->h = store->height[index];
+}
+
+static status_t allocate_objects(Sint32 count, map_t* map)
+{
+    object_store_t* store = &map->object;
+
+    store->pos_x     = (Sint32*)arena_calloc(map->arena, (size_t)count, sizeof(Sint32));
+    store->pos_y     = (Sint32*)arena_calloc(map->arena, (size_t)count, sizeof(Sint32));
+    store->width     = (Sint32*)arena_calloc(map->arena, (size_t)count, sizeof(Sint32));
+    store->height    = (Sint32*)arena_calloc(map->arena, (size_t)count, sizeof(Sint32));
+    store->id        = (Uint32*)arena_calloc(map->arena, (size_t)count, sizeof(Uint32));
+    store->gid       = (Uint32*)arena_calloc(map->arena, (size_t)count, sizeof(Uint32));
+    store->type_hash = (Uint64*)arena_calloc(map->arena, (size_t)count, sizeof(Uint64));
+    store->name      = (const char**)arena_calloc(map->arena, (size_t)count, sizeof(const char*));
+    store->type_name = (const char**)arena_calloc(map->arena, (size_t)count, sizeof(const char*));
+
+    if (! store->pos_x || ! store->pos_y || ! store->width || ! store->height || ! store->id ||
+        ! store->gid || ! store->type_hash || ! store->name || ! store->type_name)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    return CORE_OK;
+}
+
+static status_t load_objects_from_blob(core_t* core)
+{
+    map_t*                   map         = core->map;
+    object_store_t*          store       = &map->object;
+    const map_blob_header_t* header      = map->blob.header;
+    const map_blob_object_t* object      = (const map_blob_object_t*)get_map_blob_section(&map->blob, header->object_offset);
+    Uint32                   string_size = map->blob.string_size;
+    Uint32                   index;
+
+    if (0 == header->object_count)
+    {
+        return CORE_OK;
+    }
+
+    if (0x7fffffff < header->object_count || CORE_OK != allocate_objects((Sint32)header->object_count, map))
+    {
+        return CORE_ERROR;
+    }
+
+    for (index = 0; index < header->object_count; index += 1)
+    {
+        if (object[index].name >= string_size || object[index].type >= string_size ||
+            0 >= object[index].width || 0 >= object[index].height)
+        {
+            dbgprint("%s: corrupt object table.", FUNCTION_NAME);
+            return CORE_ERROR;
+        }
+
+        store->pos_x[index]     = object[index].pos_x;
+        store->pos_y[index]     = object[index].pos_y;
+        store->width[index]     = object[index].width;
+        store->height[index]    = object[index].height;
+        store->id[index]        = object[index].id;
+        store->gid[index]       = object[index].gid;
+        store->type_hash[index] = object[index].type_hash;
+        store->name[index]      = get_map_blob_string(&map->blob, object[index].name);
+        store->type_name[index] = get_map_blob_string(&map->blob, object[index].type);
+    }
+    store->count = (Sint32)header->object_count;
+
+    return CORE_OK;
+}
+
+static status_t load_objects_from_tiled_map(core_t* core)
+{
+    map_t* map   = core->map;
+    Sint32 count = count_tiled_objects(get_head_layer(map->handle), core);
+
+    if (0 == count)
+    {
+        return CORE_OK;
+    }
+
+    if (CORE_OK != allocate_objects(count, map))
+    {
+        return CORE_ERROR;
+    }
+
+    add_tiled_objects(get_head_layer(map->handle), 0, 0, core);
+
+    return CORE_OK;
+}
+
+static Sint32 count_tiled_objects(tmx_layer* layer, core_t* core)
+{
+    Sint32 count = 0;
+
+    while (layer)
+    {
+        tmx_object* object = get_head_object(layer, core);
+
+        if (is_tiled_layer_of_type(L_GROUP, layer))
+        {
+            count += count_tiled_objects(layer->content.group_head, core);
+        }
+
+        for (; object; object = object->next)
+        {
+            count += 1;
+        }
+
+        layer = layer->next;
+    }
+
+    return count;
+}
+
+// Offsets of group layers add up.
+static void add_tiled_objects(tmx_layer* layer, Sint32 offset_x, Sint32 offset_y, core_t* core)
+{
+    object_store_t* store = &core->map->object;
+
+    while (layer)
+    {
+        tmx_object* object = get_head_object(layer, core);
+
+        if (is_tiled_layer_of_type(L_GROUP, layer))
+        {
+            add_tiled_objects(layer->content.group_head, offset_x + layer->offsetx, offset_y + layer->offsety, core);
+        }
+
+        for (; object; object = object->next)
+        {
+            Sint32      index     = store->count;
+            const char* name      = get_object_name(object);
+            const char* type_name = get_object_type_name(object);
+            SDL_Rect    bounds;
+
+            get_tiled_object_bounds(object, &bounds);
+
+            store->pos_x[index]     = offset_x + layer->offsetx + bounds.x;
+            store->pos_y[index]     = offset_y + layer->offsety + bounds.y;
+            store->width[index]     = bounds.w;
+            store->height[index]    = bounds.h;
+            store->id[index]        = object->id;
+            store->gid[index]       = (OT_TILE == object->obj_type) ? ((Uint32)object->content.gid & TMX_FLIP_BITS_REMOVAL) : 0;
+            store->name[index]      = name      ? name      : "";
+            store->type_name[index] = type_name ? type_name : "";
+            store->type_hash[index] = generate_hash((const unsigned char*)store->type_name[index]);
+            store->count           += 1;
+        }
+
+        layer = layer->next;
+    }
+}
+
+static void get_tiled_object_bounds(tmx_object* object, SDL_Rect* bounds)
+{
+    double min_x = object->x;
+    double min_y = object->y;
+    double max_x = object->x + object->width;
+    double max_y = object->y + object->height;
+
+    if ((OT_POLYGON == object->obj_type || OT_POLYLINE == object->obj_type) && object->content.shape)
+    {
+        tmx_shape* shape = object->content.shape;
+        Sint32     index;
+
+        for (index = 0; index < shape->points_len; index += 1)
+        {
+            min_x = SDL_min(min_x, object->x + shape->points[index][0]);
+            min_y = SDL_min(min_y, object->y + shape->points[index][1]);
+            max_x = SDL_max(max_x, object->x + shape->points[index][0]);
+            max_y = SDL_max(max_y, object->y + shape->points[index][1]);
+        }
+    }
+    else if (OT_TILE == object->obj_type)
+    {
+        // Tile objects are placed by their bottom-left corner.
+        min_y -= object->height;
+        max_y -= object->height;
+    }
+
+    bounds->x = (int)SDL_floor(min_x);
+    bounds->y = (int)SDL_floor(min_y);
+    bounds->w = SDL_max(1, (int)SDL_ceil(max_x) - bounds->x);
+    bounds->h = SDL_max(1, (int)SDL_ceil(max_y) - bounds->y);
+}
+
+/* The grid covers the tile layers.  Objects beyond them are listed in
+ * the cells along the edge, where queries clamp to as well.
+ */
+static status_t build_object_grid(map_t* map)
+{
+    object_store_t* store       = &map->object;
+    render_list_t*  list        = &map->render_list;
+    Sint32          cell_count;
+    Sint32          entry_count = 0;
+    Sint32          cell_x;
+    Sint32          cell_y;
+    Sint32          index;
+    SDL_Rect        range;
+
+    store->cell_count_x = SDL_max(1, ((list->width  * list->tile_width)  + OBJECT_CELL_SIZE - 1) / OBJECT_CELL_SIZE);
+    store->cell_count_y = SDL_max(1, ((list->height * list->tile_height) + OBJECT_CELL_SIZE - 1) / OBJECT_CELL_SIZE);
+    cell_count          = store->cell_count_x * store->cell_count_y;
+
+    store->cell_offset = (Sint32*)arena_calloc(map->arena, (size_t)cell_count + 1, sizeof(Sint32));
+    if (! store->cell_offset)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    // Count objects per cell.
+    for (index = 0; index < store->count; index += 1)
+    {
+        get_cell_range(store, store->pos_x[index], store->pos_y[index], store->width[index], store->height[index], &range);
+
+        for (cell_y = range.y; cell_y < range.y + range.h; cell_y += 1)
+        {
+            for (cell_x = range.x; cell_x < range.x + range.w; cell_x += 1)
+            {
+                store->cell_offset[(cell_y * store->cell_count_x) + cell_x + 1] += 1;
+            }
+        }
+        entry_count += range.w * range.h;
+    }
+
+    for (index = 0; index < cell_count; index += 1)
+    {
+        store->cell_offset[index + 1] += store->cell_offset[index];
+    }
+
+    store->cell_object = (Sint32*)arena_calloc(map->arena, (size_t)entry_count, sizeof(Sint32));
+    if (! store->cell_object)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        store->cell_offset = NULL;
+        return CORE_ERROR;
+    }
+
+    // Sort objects into their cells.
+    for (index = 0; index < store->count; index += 1)
+    {
+        get_cell_range(store, store->pos_x[index], store->pos_y[index], store->width[index], store->height[index], &range);
+
+        for (cell_y = range.y; cell_y < range.y + range.h; cell_y += 1)
+        {
+            for (cell_x = range.x; cell_x < range.x + range.w; cell_x += 1)
+            {
+                Sint32 cell = (cell_y * store->cell_count_x) + cell_x;
+
+                store->cell_object[store->cell_offset[cell]] = index;
+                store->cell_offset[cell] += 1;
+            }
+        }
+    }
+
+    // Filling advanced each offset by one cell; shift them back.
+    for (index = cell_count; index > 0; index -= 1)
+    {
+        store->cell_offset[index] = store->cell_offset[index - 1];
+    }
+    store->cell_offset[0] = 0;
+
+    return CORE_OK;
+}
+
+static Sint32 get_cell(Sint32 pos, Sint32 cell_count)
+{
+    Sint32 cell = (0 > pos) ? 0 : pos / OBJECT_CELL_SIZE;
+
+    return SDL_min(cell, cell_count - 1);
+}
+
+static void get_cell_range(const object_store_t* store, Sint32 pos_x, Sint32 pos_y, Sint32 width, Sint32 height, SDL_Rect* range)
+{
+    range->x = get_cell(pos_x, store->cell_count_x);
+    range->y = get_cell(pos_y, store->cell_count_y);
+    range->w = get_cell(pos_x + width  - 1, store->cell_count_x) - range->x + 1;
+    range->h = get_cell(pos_y + height - 1, store->cell_count_y) - range->y + 1;
+}
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Objects of the object layers, e.g. triggers and NPC spawns.
+ *
+ * Objects are loaded once into the object store of the map (see
+ * core.h) and indexed by a uniform grid, so a query only tests the
+ * objects listed in the cells it covers instead of every object of the
+ * map.  Queries take map pixel coordinates and write the indices of
+ * the matching objects into result, in no particular order, up to
+ * max_count; they return the number of objects found, which may be
+ * more than max_count.  An object spanning several cells is reported
+ * once, from the cell holding the top-left corner of its overlap with
+ * the query, so queries keep no state and may run on any thread.
+ *
+ * Polygons and polylines are indexed by their bounding box; rotation is
+ * ignored.  Properties of an object are found with its id, see
+ * PROPERTY_OWNER_OBJECT.
+ */
+
+#define OBJECT_CELL_SIZE 64
+
+status_t load_objects(core_t* core);
+Sint32   query_objects_in_rect(const SDL_Rect* rect, Sint32* result, Sint32 max_count, core_t* core);
+Sint32   query_objects_at_point(Sint32 pos_x, Sint32 pos_y, Sint32* result, Sint32 max_count, core_t* core);
+Sint32   query_objects_in_view(Sint32* result, Sint32 max_count, core_t* core);
+void     get_object_rect(Sint32 index, SDL_Rect* rect, core_t* core);
+
+#endif /* OBJECT_H */
@@ -0,0 +1,1154 @@
+// SPDX-License-Identifier: MIT
+
+#include <stdlib.h>
+#include <SDL.h>
+#include "arena.h"
+#include "core.h"
+#include "path.h"
+#include "property.h"
+#include "render_list.h"
+#include "tile_flag.h"
+#include "tiled.h"
+
+#define PATH_COST_NONE 0xffffffff
+#define PATH_HEAP_OPEN -1
+#define PATH_HEAP_DONE -2
+
+typedef enum
+{
+    PATH_SIDE_TOP = 0,
+    PATH_SIDE_BOTTOM,
+    PATH_SIDE_LEFT,
+    PATH_SIDE_RIGHT,
+    PATH_SIDE_MAX
+
+} path_side;
+
+typedef struct path_buffer
+{
+    SDL_Point* point;
+    Sint32     count;
+    Sint32     capacity;
+
+} path_buffer_t;
+
+static const Sint32 step_x[8] = {  0, 1, 0, -1,  1, 1, -1, -1 };
+static const Sint32 step_y[8] = { -1, 0, 1,  0, -1, 1,  1, -1 };
+
+static status_t load_gid_costs(core_t* core);
+static Uint8    get_cell_cost(Sint32 index_x, Sint32 index_y, core_t* core);
+static Uint8    get_cost(const path_grid_t* grid, Sint32 index_x, Sint32 index_y);
+static Sint32   get_cluster(const path_grid_t* grid, Sint32 index_x, Sint32 index_y);
+static void     get_cluster_rect(const path_grid_t* grid, Sint32 cluster, SDL_Rect* rect);
+static void     mark_cell_changed(path_grid_t* grid, Sint32 index_x, Sint32 index_y);
+static status_t rebuild_clusters(path_grid_t* grid);
+static void     build_cluster_nodes(path_grid_t* grid, Sint32 cluster);
+static void     add_side_nodes(path_grid_t* grid, Sint32 cluster, path_side side);
+static void     link_cluster_nodes(path_grid_t* grid, Sint32 cluster);
+static status_t build_cluster_distances(path_grid_t* grid, Sint32 cluster);
+static status_t init_search(path_search_t* search, Sint32 capacity, arena_t* arena);
+static void     reset_search(path_search_t* search);
+static Uint32   get_search_cost(const path_search_t* search, Sint32 node);
+static void     update_search(path_search_t* search, Sint32 node, Uint32 cost, Uint32 estimate, Sint32 parent);
+static Sint32   pop_search(path_search_t* search);
+static void     sift_up(path_search_t* search, Sint32 position);
+static void     sift_down(path_search_t* search, Sint32 position);
+static Uint32   get_estimate(Sint32 from_x, Sint32 from_y, Sint32 to_x, Sint32 to_y);
+static Uint32   search_cluster(path_grid_t* grid, Sint32 cluster, const SDL_Point* from, const SDL_Point* to);
+static Uint32   get_cluster_cost(const path_grid_t* grid, Sint32 cluster, Sint32 index_x, Sint32 index_y);
+static Sint32   search_nodes(path_grid_t* grid, const SDL_Point* start, const SDL_Point* goal);
+static status_t refine_path(path_grid_t* grid, Sint32 node, const SDL_Point* start, const SDL_Point* goal, path_buffer_t* buffer);
+static status_t append_cluster_path(path_grid_t* grid, Sint32 cluster, const SDL_Point* to, path_buffer_t* buffer);
+static status_t reserve_path(path_buffer_t* buffer, Sint32 count);
+static SDL_bool is_cached_path_valid(const path_grid_t* grid, const path_entry_t* entry);
+
+/* The grid, nodes and search state are allocated from the map arena;
+ * cluster distances and cached paths change size as clusters are
+ * rebuilt and live on the heap until free_path_grid.
+ */
+status_t load_path_grid(core_t* core)
+{
+    map_t*       map  = core->map;
+    path_grid_t* grid = &map->path_grid;
+    Sint32       cluster_count;
+    Sint32       index_x;
+    Sint32       index_y;
+    Sint32       index;
+
+    grid->width  = map->render_list.width;
+    grid->height = map->render_list.height;
+    if (0 >= grid->width || 0 >= grid->height || map->render_list.stream)
+    {
+        return CORE_OK;
+    }
+
+    grid->cluster_count_x = (grid->width  + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+    grid->cluster_count_y = (grid->height + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+    cluster_count         = grid->cluster_count_x * grid->cluster_count_y;
+
+    // [1] Cell costs.
+    if (CORE_OK != load_gid_costs(core))
+    {
+        return CORE_ERROR;
+    }
+
+    grid->cost = (Uint8*)arena_calloc(map->arena, (size_t)grid->width * (size_t)grid->height, sizeof(Uint8));
+    if (! grid->cost)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    for (index_y = 0; index_y < grid->height; index_y += 1)
+    {
+        for (index_x = 0; index_x < grid->width; index_x += 1)
+        {
+            grid->cost[(index_y * grid->width) + index_x] = get_cell_cost(index_x, index_y, core);
+        }
+    }
+
+    // [2] Clusters, nodes and search state.
+    grid->cluster = (path_cluster_t*)arena_calloc(map->arena, (size_t)cluster_count, sizeof(struct path_cluster));
+    grid->node    = (path_node_t*)arena_calloc(map->arena, (size_t)cluster_count * PATH_NODE_MAX, sizeof(struct path_node));
+    grid->cache   = (path_entry_t*)arena_calloc(map->arena, PATH_CACHE_SIZE, sizeof(struct path_entry));
+    if (! grid->cluster || ! grid->node || ! grid->cache)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    if (CORE_OK != init_search(&grid->abstract, (cluster_count * PATH_NODE_MAX) + 1, map->arena) ||
+        CORE_OK != init_search(&grid->local, PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE, map->arena))
+    {
+        return CORE_ERROR;
+    }
+
+    // [3] Entrance graph.
+    for (index = 0; index < cluster_count; index += 1)
+    {
+        grid->cluster[index].is_dirty = SDL_TRUE;
+    }
+    grid->has_dirty_cluster = SDL_TRUE;
+
+    if (CORE_OK != rebuild_clusters(grid))
+    {
+        return CORE_ERROR;
+    }
+
+    dbgprint("Load path grid: %dx%d cluster(s).", grid->cluster_count_x, grid->cluster_count_y);
+
+    return CORE_OK;
+}
+
+void free_path_grid(core_t* core)
+{
+    path_grid_t* grid = &core->map->path_grid;
+    Sint32       index;
+
+    if (grid->cluster)
+    {
+        for (index = 0; index < grid->cluster_count_x * grid->cluster_count_y; index += 1)
+        {
+            free(grid->cluster[index].distance);
+            grid->cluster[index].distance = NULL;
+        }
+    }
+
+    if (grid->cache)
+    {
+        for (index = 0; index < PATH_CACHE_SIZE; index += 1)
+        {
+            free(grid->cache[index].point);
+            grid->cache[index].point = NULL;
+        }
+    }
+}
+
+Uint8 get_path_cost(Sint32 index_x, Sint32 index_y, core_t* core)
+{
+    return get_cost(&core->map->path_grid, index_x, index_y);
+}
+
+// Override the cost of a cell, e.g. for a door, until its next update_path_cells.
+void set_path_cost(Sint32 index_x, Sint32 index_y, Uint8 cost, core_t* core)
+{
+    path_grid_t* grid = &core->map->path_grid;
+
+    if (! grid->cost || 0 > index_x || 0 > index_y || index_x >= grid->width || index_y >= grid->height)
+    {
+        return;
+    }
+
+    if (cost != grid->cost[(index_y * grid->width) + index_x])
+    {
+        grid->epoch                                   += 1;
+        grid->cost[(index_y * grid->width) + index_x]  = cost;
+        mark_cell_changed(grid, index_x, index_y);
+    }
+}
+
+// Derive the costs of a range of cells from their tiles again.
+void update_path_cells(const SDL_Rect* range, core_t* core)
+{
+    path_grid_t* grid = &core->map->path_grid;
+    Sint32       first_x;
+    Sint32       first_y;
+    Sint32       last_x;
+    Sint32       last_y;
+    Sint32       index_x;
+    Sint32       index_y;
+
+    if (! grid->cost)
+    {
+        return;
+    }
+
+    first_x = SDL_max(range->x, 0);
+    first_y = SDL_max(range->y, 0);
+    last_x  = SDL_min(range->x + range->w, grid->width);
+    last_y  = SDL_min(range->y + range->h, grid->height);
+
+    grid->epoch += 1;
+
+    for (index_y = first_y; index_y < last_y; index_y += 1)
+    {
+        for (index_x = first_x; index_x < last_x; index_x += 1)
+        {
+            Uint8 cost = get_cell_cost(index_x, index_y, core);
+
+            if (cost != grid->cost[(index_y * grid->width) + index_x])
+            {
+                grid->cost[(index_y * grid->width) + index_x] = cost;
+                mark_cell_changed(grid, index_x, index_y);
+            }
+        }
+    }
+}
+
+/* Store up to max_count cells of a path from start to goal, both
+ * included, in path.  Returns the number of cells of the path, which
+ * may exceed max_count, or 0 if there is none.
+ */
+Sint32 find_path(const SDL_Point* start, const SDL_Point* goal, SDL_Point* path, Sint32 max_count, core_t* core)
+{
+    path_grid_t*  grid = &core->map->path_grid;
+    path_entry_t* entry;
+    path_buffer_t buffer;
+    Sint32        node;
+    Sint32        start_index;
+    Sint32        goal_index;
+    Sint32        cluster;
+
+    if (0 == get_cost(grid, start->x, start->y) || 0 == get_cost(grid, goal->x, goal->y))
+    {
+        return 0;
+    }
+
+    if (grid->has_dirty_cluster && CORE_OK != rebuild_clusters(grid))
+    {
+        return 0;
+    }
+
+    // [1] Cached path.
+    start_index = (start->y * grid->width) + start->x;
+    goal_index  = (goal->y  * grid->width) + goal->x;
+    entry       = &grid->cache[(((Uint32)start_index * 2654435761u) ^ (Uint32)goal_index) & (PATH_CACHE_SIZE - 1)];
+
+    if (entry->point && start_index == entry->start && goal_index == entry->goal && is_cached_path_valid(grid, entry))
+    {
+        grid->hit_count += 1;
+        SDL_memcpy(path, entry->point, (size_t)SDL_min(entry->count, max_count) * sizeof(SDL_Point));
+        return entry->count;
+    }
+    grid->miss_count += 1;
+
+    SDL_zero(buffer);
+    if (CORE_OK != reserve_path(&buffer, 1))
+    {
+        return 0;
+    }
+    buffer.point[0] = *start;
+    buffer.count    = 1;
+
+    // [2] Within the cluster of the start, if the goal is there.
+    cluster = get_cluster(grid, start->x, start->y);
+    if (cluster == get_cluster(grid, goal->x, goal->y) && PATH_COST_NONE != search_cluster(grid, cluster, start, goal))
+    {
+        if (CORE_OK != append_cluster_path(grid, cluster, goal, &buffer))
+        {
+            free(buffer.point);
+            return 0;
+        }
+    }
+    // [3] Through the entrance graph.
+    else
+    {
+        node = search_nodes(grid, start, goal);
+        if (0 > node || CORE_OK != refine_path(grid, node, start, goal, &buffer))
+        {
+            free(buffer.point);
+            return 0;
+        }
+    }
+
+    free(entry->point);
+    entry->point = buffer.point;
+    entry->count = buffer.count;
+    entry->start = start_index;
+    entry->goal  = goal_index;
+    entry->epoch = grid->epoch;
+
+    SDL_memcpy(path, buffer.point, (size_t)SDL_min(buffer.count, max_count) * sizeof(SDL_Point));
+
+    return buffer.count;
+}
+
+// Costs per gid, from tile flags, properties and terrain.
+static status_t load_gid_costs(core_t* core)
+{
+    map_t*       map  = core->map;
+    path_grid_t* grid = &map->path_grid;
+    Uint8        terrain_cost[15];
+    Uint64       move_cost_hash = generate_hash((const unsigned char*)"move_cost");
+    Sint32       gid;
+    Sint32       index;
+
+    grid->gid_cost = (Uint8*)arena_calloc(map->arena, (size_t)map->render_list.gid_count, sizeof(Uint8));
+    if (! grid->gid_cost)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    for (index = 0; index < 15; index += 1)
+    {
+        char                    name[32];
+        const property_entry_t* property;
+
+        SDL_snprintf(name, sizeof(name), "terrain_%d_cost", index);
+        property = find_property(&map->property, PROPERTY_OWNER_MAP, generate_hash((const unsigned char*)name));
+
+        terrain_cost[index] = (property && PT_INT == property->type) ? (Uint8)SDL_clamp(property->value.integer, 0, 255) : 0;
+    }
+
+    for (gid = 0; gid < map->render_list.gid_count; gid += 1)
+    {
+        Uint32                  flags    = get_tile_flags(gid, core);
+        const property_entry_t* property = NULL;
+        Uint8                   cost     = (flags & TILE_FLAG_HAZARD) ? PATH_COST_HAZARD : 1;
+
+        if (flags & TILE_FLAG_HAS_PROPERTIES)
+        {
+            property = find_property(&map->property, PROPERTY_OWNER_TILE(gid), move_cost_hash);
+        }
+
+        if (flags & TILE_FLAG_SOLID)
+        {
+            cost = 0;
+        }
+        else if (property && PT_INT == property->type)
+        {
+            cost = (Uint8)SDL_clamp(property->value.integer, 0, 255);
+        }
+        else if (flags & TILE_FLAG_HAS_TERRAIN)
+        {
+            tile_corner corner;
+
+            for (corner = TILE_CORNER_TOP_LEFT; corner < TILE_CORNER_MAX; corner = (tile_corner)(corner + 1))
+            {
+                Sint32 terrain = get_tile_terrain(gid, corner, core);
+
+                if (TILE_TERRAIN_NONE != terrain)
+                {
+                    cost = SDL_max(cost, terrain_cost[terrain]);
+                }
+            }
+        }
+
+        grid->gid_cost[gid] = cost;
+    }
+
+    return CORE_OK;
+}
+
+static Uint8 get_cell_cost(Sint32 index_x, Sint32 index_y, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    Uint8          cost = 0;
+    Sint32         layer_index;
+
+    for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+    {
+        Uint16 gid = get_render_list_gid(list, layer_index, index_x, index_y);
+
+        if (0 == gid)
+        {
+            continue;
+        }
+        if (0 == core->map->path_grid.gid_cost[gid])
+        {
+            return 0;
+        }
+        cost = SDL_max(cost, core->map->path_grid.gid_cost[gid]);
+    }
+
+    return cost ? cost : 1;
+}
+
+static Uint8 get_cost(const path_grid_t* grid, Sint32 index_x, Sint32 index_y)
+{
+    if (! grid->cost || 0 > index_x || 0 > index_y || index_x >= grid->width || index_y >= grid->height)
+    {
+        return 0;
+    }
+
+    return grid->cost[(index_y * grid->width) + index_x];
+}
+
+static Sint32 get_cluster(const path_grid_t* grid, Sint32 index_x, Sint32 index_y)
+{
+    return ((index_y / PATH_CLUSTER_SIZE) * grid->cluster_count_x) + (index_x / PATH_CLUSTER_SIZE);
+}
+
+static void get_cluster_rect(const path_grid_t* grid, Sint32 cluster, SDL_Rect* rect)
+{
+    rect->x = (cluster % grid->cluster_count_x) * PATH_CLUSTER_SIZE;
+    rect->y = (cluster / grid->cluster_count_x) * PATH_CLUSTER_SIZE;
+    rect->w = SDL_min(PATH_CLUSTER_SIZE, grid->width  - rect->x);
+    rect->h = SDL_min(PATH_CLUSTER_SIZE, grid->height - rect->y);
+}
+
+/* The cluster of the cell has to be rebuilt, and so do its neighbours
+ * if the cell is on their border, as the entrances between them may
+ * have moved.  Only the cluster itself has changed cells, though.
+ */
+static void mark_cell_changed(path_grid_t* grid, Sint32 index_x, Sint32 index_y)
+{
+    Sint32 cluster   = get_cluster(grid, index_x, index_y);
+    Sint32 cluster_x = index_x / PATH_CLUSTER_SIZE;
+    Sint32 cluster_y = index_y / PATH_CLUSTER_SIZE;
+
+    grid->cluster[cluster].changed_at = grid->epoch;
+    grid->cluster[cluster].is_dirty   = SDL_TRUE;
+    grid->has_dirty_cluster           = SDL_TRUE;
+
+    if (0 == index_x % PATH_CLUSTER_SIZE && 0 < cluster_x)
+    {
+        grid->cluster[cluster - 1].is_dirty = SDL_TRUE;
+    }
+    if (PATH_CLUSTER_SIZE - 1 == index_x % PATH_CLUSTER_SIZE && cluster_x < grid->cluster_count_x - 1)
+    {
+        grid->cluster[cluster + 1].is_dirty = SDL_TRUE;
+    }
+    if (0 == index_y % PATH_CLUSTER_SIZE && 0 < cluster_y)
+    {
+        grid->cluster[cluster - grid->cluster_count_x].is_dirty = SDL_TRUE;
+    }
+    if (PATH_CLUSTER_SIZE - 1 == index_y % PATH_CLUSTER_SIZE && cluster_y < grid->cluster_count_y - 1)
+    {
+        grid->cluster[cluster + grid->cluster_count_x].is_dirty = SDL_TRUE;
+    }
+}
+
+/* Nodes of dirty clusters first, then the links of those and of their
+ * neighbours, whose nodes they refer to by index, then distances.
+ */
+static status_t rebuild_clusters(path_grid_t* grid)
+{
+    Sint32 cluster_count = grid->cluster_count_x * grid->cluster_count_y;
+    Sint32 index;
+
+    for (index = 0; index < cluster_count; index += 1)
+    {
+        if (grid->cluster[index].is_dirty)
+        {
+            build_cluster_nodes(grid, index);
+        }
+    }
+
+    for (index = 0; index < cluster_count; index += 1)
+    {
+        Sint32 cluster_x = index % grid->cluster_count_x;
+        Sint32 cluster_y = index / grid->cluster_count_x;
+
+        if (! grid->cluster[index].is_dirty)
+        {
+            continue;
+        }
+
+        link_cluster_nodes(grid, index);
+        if (0 < cluster_x)
+        {
+            link_cluster_nodes(grid, index - 1);
+        }
+        if (cluster_x < grid->cluster_count_x - 1)
+        {
+            link_cluster_nodes(grid, index + 1);
+        }
+        if (0 < cluster_y)
+        {
+            link_cluster_nodes(grid, index - grid->cluster_count_x);
+        }
+        if (cluster_y < grid->cluster_count_y - 1)
+        {
+            link_cluster_nodes(grid, index + grid->cluster_count_x);
+        }
+    }
+
+    for (index = 0; index < cluster_count; index += 1)
+    {
+        if (grid->cluster[index].is_dirty)
+        {
+            if (CORE_OK != build_cluster_distances(grid, index))
+            {
+                return CORE_ERROR;
+            }
+            grid->cluster[index].is_dirty = SDL_FALSE;
+        }
+    }
+    grid->has_dirty_cluster = SDL_FALSE;
+
+    return CORE_OK;
+}
+
+static void build_cluster_nodes(path_grid_t* grid, Sint32 cluster)
+{
+    path_side side;
+
+    grid->cluster[cluster].node_count = 0;
+
+    for (side = PATH_SIDE_TOP; side < PATH_SIDE_MAX; side = (path_side)(side + 1))
+    {
+        add_side_nodes(grid, cluster, side);
+    }
+}
+
+/* Both clusters of a border scan it in the same order, so they place
+ * their nodes facing each other.
+ */
+static void add_side_nodes(path_grid_t* grid, Sint32 cluster, path_side side)
+{
+    path_cluster_t* current = &grid->cluster[cluster];
+    SDL_Rect        rect;
+    Sint32          length;
+    Sint32          run     = 0;
+    Sint32          index;
+
+    get_cluster_rect(grid, cluster, &rect);
+    length = (PATH_SIDE_TOP == side || PATH_SIDE_BOTTOM == side) ? rect.w : rect.h;
+
+    for (index = 0; index <= length; index += 1)
+    {
+        Sint32   inside_x  = rect.x;
+        Sint32   inside_y  = rect.y;
+        Sint32   outside_x;
+        Sint32   outside_y;
+        SDL_bool is_open   = SDL_FALSE;
+        Sint32   first;
+        Sint32   last;
+        Sint32   entrance;
+
+        switch (side)
+        {
+            case PATH_SIDE_TOP:
+                inside_x += index;
+                break;
+            case PATH_SIDE_BOTTOM:
+                inside_x += index;
+                inside_y += rect.h - 1;
+                break;
+            case PATH_SIDE_LEFT:
+                inside_y += index;
+                break;
+            default:
+                inside_x += rect.w - 1;
+                inside_y += index;
+                break;
+        }
+        outside_x = inside_x + ((PATH_SIDE_LEFT == side) ? -1 : (PATH_SIDE_RIGHT  == side) ? 1 : 0);
+        outside_y = inside_y + ((PATH_SIDE_TOP  == side) ? -1 : (PATH_SIDE_BOTTOM == side) ? 1 : 0);
+
+        if (index < length && get_cost(grid, inside_x, inside_y) && get_cost(grid, outside_x, outside_y))
+        {
+            is_open = SDL_TRUE;
+        }
+
+        if (is_open)
+        {
+            run += 1;
+            continue;
+        }
+        if (0 == run)
+        {
+            continue;
+        }
+
+        // A run has ended: one entrance in its middle or one at each end.
+        first = index - run;
+        last  = index - 1;
+        run   = 0;
+
+        for (entrance = 0; entrance < 2; entrance += 1)
+        {
+            Sint32       offset;
+            path_node_t* node;
+
+            if (last - first + 1 < PATH_ENTRANCE_SPLIT)
+            {
+                if (0 < entrance)
+                {
+                    break;
+                }
+                offset = (first + last) / 2;
+            }
+            else
+            {
+                offset = entrance ? last : first;
+            }
+
+            node          = &grid->node[(cluster * PATH_NODE_MAX) + current->node_count];
+            node->index_x = (Sint16)((PATH_SIDE_TOP == side || PATH_SIDE_BOTTOM == side) ? rect.x + offset : inside_x);
+            node->index_y = (Sint16)((PATH_SIDE_TOP == side || PATH_SIDE_BOTTOM == side) ? inside_y : rect.y + offset);
+            node->link    = -1;
+            node->side    = (Uint8)side;
+
+            current->node_count += 1;
+        }
+    }
+}
+
+static void link_cluster_nodes(path_grid_t* grid, Sint32 cluster)
+{
+    path_cluster_t* current = &grid->cluster[cluster];
+    Sint32          index;
+
+    for (index = 0; index < current->node_count; index += 1)
+    {
+        path_node_t* node      = &grid->node[(cluster * PATH_NODE_MAX) + index];
+        Sint32       outside_x = node->index_x;
+        Sint32       outside_y = node->index_y;
+        Sint32       neighbour;
+        path_side    opposite;
+        Sint32       other;
+
+        switch ((path_side)node->side)
+        {
+            case PATH_SIDE_TOP:
+                outside_y -= 1;
+                opposite   = PATH_SIDE_BOTTOM;
+                break;
+            case PATH_SIDE_BOTTOM:
+                outside_y += 1;
+                opposite   = PATH_SIDE_TOP;
+                break;
+            case PATH_SIDE_LEFT:
+                outside_x -= 1;
+                opposite   = PATH_SIDE_RIGHT;
+                break;
+            default:
+                outside_x += 1;
+                opposite   = PATH_SIDE_LEFT;
+                break;
+        }
+
+        neighbour  = get_cluster(grid, outside_x, outside_y);
+        node->link = -1;
+
+        for (other = 0; other < grid->cluster[neighbour].node_count; other += 1)
+        {
+            const path_node_t* candidate = &grid->node[(neighbour * PATH_NODE_MAX) + other];
+
+            if (candidate->index_x == outside_x && candidate->index_y == outside_y && candidate->side == (Uint8)opposite)
+            {
+                node->link      = (neighbour * PATH_NODE_MAX) + other;
+                node->link_cost = (Uint16)(5 * (get_cost(grid, node->index_x, node->index_y) + get_cost(grid, outside_x, outside_y)));
+                break;
+            }
+        }
+    }
+}
+
+static status_t build_cluster_distances(path_grid_t* grid, Sint32 cluster)
+{
+    path_cluster_t* current = &grid->cluster[cluster];
+    Sint32          from;
+    Sint32          to;
+
+    free(current->distance);
+    current->distance = NULL;
+
+    if (0 == current->node_count)
+    {
+        return CORE_OK;
+    }
+
+    current->distance = (Uint32*)malloc((size_t)(current->node_count * current->node_count) * sizeof(Uint32));
+    if (! current->distance)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        current->node_count = 0;
+        return CORE_ERROR;
+    }
+
+    for (from = 0; from < current->node_count; from += 1)
+    {
+        const path_node_t* node = &grid->node[(cluster * PATH_NODE_MAX) + from];
+        SDL_Point          cell;
+
+        cell.x = node->index_x;
+        cell.y = node->index_y;
+        search_cluster(grid, cluster, &cell, NULL);
+
+        for (to = 0; to < current->node_count; to += 1)
+        {
+            const path_node_t* other = &grid->node[(cluster * PATH_NODE_MAX) + to];
+
+            current->distance[(from * current->node_count) + to] = get_cluster_cost(grid, cluster, other->index_x, other->index_y);
+        }
+    }
+
+    return CORE_OK;
+}
+
+static status_t init_search(path_search_t* search, Sint32 capacity, arena_t* arena)
+{
+    search->cost       = (Uint32*)arena_calloc(arena, (size_t)capacity, sizeof(Uint32));
+    search->score      = (Uint32*)arena_calloc(arena, (size_t)capacity, sizeof(Uint32));
+    search->parent     = (Sint32*)arena_calloc(arena, (size_t)capacity, sizeof(Sint32));
+    search->heap       = (Sint32*)arena_calloc(arena, (size_t)capacity, sizeof(Sint32));
+    search->heap_index = (Sint32*)arena_calloc(arena, (size_t)capacity, sizeof(Sint32));
+    search->stamp      = (Uint32*)arena_calloc(arena, (size_t)capacity, sizeof(Uint32));
+    search->capacity   = capacity;
+
+    if (! search->cost || ! search->score || ! search->parent || ! search->heap || ! search->heap_index || ! search->stamp)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    return CORE_OK;
+}
+
+static void reset_search(path_search_t* search)
+{
+    search->current   += 1;
+    search->heap_count = 0;
+
+    if (0 == search->current)
+    {
+        SDL_memset(search->stamp, 0, (size_t)search->capacity * sizeof(Uint32));
+        search->current = 1;
+    }
+}
+
+static Uint32 get_search_cost(const path_search_t* search, Sint32 node)
+{
+    return (search->stamp[node] == search->current) ? search->cost[node] : PATH_COST_NONE;
+}
+
+static void update_search(path_search_t* search, Sint32 node, Uint32 cost, Uint32 estimate, Sint32 parent)
+{
+    if (search->stamp[node] != search->current)
+    {
+        search->stamp[node]      = search->current;
+        search->cost[node]       = PATH_COST_NONE;
+        search->heap_index[node] = PATH_HEAP_OPEN;
+    }
+
+    if (cost >= search->cost[node] || PATH_HEAP_DONE == search->heap_index[node])
+    {
+        return;
+    }
+
+    search->cost[node]   = cost;
+    search->score[node]  = cost + estimate;
+    search->parent[node] = parent;
+
+    if (PATH_HEAP_OPEN == search->heap_index[node])
+    {
+        search->heap_index[node]          = search->heap_count;
+        search->heap[search->heap_count]  = node;
+        search->heap_count               += 1;
+    }
+    sift_up(search, search->heap_index[node]);
+}
+
+static Sint32 pop_search(path_search_t* search)
+{
+    Sint32 node = search->heap[0];
+
+    search->heap_count -= 1;
+    if (0 < search->heap_count)
+    {
+        search->heap[0]                     = search->heap[search->heap_count];
+        search->heap_index[search->heap[0]] = 0;
+        sift_down(search, 0);
+    }
+    search->heap_index[node] = PATH_HEAP_DONE;
+
+    return node;
+}
+
+static void sift_up(path_search_t* search, Sint32 position)
+{
+    Sint32 node = search->heap[position];
+
+    while (0 < position)
+    {
+        Sint32 parent = (position - 1) / 2;
+
+        if (search->score[search->heap[parent]] <= search->score[node])
+        {
+            break;
+        }
+        search->heap[position]                     = search->heap[parent];
+        search->heap_index[search->heap[position]] = position;
+        position                                   = parent;
+    }
+    search->heap[position]   = node;
+    search->heap_index[node] = position;
+}
+
+static void sift_down(path_search_t* search, Sint32 position)
+{
+    Sint32 node = search->heap[position];
+
+    for (;;)
+    {
+        Sint32 child = (position * 2) + 1;
+
+        if (child >= search->heap_count)
+        {
+            break;
+        }
+        if (child + 1 < search->heap_count && search->score[search->heap[child + 1]] < search->score[search->heap[child]])
+        {
+            child += 1;
+        }
+        if (search->score[node] <= search->score[search->heap[child]])
+        {
+            break;
+        }
+        search->heap[position]                     = search->heap[child];
+        search->heap_index[search->heap[position]] = position;
+        position                                   = child;
+    }
+    search->heap[position]   = node;
+    search->heap_index[node] = position;
+}
+
+// Octile distance at the lowest step costs, 10 straight and 14 diagonally.
+static Uint32 get_estimate(Sint32 from_x, Sint32 from_y, Sint32 to_x, Sint32 to_y)
+{
+    Uint32 delta_x = (Uint32)SDL_abs(to_x - from_x);
+    Uint32 delta_y = (Uint32)SDL_abs(to_y - from_y);
+
+    return (10 * SDL_max(delta_x, delta_y)) + (4 * SDL_min(delta_x, delta_y));
+}
+
+/* Search the cells of a cluster from a cell: A* towards to if given,
+ * otherwise Dijkstra over the whole cluster.  Returns the cost to to,
+ * if given.  The costs stay in the local search, see get_cluster_cost.
+ */
+static Uint32 search_cluster(path_grid_t* grid, Sint32 cluster, const SDL_Point* from, const SDL_Point* to)
+{
+    path_search_t* search = &grid->local;
+    SDL_Rect       rect;
+    Sint32         target = -1;
+
+    get_cluster_rect(grid, cluster, &rect);
+    reset_search(search);
+
+    if (to)
+    {
+        target = ((to->y - rect.y) * PATH_CLUSTER_SIZE) + (to->x - rect.x);
+    }
+
+    update_search(search, ((from->y - rect.y) * PATH_CLUSTER_SIZE) + (from->x - rect.x), 0, 0, -1);
+
+    while (0 < search->heap_count)
+    {
+        Sint32 cell    = pop_search(search);
+        Sint32 index_x = rect.x + (cell % PATH_CLUSTER_SIZE);
+        Sint32 index_y = rect.y + (cell / PATH_CLUSTER_SIZE);
+        Uint32 cost    = search->cost[cell];
+        Sint32 step;
+
+        if (cell == target)
+        {
+            return cost;
+        }
+
+        for (step = 0; step < 8; step += 1)
+        {
+            Sint32 next_x = index_x + step_x[step];
+            Sint32 next_y = index_y + step_y[step];
+            Uint8  next_cost;
+
+            if (next_x < rect.x || next_y < rect.y || next_x >= rect.x + rect.w || next_y >= rect.y + rect.h)
+            {
+                continue;
+            }
+
+            next_cost = get_cost(grid, next_x, next_y);
+            if (0 == next_cost)
+            {
+                continue;
+            }
+
+            // Diagonal steps must not cut the corner of a blocked cell.
+            if (4 <= step && (0 == get_cost(grid, next_x, index_y) || 0 == get_cost(grid, index_x, next_y)))
+            {
+                continue;
+            }
+
+            update_search(search,
+                          ((next_y - rect.y) * PATH_CLUSTER_SIZE) + (next_x - rect.x),
+                          cost + ((4 <= step ? 7u : 5u) * (Uint32)(get_cost(grid, index_x, index_y) + next_cost)),
+                          to ? get_estimate(next_x, next_y, to->x, to->y) : 0,
+                          cell);
+        }
+    }
+
+    return PATH_COST_NONE;
+}
+
+static Uint32 get_cluster_cost(const path_grid_t* grid, Sint32 cluster, Sint32 index_x, Sint32 index_y)
+{
+    SDL_Rect rect;
+
+    get_cluster_rect(grid, cluster, &rect);
+
+    return get_search_cost(&grid->local, ((index_y - rect.y) * PATH_CLUSTER_SIZE) + (index_x - rect.x));
+}
+
+/* A* over the nodes.  The start is connected to the nodes of its
+ * cluster and the goal, the last node of the abstract search, to
+ * those of its own.  On success, the parents of the nodes of the path
+ * are reversed, so they lead from the first node, which is returned,
+ * to the goal.  Returns -1 if there is no path.
+ */
+static Sint32 search_nodes(path_grid_t* grid, const SDL_Point* start, const SDL_Point* goal)
+{
+    path_search_t* search        = &grid->abstract;
+    Sint32         goal_node     = search->capacity - 1;
+    Sint32         start_cluster = get_cluster(grid, start->x, start->y);
+    Sint32         goal_cluster  = get_cluster(grid, goal->x, goal->y);
+    Uint32         goal_cost[PATH_NODE_MAX];
+    Sint32         node;
+    Sint32         next;
+    Sint32         index;
+
+    reset_search(search);
+
+    search_cluster(grid, start_cluster, start, NULL);
+    for (index = 0; index < grid->cluster[start_cluster].node_count; index += 1)
+    {
+        const path_node_t* entrance = &grid->node[(start_cluster * PATH_NODE_MAX) + index];
+        Uint32             cost     = get_cluster_cost(grid, start_cluster, entrance->index_x, entrance->index_y);
+
+        if (PATH_COST_NONE != cost)
+        {
+            update_search(search, (start_cluster * PATH_NODE_MAX) + index, cost,
+                          get_estimate(entrance->index_x, entrance->index_y, goal->x, goal->y), -1);
+        }
+    }
+
+    // Costs are symmetric, so the costs from the goal are those to it.
+    search_cluster(grid, goal_cluster, goal, NULL);
+    for (index = 0; index < grid->cluster[goal_cluster].node_count; index += 1)
+    {
+        const path_node_t* entrance = &grid->node[(goal_cluster * PATH_NODE_MAX) + index];
+
+        goal_cost[index] = get_cluster_cost(grid, goal_cluster, entrance->index_x, entrance->index_y);
+    }
+
+    while (0 < search->heap_count)
+    {
+        const path_cluster_t* current;
+        const path_node_t*    entrance;
+        Sint32                cluster;
+        Sint32                slot;
+        Uint32                cost;
+
+        node = pop_search(search);
+        if (node == goal_node)
+        {
+            break;
+        }
+
+        cluster  = node / PATH_NODE_MAX;
+        slot     = node % PATH_NODE_MAX;
+        current  = &grid->cluster[cluster];
+        entrance = &grid->node[node];
+        cost     = search->cost[node];
+
+        for (index = 0; index < current->node_count; index += 1)
+        {
+            Uint32 distance = current->distance[(slot * current->node_count) + index];
+
+            if (index != slot && PATH_COST_NONE != distance)
+            {
+                const path_node_t* other = &grid->node[(cluster * PATH_NODE_MAX) + index];
+
+                update_search(search, (cluster * PATH_NODE_MAX) + index, cost + distance,
+                              get_estimate(other->index_x, other->index_y, goal->x, goal->y), node);
+            }
+        }
+
+        if (0 <= entrance->link)
+        {
+            const path_node_t* other = &grid->node[entrance->link];
+
+            update_search(search, entrance->link, cost + entrance->link_cost,
+                          get_estimate(other->index_x, other->index_y, goal->x, goal->y), node);
+        }
+
+        if (cluster == goal_cluster && PATH_COST_NONE != goal_cost[slot])
+        {
+            update_search(search, goal_node, cost + goal_cost[slot], 0, node);
+        }
+    }
+
+    if (PATH_COST_NONE == get_search_cost(search, goal_node))
+    {
+        return -1;
+    }
+
+    node = goal_node;
+    next = -1;
+    while (-1 != node)
+    {
+        Sint32 previous = search->parent[node];
+
+        search->parent[node] = next;
+        next                 = node;
+        node                 = previous;
+    }
+
+    return next;
+}
+
+/* Walk the nodes found by search_nodes: steps across a border are
+ * taken as they are, steps within a cluster are searched on the grid.
+ */
+static status_t refine_path(path_grid_t* grid, Sint32 node, const SDL_Point* start, const SDL_Point* goal, path_buffer_t* buffer)
+{
+    path_search_t* search    = &grid->abstract;
+    Sint32         goal_node = search->capacity - 1;
+    SDL_Point      cell      = *start;
+    Sint32         cluster;
+
+    for (; node != goal_node; node = search->parent[node])
+    {
+        SDL_Point next;
+
+        cluster = node / PATH_NODE_MAX;
+        next.x  = grid->node[node].index_x;
+        next.y  = grid->node[node].index_y;
+
+        if (get_cluster(grid, cell.x, cell.y) != cluster)
+        {
+            if (CORE_OK != reserve_path(buffer, buffer->count + 1))
+            {
+                return CORE_ERROR;
+            }
+            buffer->point[buffer->count]  = next;
+            buffer->count                += 1;
+        }
+        else if (PATH_COST_NONE == search_cluster(grid, cluster, &cell, &next) ||
+                 CORE_OK != append_cluster_path(grid, cluster, &next, buffer))
+        {
+            return CORE_ERROR;
+        }
+
+        cell = next;
+    }
+
+    cluster = get_cluster(grid, goal->x, goal->y);
+    if (PATH_COST_NONE == search_cluster(grid, cluster, &cell, goal) ||
+        CORE_OK != append_cluster_path(grid, cluster, goal, buffer))
+    {
+        return CORE_ERROR;
+    }
+
+    return CORE_OK;
+}
+
+// Append the cells found by search_cluster on the way to to, without the first.
+static status_t append_cluster_path(path_grid_t* grid, Sint32 cluster, const SDL_Point* to, path_buffer_t* buffer)
+{
+    path_search_t* search = &grid->local;
+    SDL_Rect       rect;
+    Sint32         target;
+    Sint32         cell;
+    Sint32         count  = 0;
+    Sint32         position;
+
+    get_cluster_rect(grid, cluster, &rect);
+    target = ((to->y - rect.y) * PATH_CLUSTER_SIZE) + (to->x - rect.x);
+
+    for (cell = target; -1 != search->parent[cell]; cell = search->parent[cell])
+    {
+        count += 1;
+    }
+
+    if (CORE_OK != reserve_path(buffer, buffer->count + count))
+    {
+        return CORE_ERROR;
+    }
+
+    position = buffer->count + count - 1;
+    for (cell = target; -1 != search->parent[cell]; cell = search->parent[cell])
+    {
+        buffer->point[position].x = rect.x + (cell % PATH_CLUSTER_SIZE);
+        buffer->point[position].y = rect.y + (cell / PATH_CLUSTER_SIZE);
+        position                 -= 1;
+    }
+    buffer->count += count;
+
+    return CORE_OK;
+}
+
+static status_t reserve_path(path_buffer_t* buffer, Sint32 count)
+{
+    SDL_Point* point;
+    Sint32     capacity = buffer->capacity ? buffer->capacity : 64;
+
+    if (count <= buffer->capacity)
+    {
+        return CORE_OK;
+    }
+
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+
+    point = (SDL_Point*)realloc(buffer->point, (size_t)capacity * sizeof(SDL_Point));
+    if (! point)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+    buffer->point    = point;
+    buffer->capacity = capacity;
+
+    return CORE_OK;
+}
+
+// A cached path stays valid unless the cells of a cluster it crosses have changed since.
+static SDL_bool is_cached_path_valid(const path_grid_t* grid, const path_entry_t* entry)
+{
+    Sint32 index;
+
+    for (index = 0; index < entry->count; index += 1)
+    {
+        if (grid->cluster[get_cluster(grid, entry->point[index].x, entry->point[index].y)].changed_at > entry->epoch)
+        {
+            return SDL_FALSE;
+        }
+    }
+
+    return SDL_TRUE;
+}
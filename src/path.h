@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef PATH_H
+#define PATH_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Hierarchical pathfinding (HPA*) over the tile grid.
+ *
+ * Every cell has a movement cost, 0 if blocked and 1 to 255 otherwise:
+ * the highest cost of its tiles over all layers, or 1 without tiles.
+ * is_solid tiles block, tiles with an integer move_cost property cost
+ * that, tiles of a terrain with an integer terrain_<index>_cost map
+ * property cost that, is_hazard tiles cost PATH_COST_HAZARD and other
+ * tiles 1.  Agents move in eight directions without cutting corners; a
+ * step costs the costs of both cells summed, times 5 or 7 diagonally.
+ *
+ * The grid is split into clusters of PATH_CLUSTER_SIZE cells.  Each
+ * run of walkable cells facing each other across a cluster border gets
+ * an entrance in its middle, or at both ends if it is at least
+ * PATH_ENTRANCE_SPLIT cells long, with a node on either side.  The
+ * costs between the nodes of a cluster are precomputed, so find_path
+ * runs A* on these nodes and only searches the grid within single
+ * clusters: around the start and the goal, and to refine each step.
+ * Paths are close to, but not always, the cheapest.
+ *
+ * Paths are cached by start and goal.  After tiles have changed, call
+ * update_path_cells: the affected clusters are rebuilt before the next
+ * query, and only cached paths crossing changed clusters are dropped.
+ *
+ * Positions are cell indices in the map.  The search state is kept in
+ * the map, so queries must not run on several threads at once.
+ * Streamed maps, see stream.h, have no grid and no paths.
+ */
+
+#define PATH_CLUSTER_SIZE   16
+#define PATH_SIDE_NODE_MAX  (PATH_CLUSTER_SIZE / 2)
+#define PATH_NODE_MAX       (4 * PATH_SIDE_NODE_MAX)
+#define PATH_ENTRANCE_SPLIT 6
+#define PATH_COST_HAZARD    8
+#define PATH_CACHE_SIZE     256
+
+status_t load_path_grid(core_t* core);
+void     free_path_grid(core_t* core);
+Uint8    get_path_cost(Sint32 index_x, Sint32 index_y, core_t* core);
+void     set_path_cost(Sint32 index_x, Sint32 index_y, Uint8 cost, core_t* core);
+void     update_path_cells(const SDL_Rect* range, core_t* core);
+Sint32   find_path(const SDL_Point* start, const SDL_Point* goal, SDL_Point* path, Sint32 max_count, core_t* core);
+
+#endif /* PATH_H */
@@ -0,0 +1,407 @@
+// SPDX-License-Identifier: MIT
+
+#include <stdio.h>
+#include <SDL.h>
+#include "core.h"
+#include "input.h"
+#include "profile.h"
+
+#ifdef PROFILE_ENABLED
+
+#define PROFILE_OVERLAY_WIDTH 176
+#define PROFILE_SEGMENT_MAX   6
+
+static const char* zone_name[PROFILE_ZONE_MAX] =
+{
+    "update_core",
+    "animation",
+    "render_scene",
+    "render_map_bg",
+    "render_map_fg",
+    "draw_scene"
+};
+
+static const char* counter_name[PROFILE_COUNTER_MAX] =
+{
+    "render_copy",
+    "target_switch",
+    "texture_bytes"
+};
+
+// Counter bars along the top of the overlay: units per pixel and color.
+static const Uint32 counter_scale[PROFILE_COUNTER_MAX] = { 1, 1, 256 };
+static const Uint32 counter_color[PROFILE_COUNTER_MAX] = { 0x00ffff, 0xff00ff, 0xffff00 };
+
+// Graph segments, bottom to top, see get_segment_ticks.
+static const Uint32 segment_color[PROFILE_SEGMENT_MAX] = { 0xff8000, 0x00c000, 0x0080ff, 0x808080, 0xff0000, 0xc0c0c0 };
+
+static profile_frame_t* get_current_frame(profiler_t* profiler);
+static Uint64           get_segment_ticks(const profile_frame_t* frame, Sint32 segment);
+static double           get_us(Uint64 ticks, profiler_t* profiler);
+static void             set_draw_color(Uint32 color, Uint8 alpha, core_t* core);
+
+status_t init_profiler(core_t* core)
+{
+    profiler_t* profiler = (profiler_t*)calloc(1, sizeof(struct profiler));
+
+    if (! profiler)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    profiler->frame        = (profile_frame_t*)calloc(PROFILE_FRAME_MAX, sizeof(struct profile_frame));
+    profiler->event        = (profile_event_t*)calloc(PROFILE_EVENT_MAX, sizeof(struct profile_event));
+    profiler->overlay_rect = (SDL_Rect*)calloc(PROFILE_OVERLAY_WIDTH, sizeof(SDL_Rect));
+    if (! profiler->frame || ! profiler->event || ! profiler->overlay_rect)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        free(profiler->overlay_rect);
+        free(profiler->event);
+        free(profiler->frame);
+        free(profiler);
+        return CORE_ERROR;
+    }
+
+    profiler->frequency = SDL_GetPerformanceFrequency();
+    profiler->origin    = SDL_GetPerformanceCounter();
+    core->profiler      = profiler;
+
+    return CORE_OK;
+}
+
+void free_profiler(core_t* core)
+{
+    if (! core->profiler)
+    {
+        return;
+    }
+
+    free(core->profiler->overlay_rect);
+    free(core->profiler->event);
+    free(core->profiler->frame);
+    free(core->profiler);
+    core->profiler = NULL;
+}
+
+void begin_profile_frame(core_t* core)
+{
+    profile_frame_t* frame;
+
+    if (! core->profiler)
+    {
+        return;
+    }
+
+    // Zones and counts outside of a frame are dropped.
+    frame = get_current_frame(core->profiler);
+    SDL_zerop(frame);
+    frame->start = SDL_GetPerformanceCounter();
+
+    begin_profile_zone(PROFILE_UPDATE_CORE, core);
+}
+
+/* Close the frame and keep it.  The overlay is toggled here, once the
+ * input of the frame is known, and redrawn in every frame it is shown.
+ */
+void end_profile_frame(core_t* core)
+{
+    profiler_t* profiler = core->profiler;
+
+    if (! profiler)
+    {
+        return;
+    }
+
+    end_profile_zone(PROFILE_UPDATE_CORE, core);
+    profiler->frame_count += 1;
+
+    if (is_input_pressed(INPUT_OVERLAY, core))
+    {
+        profiler->is_overlay_visible = ! profiler->is_overlay_visible;
+        request_redraw(RENDER_CHANGE_ALL, core);
+    }
+    if (profiler->is_overlay_visible)
+    {
+        request_redraw(RENDER_CHANGE_OVERLAY, core);
+    }
+}
+
+void begin_profile_zone(profile_zone zone, core_t* core)
+{
+    if (! core->profiler)
+    {
+        return;
+    }
+
+    core->profiler->zone_start[zone] = SDL_GetPerformanceCounter();
+}
+
+void end_profile_zone(profile_zone zone, core_t* core)
+{
+    profiler_t*      profiler = core->profiler;
+    profile_event_t* event;
+    Uint64           now;
+
+    if (! profiler || 0 == profiler->zone_start[zone])
+    {
+        return;
+    }
+
+    now   = SDL_GetPerformanceCounter();
+    event = &profiler->event[profiler->event_count % PROFILE_EVENT_MAX];
+
+    event->start = profiler->zone_start[zone];
+    event->end   = now;
+    event->frame = profiler->frame_count;
+    event->zone  = zone;
+
+    get_current_frame(profiler)->zone_ticks[zone] += now - profiler->zone_start[zone];
+    profiler->zone_start[zone]                     = 0;
+    profiler->event_count                         += 1;
+}
+
+void add_profile_count(profile_counter counter, Uint32 value, core_t* core)
+{
+    if (! core->profiler)
+    {
+        return;
+    }
+
+    get_current_frame(core->profiler)->counter[counter] += value;
+}
+
+/* Draw the overlay onto the current render target, on top of the
+ * scene.  The frame being drawn is not complete yet, so the graph ends
+ * with the one before.
+ */
+void draw_profile_overlay(core_t* core)
+{
+    profiler_t*   profiler = core->profiler;
+    SDL_BlendMode blend_mode;
+    SDL_Rect      rect;
+    Uint8         red;
+    Uint8         green;
+    Uint8         blue;
+    Uint8         alpha;
+    Sint32        frame_count;
+    Sint32        segment;
+    Sint32        index;
+
+    if (! profiler || ! profiler->is_overlay_visible)
+    {
+        return;
+    }
+
+    SDL_GetRenderDrawColor(core->renderer, &red, &green, &blue, &alpha);
+    SDL_GetRenderDrawBlendMode(core->renderer, &blend_mode);
+    SDL_SetRenderDrawBlendMode(core->renderer, SDL_BLENDMODE_BLEND);
+
+    frame_count = (Sint32)SDL_min(profiler->frame_count, (Uint32)SDL_min(PROFILE_OVERLAY_WIDTH, PROFILE_FRAME_MAX));
+
+    // [1] Background and frame budget.
+    rect.x = 0;
+    rect.y = 208 - PROFILE_OVERLAY_HEIGHT;
+    rect.w = PROFILE_OVERLAY_WIDTH;
+    rect.h = PROFILE_OVERLAY_HEIGHT;
+    set_draw_color(0x000000, 0x80, core);
+    SDL_RenderFillRect(core->renderer, &rect);
+
+    rect.y = 208 - ((1000000 / CORE_MAX_FRAME_RATE) / PROFILE_OVERLAY_US_PER_PIXEL);
+    rect.h = 1;
+    set_draw_color(0xffffff, 0xff, core);
+    SDL_RenderFillRect(core->renderer, &rect);
+
+    // [2] Frame time graph, one batch of rectangles per segment.
+    for (segment = 0; segment < PROFILE_SEGMENT_MAX; segment += 1)
+    {
+        for (index = 0; index < frame_count; index += 1)
+        {
+            const profile_frame_t* frame  = &profiler->frame[(profiler->frame_count - (Uint32)frame_count + (Uint32)index) % PROFILE_FRAME_MAX];
+            Uint64                 bottom = 0;
+            Uint64                 top;
+            Sint32                 previous;
+
+            for (previous = 0; previous < segment; previous += 1)
+            {
+                bottom += get_segment_ticks(frame, previous);
+            }
+            top = bottom + get_segment_ticks(frame, segment);
+
+            profiler->overlay_rect[index].x = PROFILE_OVERLAY_WIDTH - frame_count + index;
+            profiler->overlay_rect[index].w = 1;
+            profiler->overlay_rect[index].y = 208 - (Sint32)SDL_min(get_us(top, profiler) / PROFILE_OVERLAY_US_PER_PIXEL, PROFILE_OVERLAY_HEIGHT);
+            profiler->overlay_rect[index].h = 208 - (Sint32)SDL_min(get_us(bottom, profiler) / PROFILE_OVERLAY_US_PER_PIXEL, PROFILE_OVERLAY_HEIGHT) - profiler->overlay_rect[index].y;
+        }
+
+        set_draw_color(segment_color[segment], 0xff, core);
+        SDL_RenderFillRects(core->renderer, profiler->overlay_rect, frame_count);
+    }
+
+    // [3] Counters of the last frame.
+    if (0 < frame_count)
+    {
+        const profile_frame_t* frame = &profiler->frame[(profiler->frame_count - 1) % PROFILE_FRAME_MAX];
+
+        for (index = 0; index < PROFILE_COUNTER_MAX; index += 1)
+        {
+            rect.x = 0;
+            rect.y = index * 3;
+            rect.w = (Sint32)SDL_min(frame->counter[index] / counter_scale[index], PROFILE_OVERLAY_WIDTH);
+            rect.h = 2;
+            set_draw_color(counter_color[index], 0xff, core);
+            SDL_RenderFillRect(core->renderer, &rect);
+        }
+    }
+
+    SDL_SetRenderDrawBlendMode(core->renderer, blend_mode);
+    SDL_SetRenderDrawColor(core->renderer, red, green, blue, alpha);
+}
+
+/* Write the recorded frames as CSV, one row per frame with its zone
+ * times in microseconds and its counters, and the recorded zones as
+ * Chrome trace events, with the counters as counter events.  Either
+ * file name may be NULL.
+ */
+status_t dump_profile(const char* csv_file_name, const char* trace_file_name, core_t* core)
+{
+    profiler_t* profiler = core->profiler;
+    Uint32      first_frame;
+    Uint32      first_event;
+    Uint32      index;
+    Sint32      column;
+    FILE*       fp;
+
+    if (! profiler)
+    {
+        return CORE_WARNING;
+    }
+
+    first_frame = (profiler->frame_count > PROFILE_FRAME_MAX) ? profiler->frame_count - PROFILE_FRAME_MAX : 0;
+    first_event = (profiler->event_count > PROFILE_EVENT_MAX) ? profiler->event_count - PROFILE_EVENT_MAX : 0;
+
+    if (csv_file_name)
+    {
+        fp = fopen(csv_file_name, "w");
+        if (! fp)
+        {
+            dbgprint("%s: could not create %s.", FUNCTION_NAME, csv_file_name);
+            return CORE_ERROR;
+        }
+
+        fprintf(fp, "frame,start_us");
+        for (column = 0; column < PROFILE_ZONE_MAX; column += 1)
+        {
+            fprintf(fp, ",%s_us", zone_name[column]);
+        }
+        for (column = 0; column < PROFILE_COUNTER_MAX; column += 1)
+        {
+            fprintf(fp, ",%s", counter_name[column]);
+        }
+        fprintf(fp, "\n");
+
+        for (index = first_frame; index < profiler->frame_count; index += 1)
+        {
+            const profile_frame_t* frame = &profiler->frame[index % PROFILE_FRAME_MAX];
+
+            fprintf(fp, "%u,%.1f", index, get_us(frame->start - profiler->origin, profiler));
+            for (column = 0; column < PROFILE_ZONE_MAX; column += 1)
+            {
+                fprintf(fp, ",%.1f", get_us(frame->zone_ticks[column], profiler));
+            }
+            for (column = 0; column < PROFILE_COUNTER_MAX; column += 1)
+            {
+                fprintf(fp, ",%u", frame->counter[column]);
+            }
+            fprintf(fp, "\n");
+        }
+        fclose(fp);
+    }
+
+    if (trace_file_name)
+    {
+        fp = fopen(trace_file_name, "w");
+        if (! fp)
+        {
+            dbgprint("%s: could not create %s.", FUNCTION_NAME, trace_file_name);
+            return CORE_ERROR;
+        }
+
+        fprintf(fp, "{\"traceEvents\":[\n");
+        fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}");
+
+        for (index = first_event; index < profiler->event_count; index += 1)
+        {
+            const profile_event_t* event = &profiler->event[index % PROFILE_EVENT_MAX];
+
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,\"args\":{\"frame\":%u}}",
+                    zone_name[event->zone],
+                    get_us(event->start - profiler->origin, profiler),
+                    get_us(event->end - event->start, profiler),
+                    event->frame);
+        }
+
+        for (index = first_frame; index < profiler->frame_count; index += 1)
+        {
+            const profile_frame_t* frame = &profiler->frame[index % PROFILE_FRAME_MAX];
+
+            fprintf(fp, ",\n{\"name\":\"counters\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":1,\"args\":{",
+                    get_us(frame->start - profiler->origin, profiler));
+            for (column = 0; column < PROFILE_COUNTER_MAX; column += 1)
+            {
+                fprintf(fp, "%s\"%s\":%u", (0 < column) ? "," : "", counter_name[column], frame->counter[column]);
+            }
+            fprintf(fp, "}}");
+        }
+
+        fprintf(fp, "\n]}\n");
+        fclose(fp);
+    }
+
+    return CORE_OK;
+}
+
+static profile_frame_t* get_current_frame(profiler_t* profiler)
+{
+    return &profiler->frame[profiler->frame_count % PROFILE_FRAME_MAX];
+}
+
+/* Exclusive time of a graph segment: animated tiles, both render_map
+ * levels, the rest of render_scene, draw_scene and the rest of
+ * update_core.  Zones are inclusive and nest, hence the subtractions.
+ */
+static Uint64 get_segment_ticks(const profile_frame_t* frame, Sint32 segment)
+{
+    const Uint64* ticks = frame->zone_ticks;
+    Uint64        inner;
+
+    switch (segment)
+    {
+        case 0:
+            return ticks[PROFILE_ANIMATION];
+        case 1:
+            return ticks[PROFILE_RENDER_MAP_BG];
+        case 2:
+            return ticks[PROFILE_RENDER_MAP_FG];
+        case 3:
+            inner = ticks[PROFILE_RENDER_MAP_BG] + ticks[PROFILE_RENDER_MAP_FG];
+            return (ticks[PROFILE_RENDER_SCENE] > inner) ? ticks[PROFILE_RENDER_SCENE] - inner : 0;
+        case 4:
+            return ticks[PROFILE_DRAW_SCENE];
+        default:
+            inner = ticks[PROFILE_ANIMATION] + ticks[PROFILE_RENDER_SCENE] + ticks[PROFILE_DRAW_SCENE];
+            return (ticks[PROFILE_UPDATE_CORE] > inner) ? ticks[PROFILE_UPDATE_CORE] - inner : 0;
+    }
+}
+
+static double get_us(Uint64 ticks, profiler_t* profiler)
+{
+    return (double)ticks * 1000000.0 / (double)profiler->frequency;
+}
+
+static void set_draw_color(Uint32 color, Uint8 alpha, core_t* core)
+{
+    SDL_SetRenderDrawColor(core->renderer, (Uint8)(color >> 16), (Uint8)(color >> 8), (Uint8)color, alpha);
+}
+
+#endif /* PROFILE_ENABLED */
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Frame profiler.
+ *
+ * Hot paths are bracketed by PROFILE_BEGIN and PROFILE_END, which time
+ * a zone with the performance counter, and call PROFILE_COUNT for
+ * render copies, render-target switches and bytes uploaded to
+ * textures.  A frame is one call of update_core, see
+ * PROFILE_BEGIN_FRAME.  Each frame is kept with its zone times and
+ * counters, each zone also as a trace event.
+ *
+ * The overlay, toggled with INPUT_OVERLAY, draws the last frames as a
+ * stacked graph along the bottom of the screen, one column per frame
+ * and PROFILE_OVERLAY_US_PER_PIXEL per pixel, with a line at the frame
+ * budget.  Bars along the top show the counters of the last frame.
+ * dump_profile writes the frames as CSV and the events in the Chrome
+ * trace event format, for chrome://tracing or Perfetto.
+ *
+ * Everything compiles away unless built with PROFILE_ENABLED: the
+ * macros expand to nothing and core_t has no profiler.
+ */
+
+#define PROFILE_OVERLAY_HEIGHT       48
+#define PROFILE_OVERLAY_US_PER_PIXEL 500
+
+#ifdef PROFILE_ENABLED
+#  define PROFILE_BEGIN(zone, core)           begin_profile_zone((zone), (core))
+#  define PROFILE_END(zone, core)             end_profile_zone((zone), (core))
+#  define PROFILE_BEGIN_FRAME(core)           begin_profile_frame(core)
+#  define PROFILE_END_FRAME(core)             end_profile_frame(core)
+#  define PROFILE_COUNT(counter, value, core) add_profile_count((counter), (Uint32)(value), (core))
+#  define PROFILE_DRAW_OVERLAY(core)          draw_profile_overlay(core)
+
+status_t init_profiler(core_t* core);
+void     free_profiler(core_t* core);
+void     begin_profile_frame(core_t* core);
+void     end_profile_frame(core_t* core);
+void     begin_profile_zone(profile_zone zone, core_t* core);
+void     end_profile_zone(profile_zone zone, core_t* core);
+void     add_profile_count(profile_counter counter, Uint32 value, core_t* core);
+void     draw_profile_overlay(core_t* core);
+status_t dump_profile(const char* csv_file_name, const char* trace_file_name, core_t* core);
+#else
+#  define PROFILE_BEGIN(zone, core)
+#  define PROFILE_END(zone, core)
+#  define PROFILE_BEGIN_FRAME(core)
+#  define PROFILE_END_FRAME(core)
+#  define PROFILE_COUNT(counter, value, core)
+#  define PROFILE_DRAW_OVERLAY(core)
+#endif
+
+#endif /* PROFILE_H */
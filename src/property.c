@@ -0,0 +1,366 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <tmx.h>
+#include "arena.h"
+#include "core.h"
+#include "map_blob.h"
+#include "property.h"
+#include "tiled.h"
+
+typedef struct property_walk
+{
+    property_table_t* table;
+    Uint32            owner;
+
+} property_walk_t;
+
+static void     add_property(property_table_t* table, const property_entry_t* property);
+static Uint32   get_slot(const property_table_t* table, Uint32 owner, const Uint64 name_hash);
+static status_t load_properties_from_blob(property_table_t* table, core_t* core);
+static void     walk_layer_properties(tmx_layer* layer, property_walk_t* walk);
+static void     walk_properties(tmx_properties* properties, Uint32 owner, property_walk_t* walk);
+static void     walk_tiled_properties(property_table_t* table, tmx_map* handle);
+static void     tmxlib_store_property(tmx_property* property, void* walk);
+
+/* Properties are indexed once: the table is sized to at most half
+ * full, so that a lookup is one hash and a short linear probe without
+ * touching libtmx or allocating.  Lookups only read the table and are
+ * therefore reentrant.
+ */
+status_t load_property_table(core_t* core)
+{
+    property_table_t* table = &core->map->property;
+    Uint32            count;
+
+    // [1] Count.
+    if (core->map->blob.data)
+    {
+        count = core->map->blob.header->property_count;
+    }
+    else
+    {
+        walk_tiled_properties(table, core->map->handle);
+        count = table->count;
+    }
+
+    table->count = 0;
+    if (0 == count)
+    {
+        return CORE_OK;
+    }
+
+    table->capacity = 8;
+    while (table->capacity < count * 2)
+    {
+        table->capacity *= 2;
+    }
+
+    table->entry = (property_entry_t*)arena_calloc(core->map->arena, (size_t)table->capacity, sizeof(struct property_entry));
+    if (! table->entry)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        table->capacity = 0;
+        return CORE_ERROR;
+    }
+
+    // [2] Index.
+    if (core->map->blob.data)
+    {
+        if (CORE_OK != load_properties_from_blob(table, core))
+        {
+            return CORE_ERROR;
+        }
+    }
+    else
+    {
+        walk_tiled_properties(table, core->map->handle);
+    }
+
+    dbgprint("Index %u propert(y/ies) in %u slot(s).", table->count, table->capacity);
+
+    return CORE_OK;
+}
+
+const property_entry_t* find_property(const property_table_t* table, Uint32 owner, const Uint64 name_hash)
+{
+    Uint32 slot;
+
+    if (0 == table->capacity)
+    {
+        return NULL;
+    }
+
+    slot = get_slot(table, owner, name_hash);
+    while (PT_NONE != table->entry[slot].type)
+    {
+        if (name_hash == table->entry[slot].hash && owner == table->entry[slot].owner)
+        {
+            return &table->entry[slot];
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    return NULL;
+}
+
+SDL_bool get_boolean_property(const Uint64 name_hash, Uint32 owner, core_t* core)
+{
+    const property_entry_t* property = find_property(&core->map->property, owner, name_hash);
+
+    if (property && PT_BOOL == property->type)
+    {
+        return property->value.integer ? SDL_TRUE : SDL_FALSE;
+    }
+
+    return SDL_FALSE;
+}
+
+double get_decimal_property(const Uint64 name_hash, Uint32 owner, core_t* core)
+{
+    const property_entry_t* property = find_property(&core->map->property, owner, name_hash);
+
+    if (property && PT_FLOAT == property->type)
+    {
+        return (double)property->value.decimal;
+    }
+
+    return 0.0;
+}
+
+Sint32 get_integer_property(const Uint64 name_hash, Uint32 owner, core_t* core)
+{
+    const property_entry_t* property = find_property(&core->map->property, owner, name_hash);
+
+    if (property && PT_INT == property->type)
+    {
+        return property->value.integer;
+    }
+
+    return 0;
+}
+
+const char* get_string_property(const Uint64 name_hash, Uint32 owner, core_t* core)
+{
+    const property_entry_t* property = find_property(&core->map->property, owner, name_hash);
+
+    if (property && (PT_STRING == property->type || PT_FILE == property->type))
+    {
+        return property->value.string;
+    }
+
+    return NULL;
+}
+
+SDL_bool get_boolean_map_property(const Uint64 name_hash, core_t* core)
+{
+    if (! is_map_loaded(core))
+    {
+        return SDL_FALSE;
+    }
+
+    return get_boolean_property(name_hash, PROPERTY_OWNER_MAP, core);
+}
+
+double get_decimal_map_property(const Uint64 name_hash, core_t* core)
+{
+    if (! is_map_loaded(core))
+    {
+        return 0.0;
+    }
+
+    return get_decimal_property(name_hash, PROPERTY_OWNER_MAP, core);
+}
+
+Sint32 get_integer_map_property(const Uint64 name_hash, core_t* core)
+{
+    if (! is_map_loaded(core))
+    {
+        return 0;
+    }
+
+    return get_integer_property(name_hash, PROPERTY_OWNER_MAP, core);
+}
+
+const char* get_string_map_property(const Uint64 name_hash, core_t* core)
+{
+    if (! is_map_loaded(core))
+    {
+        return NULL;
+    }
+
+    return get_string_property(name_hash, PROPERTY_OWNER_MAP, core);
+}
+
+// Insert a property; a later property with the same key replaces it.
+static void add_property(property_table_t* table, const property_entry_t* property)
+{
+    Uint32 slot = get_slot(table, property->owner, property->hash);
+
+    while (PT_NONE != table->entry[slot].type)
+    {
+        if (property->hash == table->entry[slot].hash && property->owner == table->entry[slot].owner)
+        {
+            table->entry[slot] = *property;
+            return;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    table->entry[slot]  = *property;
+    table->count       += 1;
+}
+
+static Uint32 get_slot(const property_table_t* table, Uint32 owner, const Uint64 name_hash)
+{
+    // Fibonacci hashing spreads the small owner ids over all bits.
+    Uint64 key = name_hash ^ ((Uint64)owner * (((Uint64)0x9e3779b9 << 32) | 0x7f4a7c15));
+
+    key ^= key >> 32;
+
+    return (Uint32)key & (table->capacity - 1);
+}
+
+static status_t load_properties_from_blob(property_table_t* table, core_t* core)
+{
+    map_blob_t*                blob        = &core->map->blob;
+    const map_blob_property_t* property    = (const map_blob_property_t*)get_map_blob_section(blob, blob->header->property_offset);
+    Uint32                     string_size = blob->string_size;
+    Uint32                     index;
+
+    for (index = 0; index < blob->header->property_count; index += 1)
+    {
+        property_entry_t entry;
+
+        SDL_zero(entry);
+        entry.hash  = property[index].hash;
+        entry.owner = property[index].owner;
+        entry.type  = property[index].type;
+
+        switch (property[index].type)
+        {
+            case PT_BOOL:
+            case PT_INT:
+                entry.value.integer = property[index].value.integer;
+                break;
+            case PT_FLOAT:
+                entry.value.decimal = property[index].value.decimal;
+                break;
+            case PT_FILE:
+            case PT_STRING:
+                if (property[index].value.string >= string_size)
+                {
+                    dbgprint("%s: corrupt property table.", FUNCTION_NAME);
+                    return CORE_ERROR;
+                }
+                entry.value.string = get_map_blob_string(blob, property[index].value.string);
+                break;
+            default:
+                dbgprint("%s: corrupt property table.", FUNCTION_NAME);
+                return CORE_ERROR;
+        }
+
+        add_property(table, &entry);
+    }
+
+    return CORE_OK;
+}
+
+static void walk_layer_properties(tmx_layer* layer, property_walk_t* walk)
+{
+    while (layer)
+    {
+        walk_properties(layer->properties, PROPERTY_OWNER_LAYER(layer->id), walk);
+
+        if (is_tiled_layer_of_type(L_GROUP, layer))
+        {
+            walk_layer_properties(layer->content.group_head, walk);
+        }
+        else if (is_tiled_layer_of_type(L_OBJGR, layer))
+        {
+            tmx_object* object = layer->content.objgr->head;
+
+            while (object)
+            {
+                walk_properties(object->properties, PROPERTY_OWNER_OBJECT(object->id), walk);
+                object = object->next;
+            }
+        }
+
+        layer = layer->next;
+    }
+}
+
+static void walk_properties(tmx_properties* properties, Uint32 owner, property_walk_t* walk)
+{
+    if (! properties)
+    {
+        return;
+    }
+
+    walk->owner = owner;
+    tmx_property_foreach(properties, tmxlib_store_property, (void*)walk);
+}
+
+/* Visit every property of the map, its layers, objects and tiles.
+ * Without entries, the table only counts them.
+ */
+static void walk_tiled_properties(property_table_t* table, tmx_map* handle)
+{
+    property_walk_t walk;
+    Uint32          gid;
+
+    walk.table = table;
+    walk.owner = PROPERTY_OWNER_MAP;
+
+    walk_properties(handle->properties, PROPERTY_OWNER_MAP, &walk);
+    walk_layer_properties(get_head_layer(handle), &walk);
+
+    for (gid = 0; gid < handle->tilecount; gid += 1)
+    {
+        if (handle->tiles[gid])
+        {
+            walk_properties(handle->tiles[gid]->properties, PROPERTY_OWNER_TILE(gid), &walk);
+        }
+    }
+}
+
+static void tmxlib_store_property(tmx_property* property, void* walk)
+{
+    property_walk_t* walk_ptr = walk;
+    property_entry_t entry;
+
+    SDL_zero(entry);
+    entry.hash  = generate_hash((const unsigned char*)property->name);
+    entry.owner = walk_ptr->owner;
+    entry.type  = (Uint32)property->type;
+
+    switch (property->type)
+    {
+        case PT_BOOL:
+            entry.value.integer = property->value.boolean ? 1 : 0;
+            break;
+        case PT_FILE:
+            entry.value.string  = property->value.file;
+            break;
+        case PT_FLOAT:
+            entry.value.decimal = property->value.decimal;
+            break;
+        case PT_INT:
+            entry.value.integer = property->value.integer;
+            break;
+        case PT_STRING:
+            entry.value.string  = property->value.string;
+            break;
+        default:
+            return;
+    }
+
+    if (! walk_ptr->table->entry)
+    {
+        walk_ptr->table->count += 1;
+        return;
+    }
+
+    add_property(walk_ptr->table, &entry);
+}
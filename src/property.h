@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef PROPERTY_H
+#define PROPERTY_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Property owners.  Layers and objects are identified by their Tiled
+ * id, tiles by their gid.
+ */
+#define PROPERTY_OWNER_MAP        0x00000000
+#define PROPERTY_OWNER_LAYER(id)  (0x10000000 | ((Uint32)(id) & 0x0fffffff))
+#define PROPERTY_OWNER_OBJECT(id) (0x20000000 | ((Uint32)(id) & 0x0fffffff))
+#define PROPERTY_OWNER_TILE(gid)  (0x30000000 | ((Uint32)(gid) & 0x0fffffff))
+
+status_t                load_property_table(core_t* core);
+const property_entry_t* find_property(const property_table_t* table, Uint32 owner, const Uint64 name_hash);
+SDL_bool                get_boolean_property(const Uint64 name_hash, Uint32 owner, core_t* core);
+double                  get_decimal_property(const Uint64 name_hash, Uint32 owner, core_t* core);
+Sint32                  get_integer_property(const Uint64 name_hash, Uint32 owner, core_t* core);
+const char*             get_string_property(const Uint64 name_hash, Uint32 owner, core_t* core);
+SDL_bool                get_boolean_map_property(const Uint64 name_hash, core_t* core);
+double                  get_decimal_map_property(const Uint64 name_hash, core_t* core);
+Sint32                  get_integer_map_property(const Uint64 name_hash, core_t* core);
+const char*             get_string_map_property(const Uint64 name_hash, core_t* core);
+
+#endif /* PROPERTY_H */
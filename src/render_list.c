@@ -0,0 +1,349 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <tmx.h>
+#include "arena.h"
+#include "core.h"
+#include "job.h"
+#include "map_blob.h"
+#include "render_list.h"
+#include "stream.h"
+#include "tiled.h"
+#include "tileset.h"
+
+typedef struct render_list_build
+{
+    render_list_t* list;
+    tmx_map*       handle;
+    Sint32**       content; // Gids of every visible tile layer, from Tiled.
+
+} render_list_build_t;
+
+static void     count_chunk_row_cells(void* data, Sint32 chunk_y);
+static void     fill_chunk_row_cells(void* data, Sint32 chunk_y);
+static Sint32   get_chunk_index(render_list_t* list, Sint32 index_x, Sint32 index_y);
+static status_t load_render_list_from_blob(core_t* core);
+
+status_t load_render_list(core_t* core)
+{
+    render_list_t*      list       = &core->map->render_list;
+    tmx_map*            handle     = core->map->handle;
+    tmx_layer*          layer;
+    render_list_build_t build;
+    Uint32              cell_count = 0;
+    Sint32              cell_per_layer;
+    Sint32              chunk_count;
+    Sint32              layer_index;
+    Sint32              gid;
+    Sint32              index;
+
+    if (core->map->blob.data)
+    {
+        return load_render_list_from_blob(core);
+    }
+
+    if (0x10000 < handle->tilecount)
+    {
+        dbgprint("%s: too many tiles (%u).", FUNCTION_NAME, handle->tilecount);
+        return CORE_ERROR;
+    }
+
+    list->width         = (Sint32)handle->width;
+    list->height        = (Sint32)handle->height;
+    list->tile_width    = get_tile_width(handle);
+    list->tile_height   = get_tile_height(handle);
+    list->gid_count     = (Sint32)handle->tilecount;
+    list->chunk_count_x = (list->width  + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    list->chunk_count_y = (list->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    cell_per_layer      = list->width * list->height;
+    chunk_count         = list->chunk_count_x * list->chunk_count_y;
+
+    // [1] Tileset and tileset position of every gid.
+    list->position    = (SDL_Point*)arena_calloc(core->map->arena, (size_t)list->gid_count, sizeof(SDL_Point));
+    list->src         = (SDL_Point*)arena_calloc(core->map->arena, (size_t)list->gid_count, sizeof(SDL_Point));
+    list->gid_tileset = (Uint8*)arena_calloc(core->map->arena, (size_t)list->gid_count, sizeof(Uint8));
+    if (! list->position || ! list->src || ! list->gid_tileset)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    for (index = 0; index < core->map->tileset_count; index += 1)
+    {
+        tileset_t* tileset = &core->map->tileset[index];
+
+        for (gid = tileset->first_gid; gid < tileset->first_gid + tileset->tile_count && gid < list->gid_count; gid += 1)
+        {
+            list->gid_tileset[gid] = (Uint8)index;
+        }
+    }
+
+    for (gid = 0; gid < list->gid_count; gid += 1)
+    {
+        if (is_gid_valid(gid, handle))
+        {
+            get_tile_position(gid, &list->position[gid].x, &list->position[gid].y, handle);
+        }
+    }
+    set_render_list_src(core);
+
+    // [2] Dense gid grid of every visible tile layer.
+    layer = get_head_layer(handle);
+    while (layer)
+    {
+        if (is_tiled_layer_of_type(L_LAYER, layer) && layer->visible)
+        {
+            list->layer_count += 1;
+        }
+        layer = layer->next;
+    }
+
+    if (0 >= list->layer_count)
+    {
+        return CORE_OK;
+    }
+
+    list->layer_tile  = (Uint16*)arena_calloc(core->map->arena, (size_t)(list->layer_count * cell_per_layer), sizeof(Uint16));
+    list->cell_offset = (Uint32*)arena_calloc(core->map->arena, (size_t)chunk_count + 1, sizeof(Uint32));
+    build.content     = (Sint32**)calloc((size_t)list->layer_count, sizeof(Sint32*));
+    if (! list->layer_tile || ! list->cell_offset || ! build.content)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        free(build.content);
+        return CORE_ERROR;
+    }
+
+    build.list   = list;
+    build.handle = handle;
+
+    layer_index = 0;
+    layer       = get_head_layer(handle);
+    while (layer)
+    {
+        if (is_tiled_layer_of_type(L_LAYER, layer) && layer->visible)
+        {
+            build.content[layer_index] = get_layer_content(layer);
+            layer_index += 1;
+        }
+        layer = layer->next;
+    }
+
+    /* Rows of chunks are independent: each job only writes the grid
+     * rows and the chunk offsets of its own row of chunks.
+     */
+    run_jobs(count_chunk_row_cells, &build, list->chunk_count_y, 1, core);
+
+    for (index = 0; index < chunk_count; index += 1)
+    {
+        list->cell_offset[index + 1] += list->cell_offset[index];
+    }
+    cell_count = list->cell_offset[chunk_count];
+
+    if (0 == cell_count)
+    {
+        free(build.content);
+        return CORE_OK;
+    }
+
+    list->cell = (render_cell_t*)arena_calloc(core->map->arena, (size_t)cell_count, sizeof(struct render_cell));
+    if (! list->cell)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        free(build.content);
+        return CORE_ERROR;
+    }
+
+    // [3] Non-empty cells sorted by chunk.
+    run_jobs(fill_chunk_row_cells, &build, list->chunk_count_y, 1, core);
+    free(build.content);
+
+    // Filling advanced each offset by one chunk; shift them back.
+    for (index = chunk_count; index > 0; index -= 1)
+    {
+        list->cell_offset[index] = list->cell_offset[index - 1];
+    }
+    list->cell_offset[0] = 0;
+
+    dbgprint("Compiled %d layer(s) into %u cell(s).", list->layer_count, cell_count);
+
+    return CORE_OK;
+}
+
+// Reset the source position of every gid to its first frame.
+void set_render_list_src(core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    Sint32         gid;
+
+    for (gid = 0; gid < list->gid_count; gid += 1)
+    {
+        get_tile_source(gid, &list->src[gid], core);
+    }
+}
+
+Uint16 get_render_list_gid(render_list_t* list, Sint32 layer_index, Sint32 index_x, Sint32 index_y)
+{
+    if (list->stream)
+    {
+        return get_stream_gid(list->stream, layer_index, index_x, index_y);
+    }
+
+    return list->layer_tile[(layer_index * list->width * list->height) + (index_y * list->width) + index_x];
+}
+
+/* Cells of a render chunk, in drawing order.  Returns NULL if there
+ * are none.
+ */
+render_cell_t* get_render_list_cells(render_list_t* list, Sint32 chunk_index, Sint32* cell_count)
+{
+    if (list->stream)
+    {
+        return get_stream_cells(list->stream, chunk_index % list->chunk_count_x, chunk_index / list->chunk_count_x, cell_count);
+    }
+
+    if (! list->cell)
+    {
+        *cell_count = 0;
+        return NULL;
+    }
+
+    *cell_count = (Sint32)(list->cell_offset[chunk_index + 1] - list->cell_offset[chunk_index]);
+
+    return &list->cell[list->cell_offset[chunk_index]];
+}
+
+/* Compiled maps already contain the render list in its final form:
+ * point straight into the blob.  Only the source table is built as
+ * it depends on the atlas layout and tile animations modify it.
+ */
+static status_t load_render_list_from_blob(core_t* core)
+{
+    render_list_t*           list   = &core->map->render_list;
+    map_blob_t*              blob   = &core->map->blob;
+    const map_blob_header_t* header = blob->header;
+    Sint32                   chunk_count;
+
+    list->is_in_place   = SDL_TRUE;
+    list->width         = (Sint32)header->width;
+    list->height        = (Sint32)header->height;
+    list->tile_width    = (Sint32)header->tile_width;
+    list->tile_height   = (Sint32)header->tile_height;
+    list->gid_count     = (Sint32)header->gid_count;
+    list->layer_count   = (Sint32)header->layer_count;
+    list->chunk_count_x = (list->width  + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    list->chunk_count_y = (list->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunk_count         = list->chunk_count_x * list->chunk_count_y;
+
+    list->position    = (SDL_Point*)get_map_blob_section(blob, header->position_offset);
+    list->gid_tileset = (Uint8*)get_map_blob_section(blob, header->gid_tileset_offset);
+
+    // Streamed maps read their tiles chunk by chunk, see stream.h.
+    if (0 != header->stream_chunk_size)
+    {
+        if (CORE_OK != load_stream(core))
+        {
+            return CORE_ERROR;
+        }
+        goto load_src;
+    }
+
+    list->layer_tile  = (Uint16*)get_map_blob_section(blob, header->layer_tile_offset);
+    list->cell_offset = (Uint32*)get_map_blob_section(blob, header->cell_offset_offset);
+
+    if (list->cell_offset[chunk_count] != header->cell_count)
+    {
+        dbgprint("%s: corrupt cell list.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    if (0 < header->cell_count)
+    {
+        list->cell = (render_cell_t*)get_map_blob_section(blob, header->cell_list_offset);
+    }
+
+load_src:
+    list->src = (SDL_Point*)arena_calloc(core->map->arena, (size_t)list->gid_count, sizeof(SDL_Point));
+    if (! list->src)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+    set_render_list_src(core);
+
+    return CORE_OK;
+}
+
+// Copy the valid gids of a row of chunks into the layer grid and count the cells of each chunk.
+static void count_chunk_row_cells(void* data, Sint32 chunk_y)
+{
+    render_list_build_t* build      = (render_list_build_t*)data;
+    render_list_t*       list       = build->list;
+    Sint32               last_y     = SDL_min((chunk_y + 1) * CHUNK_SIZE, list->height);
+    Sint32               layer_index;
+    Sint32               index_height;
+    Sint32               index_width;
+
+    for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+    {
+        const Sint32* layer_content = build->content[layer_index];
+        Uint16*       layer_tile    = &list->layer_tile[layer_index * list->width * list->height];
+
+        for (index_height = chunk_y * CHUNK_SIZE; index_height < last_y; index_height += 1)
+        {
+            for (index_width = 0; index_width < list->width; index_width += 1)
+            {
+                Sint32 index = (index_height * list->width) + index_width;
+                Sint32 gid   = remove_gid_flip_bits(layer_content[index]);
+
+                if (gid < list->gid_count && is_gid_valid(gid, build->handle))
+                {
+                    layer_tile[index] = (Uint16)gid;
+                    list->cell_offset[get_chunk_index(list, index_width, index_height) + 1] += 1;
+                }
+            }
+        }
+    }
+}
+
+/* Sort the cells of a row of chunks into their chunks.  Walking the
+ * layers in order keeps the cells of each chunk in drawing order.
+ */
+static void fill_chunk_row_cells(void* data, Sint32 chunk_y)
+{
+    render_list_build_t* build  = (render_list_build_t*)data;
+    render_list_t*       list   = build->list;
+    Sint32               last_y = SDL_min((chunk_y + 1) * CHUNK_SIZE, list->height);
+    Sint32               layer_index;
+    Sint32               index_height;
+    Sint32               index_width;
+
+    for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+    {
+        const Uint16* layer_tile = &list->layer_tile[layer_index * list->width * list->height];
+
+        for (index_height = chunk_y * CHUNK_SIZE; index_height < last_y; index_height += 1)
+        {
+            for (index_width = 0; index_width < list->width; index_width += 1)
+            {
+                Uint16 gid = layer_tile[(index_height * list->width) + index_width];
+
+                if (gid)
+                {
+                    Sint32         chunk = get_chunk_index(list, index_width, index_height);
+                    render_cell_t* cell  = &list->cell[list->cell_offset[chunk]];
+
+                    list->cell_offset[chunk] += 1;
+
+                    cell->pos_x = (Uint8)(index_width  % CHUNK_SIZE);
+                    cell->pos_y = (Uint8)(index_height % CHUNK_SIZE);
+                    cell->gid   = gid;
+                }
+            }
+        }
+    }
+}
+
+static Sint32 get_chunk_index(render_list_t* list, Sint32 index_x, Sint32 index_y)
+{
+    return ((index_y / CHUNK_SIZE) * list->chunk_count_x) + (index_x / CHUNK_SIZE);
+}
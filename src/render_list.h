@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RENDER_LIST_H
+#define RENDER_LIST_H
+
+#include <SDL.h>
+#include "core.h"
+
+status_t       load_render_list(core_t* core);
+void           set_render_list_src(core_t* core);
+Uint16         get_render_list_gid(render_list_t* list, Sint32 layer_index, Sint32 index_x, Sint32 index_y);
+render_cell_t* get_render_list_cells(render_list_t* list, Sint32 chunk_index, Sint32* cell_count);
+
+#endif /* RENDER_LIST_H */
@@ -0,0 +1,313 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include "arena.h"
+#include "core.h"
+#include "map_blob.h"
+#include "stream.h"
+
+static const map_blob_chunk_t* find_stream_chunk(stream_t* stream, Sint32 index_x, Sint32 index_y);
+static status_t                load_stream_page(stream_page_t* page, Sint32 index_x, Sint32 index_y, stream_t* stream);
+
+/* Set up the stream of a compiled map with streamed chunks.  Pages are
+ * allocated from the map arena once; no chunk is read before the first
+ * lookup.
+ */
+status_t load_stream(core_t* core)
+{
+    map_t*                   map    = core->map;
+    render_list_t*           list   = &map->render_list;
+    stream_t*                stream = &map->stream;
+    const map_blob_header_t* header = map->blob.header;
+    Sint32                   chunk_width;
+    Sint32                   chunk_height;
+    Sint32                   min_radius;
+    Sint32                   sub_count;
+    Sint32                   page_count;
+    Sint32                   tile_count;
+    size_t                   page_size;
+    Sint32                   index;
+
+    stream->blob          = &map->blob;
+    stream->chunk         = (const map_blob_chunk_t*)get_map_blob_section(&map->blob, header->chunk_offset);
+    stream->chunk_count   = (Sint32)header->stream_chunk_count;
+    stream->chunk_size    = (Sint32)header->stream_chunk_size;
+    stream->chunk_count_x = list->width  / stream->chunk_size;
+    stream->chunk_count_y = list->height / stream->chunk_size;
+    stream->layer_count   = list->layer_count;
+    stream->gid_count     = list->gid_count;
+
+    /* [1] The ring has to hold every chunk the view can overlap, or
+     * drawing a chunk could evict another one of the same frame.
+     */
+    chunk_width  = stream->chunk_size * list->tile_width;
+    chunk_height = stream->chunk_size * list->tile_height;
+    min_radius   = SDL_max(((176 / 2) + chunk_width - 1) / chunk_width, ((208 / 2) + chunk_height - 1) / chunk_height);
+
+    // [2] Shrink the ring to the budget, but never below what the view needs.
+    sub_count  = stream->chunk_size / CHUNK_SIZE;
+    tile_count = stream->layer_count * stream->chunk_size * stream->chunk_size;
+    page_size  = ((size_t)tile_count * sizeof(Uint16)) + ((size_t)tile_count * sizeof(render_cell_t)) + ((size_t)((sub_count * sub_count) + 1) * sizeof(Uint32));
+
+    stream->radius = SDL_max(core->stream_radius, min_radius);
+    while (stream->radius > min_radius && (size_t)(((2 * stream->radius) + 1) * ((2 * stream->radius) + 1)) * page_size > core->stream_budget)
+    {
+        stream->radius -= 1;
+    }
+    stream->ring_size = (2 * stream->radius) + 1;
+    page_count        = stream->ring_size * stream->ring_size;
+
+    // [3] Free pages.
+    stream->page = (stream_page_t*)arena_calloc(map->arena, (size_t)page_count, sizeof(struct stream_page));
+    if (! stream->page)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    for (index = 0; index < page_count; index += 1)
+    {
+        stream_page_t* page = &stream->page[index];
+
+        page->layer_tile  = (Uint16*)arena_calloc(map->arena, (size_t)tile_count, sizeof(Uint16));
+        page->cell        = (render_cell_t*)arena_calloc(map->arena, (size_t)tile_count, sizeof(struct render_cell));
+        page->cell_offset = (Uint32*)arena_calloc(map->arena, (size_t)(sub_count * sub_count) + 1, sizeof(Uint32));
+        if (! page->layer_tile || ! page->cell || ! page->cell_offset)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            return CORE_ERROR;
+        }
+
+        page->index_x = -1;
+        page->index_y = -1;
+    }
+
+    list->stream = stream;
+
+    dbgprint("Stream %d chunk(s) of %dx%d cells, %d page(s) of %u byte(s).",
+             stream->chunk_count, stream->chunk_size, stream->chunk_size, page_count, (unsigned)page_size);
+
+    return CORE_OK;
+}
+
+// Read the chunks within the stream radius of the chunk at the center of the view.
+void update_stream(core_t* core)
+{
+    render_list_t* list   = &core->map->render_list;
+    stream_t*      stream = list->stream;
+    Sint32         center_x;
+    Sint32         center_y;
+    Sint32         index_x;
+    Sint32         index_y;
+
+    if (! stream)
+    {
+        return;
+    }
+
+    center_x = SDL_max(0, core->camera.view_x - core->map->pos_x + (176 / 2)) / (stream->chunk_size * list->tile_width);
+    center_y = SDL_max(0, core->camera.view_y - core->map->pos_y + (208 / 2)) / (stream->chunk_size * list->tile_height);
+
+    for (index_y = center_y - stream->radius; index_y <= center_y + stream->radius; index_y += 1)
+    {
+        for (index_x = center_x - stream->radius; index_x <= center_x + stream->radius; index_x += 1)
+        {
+            get_stream_page(stream, index_x, index_y);
+        }
+    }
+}
+
+Uint16 get_stream_gid(stream_t* stream, Sint32 layer_index, Sint32 index_x, Sint32 index_y)
+{
+    const stream_page_t* page = get_stream_page(stream, index_x / stream->chunk_size, index_y / stream->chunk_size);
+    Sint32               size = stream->chunk_size;
+
+    if (! page)
+    {
+        return 0;
+    }
+
+    return page->layer_tile[(layer_index * size * size) + ((index_y % size) * size) + (index_x % size)];
+}
+
+// Cells of the render chunk chunk_x, chunk_y, see get_render_list_cells.
+render_cell_t* get_stream_cells(stream_t* stream, Sint32 chunk_x, Sint32 chunk_y, Sint32* cell_count)
+{
+    Sint32               sub_count = stream->chunk_size / CHUNK_SIZE;
+    const stream_page_t* page      = get_stream_page(stream, chunk_x / sub_count, chunk_y / sub_count);
+    Sint32               sub_index;
+
+    if (! page)
+    {
+        *cell_count = 0;
+        return NULL;
+    }
+
+    sub_index   = ((chunk_y % sub_count) * sub_count) + (chunk_x % sub_count);
+    *cell_count = (Sint32)(page->cell_offset[sub_index + 1] - page->cell_offset[sub_index]);
+
+    return &page->cell[page->cell_offset[sub_index]];
+}
+
+/* Page of the chunk index_x, index_y, read into its ring slot if it is
+ * not resident.  Returns NULL for empty chunks and chunks that could
+ * not be read.
+ */
+const stream_page_t* get_stream_page(stream_t* stream, Sint32 index_x, Sint32 index_y)
+{
+    stream_page_t* page;
+
+    if (0 > index_x || 0 > index_y || index_x >= stream->chunk_count_x || index_y >= stream->chunk_count_y)
+    {
+        return NULL;
+    }
+
+    page = &stream->page[((index_y % stream->ring_size) * stream->ring_size) + (index_x % stream->ring_size)];
+
+    // A page that could not be read is left unassigned, to be read again on the next lookup.
+    if (page->index_x != index_x || page->index_y != index_y)
+    {
+        if (CORE_OK != load_stream_page(page, index_x, index_y, stream))
+        {
+            dbgprint("%s: could not read chunk %d, %d.", FUNCTION_NAME, index_x, index_y);
+            page->index_x = -1;
+            page->index_y = -1;
+            return NULL;
+        }
+    }
+
+    if (page->is_empty)
+    {
+        return NULL;
+    }
+
+    return page;
+}
+
+// The chunk index is sorted by row, then column.
+static const map_blob_chunk_t* find_stream_chunk(stream_t* stream, Sint32 index_x, Sint32 index_y)
+{
+    Sint32 first = 0;
+    Sint32 last  = stream->chunk_count - 1;
+
+    while (first <= last)
+    {
+        Sint32                  middle = first + ((last - first) / 2);
+        const map_blob_chunk_t* chunk  = &stream->chunk[middle];
+
+        if ((Sint32)chunk->index_y == index_y && (Sint32)chunk->index_x == index_x)
+        {
+            return chunk;
+        }
+
+        if ((Sint32)chunk->index_y < index_y || ((Sint32)chunk->index_y == index_y && (Sint32)chunk->index_x < index_x))
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle - 1;
+        }
+    }
+
+    return NULL;
+}
+
+/* Read a chunk into a page and sort its cells into the render chunks
+ * inside of it, like load_render_list does for the whole map.  A chunk
+ * that cannot be read stays empty.
+ */
+static status_t load_stream_page(stream_page_t* page, Sint32 index_x, Sint32 index_y, stream_t* stream)
+{
+    const map_blob_chunk_t* chunk     = find_stream_chunk(stream, index_x, index_y);
+    Sint32                  size      = stream->chunk_size;
+    Sint32                  sub_count = size / CHUNK_SIZE;
+    Sint32                  layer_index;
+    Sint32                  cell_x;
+    Sint32                  cell_y;
+    Sint32                  index;
+
+    page->index_x  = index_x;
+    page->index_y  = index_y;
+    page->is_empty = SDL_TRUE;
+
+    if (! chunk)
+    {
+        stream->empty_count += 1;
+        return CORE_OK;
+    }
+
+    if (CORE_OK != read_map_blob_data(stream->blob, chunk->data_offset, page->layer_tile, (size_t)(stream->layer_count * size * size) * sizeof(Uint16)))
+    {
+        return CORE_ERROR;
+    }
+
+    // [1] Count the cells of each render chunk.  The gids are not validated at load.
+    SDL_memset(page->cell_offset, 0, (size_t)((sub_count * sub_count) + 1) * sizeof(Uint32));
+
+    for (layer_index = 0; layer_index < stream->layer_count; layer_index += 1)
+    {
+        Uint16* layer_tile = &page->layer_tile[layer_index * size * size];
+
+        for (cell_y = 0; cell_y < size; cell_y += 1)
+        {
+            for (cell_x = 0; cell_x < size; cell_x += 1)
+            {
+                Uint16* gid = &layer_tile[(cell_y * size) + cell_x];
+
+                if (*gid >= stream->gid_count)
+                {
+                    *gid = 0;
+                }
+
+                if (*gid)
+                {
+                    page->cell_offset[((cell_y / CHUNK_SIZE) * sub_count) + (cell_x / CHUNK_SIZE) + 1] += 1;
+                }
+            }
+        }
+    }
+
+    for (index = 0; index < sub_count * sub_count; index += 1)
+    {
+        page->cell_offset[index + 1] += page->cell_offset[index];
+    }
+
+    // [2] Non-empty cells sorted by render chunk, in drawing order.
+    for (layer_index = 0; layer_index < stream->layer_count; layer_index += 1)
+    {
+        const Uint16* layer_tile = &page->layer_tile[layer_index * size * size];
+
+        for (cell_y = 0; cell_y < size; cell_y += 1)
+        {
+            for (cell_x = 0; cell_x < size; cell_x += 1)
+            {
+                Uint16 gid = layer_tile[(cell_y * size) + cell_x];
+
+                if (gid)
+                {
+                    Sint32         sub_index = ((cell_y / CHUNK_SIZE) * sub_count) + (cell_x / CHUNK_SIZE);
+                    render_cell_t* cell      = &page->cell[page->cell_offset[sub_index]];
+
+                    page->cell_offset[sub_index] += 1;
+
+                    cell->pos_x = (Uint8)(cell_x % CHUNK_SIZE);
+                    cell->pos_y = (Uint8)(cell_y % CHUNK_SIZE);
+                    cell->gid   = gid;
+                }
+            }
+        }
+    }
+
+    // Filling advanced each offset by one render chunk; shift them back.
+    for (index = sub_count * sub_count; index > 0; index -= 1)
+    {
+        page->cell_offset[index] = page->cell_offset[index - 1];
+    }
+    page->cell_offset[0] = 0;
+
+    page->is_empty      = SDL_FALSE;
+    stream->load_count += 1;
+
+    return CORE_OK;
+}
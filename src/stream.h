@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Streamed maps.
+ *
+ * Maps compiled from infinite Tiled maps keep their tiles in chunks
+ * of stream_chunk_size cells, which are read from the compiled map on
+ * demand instead of at load, see map_blob.h.  Only the chunks around
+ * the camera are resident, in the ring of pages of stream_t.
+ *
+ * update_stream reads the chunks within the stream radius of the view
+ * once per frame.  Other lookups read missing chunks as well, so that
+ * a chunk is never drawn without its tiles, but they evict chunks of
+ * the ring: tile queries far from the view are slow.  Chunks that are
+ * not in the map are empty, with gid 0 everywhere.
+ *
+ * Cells and render chunks are indexed like those of the render list,
+ * the first chunk of the compiled map at cell 0.
+ */
+
+status_t             load_stream(core_t* core);
+void                 update_stream(core_t* core);
+Uint16               get_stream_gid(stream_t* stream, Sint32 layer_index, Sint32 index_x, Sint32 index_y);
+render_cell_t*       get_stream_cells(stream_t* stream, Sint32 chunk_x, Sint32 chunk_y, Sint32* cell_count);
+const stream_page_t* get_stream_page(stream_t* stream, Sint32 index_x, Sint32 index_y);
+
+#endif /* STREAM_H */
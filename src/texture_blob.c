@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <cwalk.h>
+#include "core.h"
+#include "texture_blob.h"
+
+#if defined(__unix__)
+#  include <sys/stat.h>
+#endif
+
+#define TEXTURE_BLOB_MAX_SIZE 8192
+
+static SDL_bool is_texture_blob_stale(const char* image_file_name, const char* file_name);
+
+/* Load the compiled texture stored next to an image, if there is one.
+ * Returns CORE_WARNING if there is none, or if it is older than the
+ * image, so that the caller can fall back to the image itself.
+ */
+status_t load_texture_blob(const char* image_file_name, SDL_Surface** surface)
+{
+    texture_blob_header_t header;
+    SDL_RWops*            rw;
+    char*                 file_name;
+    SDL_bool              is_read = SDL_TRUE;
+    Sint32                pos_y;
+
+    file_name = get_texture_blob_name(image_file_name);
+    if (! file_name)
+    {
+        return CORE_ERROR;
+    }
+
+    if (is_texture_blob_stale(image_file_name, file_name))
+    {
+        dbgprint("%s: %s is older than %s, ignored.", FUNCTION_NAME, file_name, image_file_name);
+        free(file_name);
+        return CORE_WARNING;
+    }
+
+    rw = SDL_RWFromFile(file_name, "rb");
+    if (! rw)
+    {
+        free(file_name);
+        return CORE_WARNING;
+    }
+
+    if (1 != SDL_RWread(rw, &header, sizeof(header), 1)             ||
+        TEXTURE_BLOB_MAGIC != header.magic                          ||
+        TEXTURE_BLOB_VERSION != header.version                      ||
+        SDL_PIXELFORMAT_ARGB4444 != header.format                   ||
+        0 == header.width  || TEXTURE_BLOB_MAX_SIZE < header.width  ||
+        0 == header.height || TEXTURE_BLOB_MAX_SIZE < header.height ||
+        SDL_RWsize(rw) != (Sint64)(sizeof(header) + ((size_t)(header.width * header.height) * sizeof(Uint16))))
+    {
+        dbgprint("%s: %s is not a valid compiled texture.", FUNCTION_NAME, file_name);
+        SDL_RWclose(rw);
+        free(file_name);
+        return CORE_ERROR;
+    }
+
+    *surface = SDL_CreateRGBSurfaceWithFormat(0, (int)header.width, (int)header.height, 16, SDL_PIXELFORMAT_ARGB4444);
+    if (! *surface)
+    {
+        dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+        SDL_RWclose(rw);
+        free(file_name);
+        return CORE_ERROR;
+    }
+
+    // The pixels are read straight into the surface, in one go unless its rows are padded.
+    if ((*surface)->pitch == (int)(header.width * sizeof(Uint16)))
+    {
+        is_read = (1 == SDL_RWread(rw, (*surface)->pixels, (size_t)(*surface)->pitch * header.height, 1)) ? SDL_TRUE : SDL_FALSE;
+    }
+    else
+    {
+        for (pos_y = 0; pos_y < (Sint32)header.height && is_read; pos_y += 1)
+        {
+            is_read = (1 == SDL_RWread(rw, (Uint8*)(*surface)->pixels + (pos_y * (*surface)->pitch), header.width * sizeof(Uint16), 1)) ? SDL_TRUE : SDL_FALSE;
+        }
+    }
+    SDL_RWclose(rw);
+
+    if (! is_read)
+    {
+        dbgprint("%s: could not read %s.", FUNCTION_NAME, file_name);
+        SDL_FreeSurface(*surface);
+        *surface = NULL;
+        free(file_name);
+        return CORE_ERROR;
+    }
+
+    if (header.flags & TEXTURE_BLOB_OPAQUE)
+    {
+        SDL_SetSurfaceBlendMode(*surface, SDL_BLENDMODE_NONE);
+    }
+
+    dbgprint("Loading compiled texture from file: %s.", file_name);
+    free(file_name);
+
+    return CORE_OK;
+}
+
+// Name of the compiled texture of an image, to be freed by the caller.
+char* get_texture_blob_name(const char* image_file_name)
+{
+    size_t length    = SDL_strlen(image_file_name) + SDL_strlen(TEXTURE_BLOB_EXTENSION) + 1;
+    char*  file_name = (char*)calloc(1, length);
+
+    if (! file_name)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return NULL;
+    }
+    cwk_path_change_extension(image_file_name, TEXTURE_BLOB_EXTENSION, file_name, length);
+
+    return file_name;
+}
+
+/* An image edited after its compiled texture was generated would be
+ * shadowed by it.  There is no stat on the device, where both files
+ * are installed together.
+ */
+static SDL_bool is_texture_blob_stale(const char* image_file_name, const char* file_name)
+{
+#if defined(__unix__)
+    struct stat image_stat;
+    struct stat blob_stat;
+
+    if (0 == stat(image_file_name, &image_stat) && 0 == stat(file_name, &blob_stat) && image_stat.st_mtime > blob_stat.st_mtime)
+    {
+        return SDL_TRUE;
+    }
+#endif
+
+    return SDL_FALSE;
+}
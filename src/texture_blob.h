@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef TEXTURE_BLOB_H
+#define TEXTURE_BLOB_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Compiled texture format.
+ *
+ * A compiled texture (.ctex) is produced offline by demo_texconv from
+ * a tileset image and stored next to it.  It holds the image in the
+ * format of the tile blitter (see blit.h): ARGB4444, whose RGB444 part
+ * is the pixel format of the chunk textures, with the magenta color
+ * key already turned into a binary alpha.  Loading it is a single read
+ * into the pixels of a surface, without decoding, per-pixel conversion
+ * or color-key handling.
+ *
+ * Layout: a texture_blob_header_t followed by width * height pixels,
+ * row by row, native-endian like the compiled maps.
+ */
+
+#define TEXTURE_BLOB_MAGIC     0x58455443 /* "CTEX" */
+#define TEXTURE_BLOB_VERSION   1
+#define TEXTURE_BLOB_EXTENSION ".ctex"
+
+#define TEXTURE_BLOB_OPAQUE 0x00000001 // No transparent pixels.
+
+typedef struct texture_blob_header
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 format;
+    Uint32 width;
+    Uint32 height;
+    Uint32 flags;
+    Uint32 reserved[2];
+
+} texture_blob_header_t;
+
+status_t load_texture_blob(const char* image_file_name, SDL_Surface** surface);
+char*    get_texture_blob_name(const char* image_file_name);
+
+#endif /* TEXTURE_BLOB_H */
@@ -0,0 +1,519 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <tmx.h>
+#include <libxml/xmlreader.h>
+#include "arena.h"
+#include "core.h"
+#include "map_blob.h"
+#include "property.h"
+#include "render_list.h"
+#include "tile_flag.h"
+#include "tiled.h"
+
+typedef struct tile_flag_property
+{
+    const char* name;
+    Uint32      flag;
+
+} tile_flag_property_t;
+
+static const tile_flag_property_t tile_flag_property[] =
+{
+    { "is_solid",   TILE_FLAG_SOLID   },
+    { "is_trigger", TILE_FLAG_TRIGGER },
+    { "is_hazard",  TILE_FLAG_HAZARD  }
+};
+
+static SDL_bool get_tile_range(const SDL_Rect* rect, SDL_Rect* range, core_t* core);
+static status_t load_terrain(const char* file_name, Sint32 first_gid, SDL_bool is_embedded, core_t* core);
+static Uint32   parse_terrain(const char* terrain);
+
+/* Flags are stored per gid, so the table is as large as the tileset
+ * no matter how large the map is.  Compiled maps contain the finished
+ * table, which is then used in place.
+ */
+status_t load_tile_flags(const char* map_file_name, core_t* core)
+{
+    map_t*            map            = core->map;
+    render_list_t*    list           = &map->render_list;
+    tmx_map*          handle         = map->handle;
+    tmx_tileset_list* tileset;
+    Uint64            hash[sizeof(tile_flag_property) / sizeof(tile_flag_property[0])];
+    Sint32            property_count = (Sint32)(sizeof(tile_flag_property) / sizeof(tile_flag_property[0]));
+    Sint32            gid;
+    Sint32            index;
+
+    if (map->blob.data)
+    {
+        map->tile_properties = (Uint32*)get_map_blob_section(&map->blob, map->blob.header->tile_flag_offset);
+        return CORE_OK;
+    }
+
+    map->tile_properties = (Uint32*)arena_calloc(map->arena, (size_t)list->gid_count, sizeof(Uint32));
+    if (! map->tile_properties)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    // [1] Tile properties.
+    for (index = 0; index < property_count; index += 1)
+    {
+        hash[index] = generate_hash((const unsigned char*)tile_flag_property[index].name);
+    }
+
+    for (gid = 0; gid < list->gid_count; gid += 1)
+    {
+        if (! is_gid_valid(gid, handle) || ! tile_has_properties(gid, NULL, handle))
+        {
+            continue;
+        }
+
+        map->tile_properties[gid] |= TILE_FLAG_HAS_PROPERTIES;
+
+        for (index = 0; index < property_count; index += 1)
+        {
+            if (get_boolean_property(hash[index], PROPERTY_OWNER_TILE(gid), core))
+            {
+                map->tile_properties[gid] |= tile_flag_property[index].flag;
+            }
+        }
+    }
+
+    // [2] Animations.
+    for (index = 0; index < map->animation_count; index += 1)
+    {
+        map->tile_properties[map->animation[index].gid] |= TILE_FLAG_ANIMATED;
+    }
+
+    // [3] Terrain, which libtmx does not parse.
+    tileset = handle->ts_head;
+    while (tileset)
+    {
+        status_t status;
+
+        if (tileset->is_embedded || ! tileset->source)
+        {
+            status = load_terrain(map_file_name, (Sint32)tileset->firstgid, SDL_TRUE, core);
+        }
+        else
+        {
+            size_t length    = SDL_strlen(map->path) + SDL_strlen(tileset->source) + 1;
+            char*  file_name = (char*)calloc(1, length);
+
+            if (! file_name)
+            {
+                dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+                return CORE_ERROR;
+            }
+
+            SDL_strlcpy(file_name, map->path, length);
+            SDL_strlcat(file_name, tileset->source, length);
+
+            status = load_terrain(file_name, (Sint32)tileset->firstgid, SDL_FALSE, core);
+            free(file_name);
+        }
+
+        if (CORE_OK != status)
+        {
+            return status;
+        }
+        tileset = tileset->next;
+    }
+
+    return CORE_OK;
+}
+
+Uint32 get_tile_flags(Sint32 gid, core_t* core)
+{
+    if (! core->map->tile_properties || 0 > gid || gid >= core->map->render_list.gid_count)
+    {
+        return 0;
+    }
+
+    return core->map->tile_properties[gid];
+}
+
+Sint32 get_tile_terrain(Sint32 gid, tile_corner corner, core_t* core)
+{
+    Uint32 flags = get_tile_flags(gid, core);
+
+    return (Sint32)((flags >> (TILE_TERRAIN_SHIFT + ((Uint32)corner * 4))) & 0xf) - 1;
+}
+
+Uint32 get_cell_flags(Sint32 index_x, Sint32 index_y, core_t* core)
+{
+    render_list_t* list  = &core->map->render_list;
+    Uint32         flags = 0;
+    Sint32         layer_index;
+
+    if (! core->map->tile_properties || 0 > index_x || 0 > index_y || index_x >= list->width || index_y >= list->height)
+    {
+        return 0;
+    }
+
+    for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+    {
+        flags |= core->map->tile_properties[get_render_list_gid(list, layer_index, index_x, index_y)];
+    }
+
+    return flags & TILE_FLAG_MASK;
+}
+
+Uint32 get_tile_flags_at(Sint32 pos_x, Sint32 pos_y, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+
+    pos_x -= core->map->pos_x;
+    pos_y -= core->map->pos_y;
+
+    if (0 > pos_x || 0 > pos_y)
+    {
+        return 0;
+    }
+
+    return get_cell_flags(pos_x / list->tile_width, pos_y / list->tile_height, core);
+}
+
+// Terrain under a position, taken from the topmost layer that has any.
+Sint32 get_terrain_at(Sint32 pos_x, Sint32 pos_y, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    Sint32         index_x;
+    Sint32         index_y;
+    Sint32         layer_index;
+    tile_corner    corner;
+
+    pos_x -= core->map->pos_x;
+    pos_y -= core->map->pos_y;
+
+    if (! core->map->tile_properties || 0 > pos_x || 0 > pos_y)
+    {
+        return TILE_TERRAIN_NONE;
+    }
+
+    index_x = pos_x / list->tile_width;
+    index_y = pos_y / list->tile_height;
+
+    if (index_x >= list->width || index_y >= list->height)
+    {
+        return TILE_TERRAIN_NONE;
+    }
+
+    corner = TILE_CORNER_TOP_LEFT;
+    if ((pos_x % list->tile_width) * 2 >= list->tile_width)
+    {
+        corner = (tile_corner)(corner + 1);
+    }
+    if ((pos_y % list->tile_height) * 2 >= list->tile_height)
+    {
+        corner = (tile_corner)(corner + 2);
+    }
+
+    for (layer_index = list->layer_count - 1; layer_index >= 0; layer_index -= 1)
+    {
+        Uint16 gid = get_render_list_gid(list, layer_index, index_x, index_y);
+
+        if (core->map->tile_properties[gid] & TILE_FLAG_HAS_TERRAIN)
+        {
+            return get_tile_terrain(gid, corner, core);
+        }
+    }
+
+    return TILE_TERRAIN_NONE;
+}
+
+Uint32 get_tile_flags_in_rect(const SDL_Rect* rect, core_t* core)
+{
+    render_list_t* list  = &core->map->render_list;
+    Uint32         flags = 0;
+    SDL_Rect       range;
+    Sint32         index_x;
+    Sint32         index_y;
+    Sint32         layer_index;
+
+    if (! get_tile_range(rect, &range, core))
+    {
+        return 0;
+    }
+
+    // Streamed maps have no layer grid to walk, see stream.h.
+    if (list->stream)
+    {
+        for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+        {
+            for (index_x = range.x; index_x < range.x + range.w; index_x += 1)
+            {
+                flags |= get_cell_flags(index_x, index_y, core);
+            }
+        }
+        return flags & TILE_FLAG_MASK;
+    }
+
+    for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+    {
+        for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+        {
+            const Uint16* layer_tile = &list->layer_tile[(layer_index * list->width * list->height) + (index_y * list->width)];
+
+            for (index_x = range.x; index_x < range.x + range.w; index_x += 1)
+            {
+                flags |= core->map->tile_properties[layer_tile[index_x]];
+            }
+        }
+    }
+
+    return flags & TILE_FLAG_MASK;
+}
+
+SDL_bool is_tile_flag_in_rect(const SDL_Rect* rect, Uint32 flag, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    SDL_Rect       range;
+    Sint32         index_x;
+    Sint32         index_y;
+    Sint32         layer_index;
+
+    if (! get_tile_range(rect, &range, core))
+    {
+        return SDL_FALSE;
+    }
+
+    if (list->stream)
+    {
+        for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+        {
+            for (index_x = range.x; index_x < range.x + range.w; index_x += 1)
+            {
+                if (get_cell_flags(index_x, index_y, core) & flag)
+                {
+                    return SDL_TRUE;
+                }
+            }
+        }
+        return SDL_FALSE;
+    }
+
+    for (layer_index = 0; layer_index < list->layer_count; layer_index += 1)
+    {
+        for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+        {
+            const Uint16* layer_tile = &list->layer_tile[(layer_index * list->width * list->height) + (index_y * list->width)];
+
+            for (index_x = range.x; index_x < range.x + range.w; index_x += 1)
+            {
+                if (core->map->tile_properties[layer_tile[index_x]] & flag)
+                {
+                    return SDL_TRUE;
+                }
+            }
+        }
+    }
+
+    return SDL_FALSE;
+}
+
+/* Store the indices of up to tile_max cells inside rect that carry
+ * any of the given flags, in row order.  Returns the number of cells
+ * found, which may exceed tile_max.
+ */
+Sint32 find_tiles_in_rect(const SDL_Rect* rect, Uint32 flag, SDL_Point* tile, Sint32 tile_max, core_t* core)
+{
+    SDL_Rect range;
+    Sint32   count = 0;
+    Sint32   index_x;
+    Sint32   index_y;
+
+    if (! get_tile_range(rect, &range, core))
+    {
+        return 0;
+    }
+
+    for (index_y = range.y; index_y < range.y + range.h; index_y += 1)
+    {
+        for (index_x = range.x; index_x < range.x + range.w; index_x += 1)
+        {
+            if (get_cell_flags(index_x, index_y, core) & flag)
+            {
+                if (count < tile_max)
+                {
+                    tile[count].x = index_x;
+                    tile[count].y = index_y;
+                }
+                count += 1;
+            }
+        }
+    }
+
+    return count;
+}
+
+// Cells covered by a rectangle in world pixels, clipped to the map.
+static SDL_bool get_tile_range(const SDL_Rect* rect, SDL_Rect* range, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+    Sint32         first_x;
+    Sint32         first_y;
+    Sint32         last_x;
+    Sint32         last_y;
+
+    if (! core->map->tile_properties || (! list->layer_tile && ! list->stream) || 0 >= rect->w || 0 >= rect->h)
+    {
+        return SDL_FALSE;
+    }
+
+    first_x = rect->x - core->map->pos_x;
+    first_y = rect->y - core->map->pos_y;
+    last_x  = first_x + rect->w - 1;
+    last_y  = first_y + rect->h - 1;
+
+    if (0 > last_x || 0 > last_y)
+    {
+        return SDL_FALSE;
+    }
+    if (0 > first_x)
+    {
+        first_x = 0;
+    }
+    if (0 > first_y)
+    {
+        first_y = 0;
+    }
+
+    range->x = first_x / list->tile_width;
+    range->y = first_y / list->tile_height;
+    last_x   = last_x  / list->tile_width;
+    last_y   = last_y  / list->tile_height;
+
+    if (range->x >= list->width || range->y >= list->height)
+    {
+        return SDL_FALSE;
+    }
+    if (last_x >= list->width)
+    {
+        last_x = list->width - 1;
+    }
+    if (last_y >= list->height)
+    {
+        last_y = list->height - 1;
+    }
+
+    range->w = last_x - range->x + 1;
+    range->h = last_y - range->y + 1;
+
+    return SDL_TRUE;
+}
+
+/* Read the terrain attribute of every tile of a tileset.  Embedded
+ * tilesets are looked up in the map file by their first gid.
+ */
+static status_t load_terrain(const char* file_name, Sint32 first_gid, SDL_bool is_embedded, core_t* core)
+{
+    render_list_t*   list       = &core->map->render_list;
+    xmlTextReaderPtr reader;
+    SDL_bool         is_current = SDL_FALSE;
+    int              status;
+
+    reader = xmlReaderForFile(file_name, NULL, 0);
+    if (! reader)
+    {
+        dbgprint("%s: could not open %s.", FUNCTION_NAME, file_name);
+        return CORE_WARNING;
+    }
+
+    while (1 == (status = xmlTextReaderRead(reader)))
+    {
+        const char* name = (const char*)xmlTextReaderConstName(reader);
+        int         type = xmlTextReaderNodeType(reader);
+
+        if (XML_READER_TYPE_END_ELEMENT == type && 0 == SDL_strcmp(name, "tileset"))
+        {
+            is_current = SDL_FALSE;
+        }
+
+        if (XML_READER_TYPE_ELEMENT != type)
+        {
+            continue;
+        }
+
+        if (0 == SDL_strcmp(name, "tileset"))
+        {
+            is_current = SDL_TRUE;
+
+            if (is_embedded)
+            {
+                xmlChar* value = xmlTextReaderGetAttribute(reader, (const xmlChar*)"firstgid");
+
+                is_current = (value && first_gid == SDL_atoi((const char*)value)) ? SDL_TRUE : SDL_FALSE;
+                xmlFree(value);
+            }
+
+            if (xmlTextReaderIsEmptyElement(reader))
+            {
+                is_current = SDL_FALSE;
+            }
+        }
+        else if (is_current && 0 == SDL_strcmp(name, "tile"))
+        {
+            xmlChar* id      = xmlTextReaderGetAttribute(reader, (const xmlChar*)"id");
+            xmlChar* terrain = xmlTextReaderGetAttribute(reader, (const xmlChar*)"terrain");
+
+            if (id && terrain)
+            {
+                Sint32 gid = first_gid + SDL_atoi((const char*)id);
+
+                if (0 <= gid && gid < list->gid_count)
+                {
+                    core->map->tile_properties[gid] |= parse_terrain((const char*)terrain);
+                }
+            }
+
+            xmlFree(id);
+            xmlFree(terrain);
+        }
+    }
+
+    xmlFreeTextReader(reader);
+
+    if (0 != status)
+    {
+        dbgprint("%s: could not parse %s.", FUNCTION_NAME, file_name);
+        return CORE_WARNING;
+    }
+
+    return CORE_OK;
+}
+
+// "a,b,c,d" with optional empty fields for corners without terrain.
+static Uint32 parse_terrain(const char* terrain)
+{
+    Uint32 flags = 0;
+    Sint32 corner;
+
+    for (corner = 0; corner < TILE_CORNER_MAX; corner += 1)
+    {
+        if (*terrain >= '0' && *terrain <= '9')
+        {
+            Sint32 index = SDL_atoi(terrain);
+
+            if (index < 15)
+            {
+                flags |= (Uint32)(index + 1) << (TILE_TERRAIN_SHIFT + (corner * 4));
+                flags |= TILE_FLAG_HAS_TERRAIN;
+            }
+        }
+
+        while (*terrain && ',' != *terrain)
+        {
+            terrain += 1;
+        }
+        if (! *terrain)
+        {
+            break;
+        }
+        terrain += 1;
+    }
+
+    return flags;
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef TILE_FLAG_H
+#define TILE_FLAG_H
+
+#include <SDL.h>
+#include "core.h"
+
+/* Per-gid tile flags.
+ *
+ * The lower 16 bits hold flags, set from boolean tile properties of
+ * the same name (is_solid, is_trigger, is_hazard) or derived from the
+ * tileset.  The upper 16 bits hold the terrain of the four tile
+ * corners as read from the .tsx, one nibble per corner in Tiled's
+ * order (top left, top right, bottom left, bottom right), each storing
+ * the terrain index + 1 or 0 for no terrain.
+ *
+ * Queries take world positions in pixels, i.e. the same space as the
+ * camera.  Cell queries combine the flags of all tile layers.
+ */
+
+#define TILE_FLAG_SOLID          0x00000001
+#define TILE_FLAG_TRIGGER        0x00000002
+#define TILE_FLAG_HAZARD         0x00000004
+#define TILE_FLAG_ANIMATED       0x00000008
+#define TILE_FLAG_HAS_PROPERTIES 0x00000010
+#define TILE_FLAG_HAS_TERRAIN    0x00000020
+#define TILE_FLAG_MASK           0x0000ffff
+
+#define TILE_TERRAIN_SHIFT       16
+#define TILE_TERRAIN_NONE        -1
+
+typedef enum
+{
+    TILE_CORNER_TOP_LEFT = 0,
+    TILE_CORNER_TOP_RIGHT,
+    TILE_CORNER_BOTTOM_LEFT,
+    TILE_CORNER_BOTTOM_RIGHT,
+    TILE_CORNER_MAX
+
+} tile_corner;
+
+status_t load_tile_flags(const char* map_file_name, core_t* core);
+Uint32   get_tile_flags(Sint32 gid, core_t* core);
+Sint32   get_tile_terrain(Sint32 gid, tile_corner corner, core_t* core);
+Uint32   get_cell_flags(Sint32 index_x, Sint32 index_y, core_t* core);
+Uint32   get_tile_flags_at(Sint32 pos_x, Sint32 pos_y, core_t* core);
+Sint32   get_terrain_at(Sint32 pos_x, Sint32 pos_y, core_t* core);
+Uint32   get_tile_flags_in_rect(const SDL_Rect* rect, core_t* core);
+SDL_bool is_tile_flag_in_rect(const SDL_Rect* rect, Uint32 flag, core_t* core);
+Sint32   find_tiles_in_rect(const SDL_Rect* rect, Uint32 flag, SDL_Point* tile, Sint32 tile_max, core_t* core);
+
+#endif /* TILE_FLAG_H */
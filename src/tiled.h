@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef TILED_H
+#define TILED_H
+
+#include <SDL.h>
+#include <tmx.h>
+#include "core.h"
+
+Sint32            get_first_gid(tmx_map* tiled_map);
+tmx_layer*        get_head_layer(tmx_map* tiled_map);
+SDL_bool          is_tiled_layer_of_type(const enum tmx_layer_type tiled_type, tmx_layer* tiled_layer);
+tmx_object*       get_head_object(tmx_layer* tiled_layer, core_t* core);
+tmx_tileset*      get_head_tileset(tmx_map* tiled_map);
+Sint32*           get_layer_content(tmx_layer* tiled_layer);
+const char*       get_layer_name(tmx_layer* tiled_layer);
+Sint32            get_layer_property_count(tmx_layer* tiled_layer);
+Sint32            get_local_id(Sint32 gid, tmx_map* tiled_map);
+Sint32            get_map_property_count(tmx_map* tiled_map);
+Sint32            get_next_animated_tile_id(Sint32 gid, Sint32 current_frame, tmx_map* tiled_map);
+const char*       get_object_name(tmx_object* tiled_object);
+Sint32            get_object_property_count(tmx_object* tiled_object);
+const char*       get_object_type_name(tmx_object* tiled_object);
+Sint32            get_tile_height(tmx_map* tiled_map);
+void              get_tile_position(Sint32 gid, Sint32* pos_x, Sint32* pos_y, tmx_map* tiled_map);
+Sint32            get_tile_property_count(tmx_tile* tiled_tile);
+Sint32            get_tile_width(tmx_map* tiled_map);
+tmx_tileset_list* get_tileset_list_entry(Sint32 index, tmx_map* tiled_map);
+void              set_tileset_path(char* path_name, Sint32 path_length, Sint32 index, core_t* core);
+Sint32            get_tileset_path_length(Sint32 index, core_t* core);
+SDL_bool          is_gid_valid(Sint32 gid, tmx_map* tiled_map);
+SDL_bool          is_infinite_map(const char* map_file_name);
+SDL_bool          is_tile_animated(Sint32 gid, Sint32* animation_length, Sint32* id, tmx_map* tiled_map);
+Uint64            generate_hash(const unsigned char* name);
+status_t          load_tiled_map(const char* map_file_name, core_t* core);
+Sint32            remove_gid_flip_bits(Sint32 gid);
+SDL_bool          tile_has_properties(Sint32 gid, tmx_tile** tile, tmx_map* tiled_map);
+void              unload_tiled_map(core_t* core);
+SDL_bool          is_map_loaded(core_t* core);
+status_t          load_map_path(const char* map_file_name, core_t* core);
+status_t          load_surface_from_file(const char* file_name, SDL_Surface** surface);
+status_t          load_texture_from_file(const char* file_name, SDL_Texture** texture, core_t* core);
+status_t          create_and_set_render_target(SDL_Texture** target, core_t* core);
+void              destroy_render_targets(core_t* core);
+Sint32            set_render_target(SDL_Texture* texture, core_t* core);
+Sint32            render_copy(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst, core_t* core);
+#ifdef TILE_BATCH_SUPPORTED
+Sint32            render_geometry(SDL_Texture* texture, const SDL_Vertex* vertex, Sint32 vertex_count, const int* index, Sint32 index_count, core_t* core);
+#endif
+status_t          render_map(Sint32 level, core_t* core);
+status_t          render_scene(core_t* core);
+status_t          draw_scene(core_t* core);
+
+#endif /* TILED_H */
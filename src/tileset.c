@@ -0,0 +1,534 @@
+// SPDX-License-Identifier: MIT
+
+#include <SDL.h>
+#include <tmx.h>
+#include "arena.h"
+#include "blit.h"
+#include "cache.h"
+#include "core.h"
+#include "map_blob.h"
+#include "profile.h"
+#include "texture_blob.h"
+#include "tiled.h"
+#include "tileset.h"
+
+static status_t load_tileset_image(const char* file_name, SDL_Surface** surface, resource_t* resource, Sint32 image, core_t* core);
+static status_t pack_tileset_atlas(core_t* core);
+
+status_t load_tileset_table(core_t* core)
+{
+    map_t*            map = core->map;
+    tmx_tileset_list* tileset;
+    Sint32            index;
+
+    if (map->blob.data)
+    {
+        const map_blob_tileset_t* blob_tileset = (const map_blob_tileset_t*)get_map_blob_section(&map->blob, map->blob.header->tileset_offset);
+
+        map->tileset_count = (Sint32)map->blob.header->tileset_count;
+        map->tileset       = (tileset_t*)arena_calloc(map->arena, (size_t)map->tileset_count, sizeof(struct tileset));
+        if (! map->tileset)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            return CORE_ERROR;
+        }
+
+        for (index = 0; index < map->tileset_count; index += 1)
+        {
+            map->tileset[index].first_gid  = (Sint32)blob_tileset[index].first_gid;
+            map->tileset[index].tile_count = (Sint32)blob_tileset[index].tile_count;
+        }
+
+        return CORE_OK;
+    }
+
+    tileset = map->handle->ts_head;
+    while (tileset)
+    {
+        map->tileset_count += 1;
+        tileset             = tileset->next;
+    }
+
+    if (0 >= map->tileset_count || TILESET_MAX < map->tileset_count)
+    {
+        dbgprint("%s: unsupported number of tilesets (%d).", FUNCTION_NAME, map->tileset_count);
+        return CORE_ERROR;
+    }
+
+    map->tileset = (tileset_t*)arena_calloc(map->arena, (size_t)map->tileset_count, sizeof(struct tileset));
+    if (! map->tileset)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    index   = 0;
+    tileset = map->handle->ts_head;
+    while (tileset)
+    {
+        if (! tileset->tileset->image)
+        {
+            dbgprint("%s: image collection tilesets are not supported.", FUNCTION_NAME);
+            return CORE_ERROR;
+        }
+
+        map->tileset[index].first_gid  = (Sint32)tileset->firstgid;
+        map->tileset[index].tile_count = (Sint32)tileset->tileset->tilecount;
+
+        index  += 1;
+        tileset = tileset->next;
+    }
+
+    return CORE_OK;
+}
+
+/* Look up the image of every tileset in the resource cache and decode
+ * the missing ones.  If enabled, the images of maps with several
+ * tilesets are packed into a single atlas, so that drawing tiles never
+ * has to switch source textures; the atlas is cached as a whole.  No
+ * renderer is used, so this may run on the map loader thread; the
+ * images are turned into textures by upload_tileset_textures.
+ */
+status_t load_tileset_images(core_t* core)
+{
+    map_t*   map        = core->map;
+    char*    key[TILESET_MAX];
+    char*    atlas_key  = NULL;
+    size_t   key_length = 0;
+    status_t status     = CORE_ERROR;
+    Sint32   index;
+
+    SDL_zero(key);
+
+    // [1] Resource keys.
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        Sint32 path_length = get_tileset_path_length(index, core);
+        char*  image_path  = (char*)calloc(1, (size_t)path_length);
+
+        if (! image_path)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            goto exit;
+        }
+
+        set_tileset_path(image_path, path_length, index, core);
+        key[index] = get_cache_key(image_path);
+        free(image_path);
+        if (! key[index])
+        {
+            goto exit;
+        }
+        key_length += SDL_strlen(key[index]) + 1;
+    }
+
+    // [2] Atlas, cached under the keys of all of its images.
+    if (core->is_tileset_atlas_enabled && 1 < map->tileset_count)
+    {
+        atlas_key = (char*)calloc(1, key_length);
+        if (! atlas_key)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            goto exit;
+        }
+        for (index = 0; index < map->tileset_count; index += 1)
+        {
+            if (0 < index)
+            {
+                SDL_strlcat(atlas_key, "\n", key_length);
+            }
+            SDL_strlcat(atlas_key, key[index], key_length);
+        }
+
+        map->atlas = acquire_resource(atlas_key, core);
+        if (! map->atlas)
+        {
+            map->atlas = create_resource(atlas_key, map->tileset_count);
+            if (! map->atlas)
+            {
+                goto exit;
+            }
+
+            for (index = 0; index < map->tileset_count; index += 1)
+            {
+                if (CORE_OK != load_tileset_image(key[index], &map->tileset[index].surface, map->atlas, index, core))
+                {
+                    goto exit;
+                }
+            }
+
+            if (CORE_OK != pack_tileset_atlas(core))
+            {
+                dbgprint("%s: could not pack tileset atlas, using one texture per tileset.", FUNCTION_NAME);
+            }
+        }
+
+        if (map->atlas->texture || map->tileset_surface)
+        {
+            for (index = 0; index < map->tileset_count; index += 1)
+            {
+                map->tileset[index].resource = map->atlas;
+                map->tileset[index].image    = index;
+                map->tileset[index].offset   = map->atlas->offset[index];
+            }
+            status = CORE_OK;
+            goto exit;
+        }
+
+        release_resource(map->atlas, core);
+        map->atlas = NULL;
+    }
+
+    // [3] One resource per image, shared by the tilesets using it.
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        tileset_t* tileset = &map->tileset[index];
+        Sint32     other;
+
+        for (other = 0; other < index; other += 1)
+        {
+            if (0 == SDL_strcmp(key[other], key[index]))
+            {
+                break;
+            }
+        }
+
+        if (other < index)
+        {
+            tileset->resource = map->tileset[other].resource;
+            retain_resource(tileset->resource, core);
+        }
+        else
+        {
+            tileset->resource = acquire_resource(key[index], core);
+        }
+
+        if (tileset->resource)
+        {
+            if (tileset->surface)
+            {
+                SDL_FreeSurface(tileset->surface);
+                tileset->surface = NULL;
+            }
+            continue;
+        }
+
+        tileset->resource = create_resource(key[index], 1);
+        if (! tileset->resource)
+        {
+            goto exit;
+        }
+        if (CORE_OK != load_tileset_image(key[index], &tileset->surface, tileset->resource, 0, core))
+        {
+            goto exit;
+        }
+    }
+
+    status = CORE_OK;
+exit:
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        free(key[index]);
+    }
+    free(atlas_key);
+
+    return status;
+}
+
+/* Turn the decoded images into textures and publish their resources.
+ * Has to run on the main thread.
+ */
+status_t upload_tileset_textures(core_t* core)
+{
+    map_t* map = core->map;
+    Sint32 index;
+
+    if (map->atlas)
+    {
+        if (map->tileset_surface)
+        {
+            map->atlas->texture = SDL_CreateTextureFromSurface(core->renderer, map->tileset_surface);
+            if (! map->atlas->texture)
+            {
+                dbgprint("Could not create texture from surface: %s", SDL_GetError());
+                return CORE_ERROR;
+            }
+            PROFILE_COUNT(PROFILE_TEXTURE_BYTES, map->tileset_surface->h * map->tileset_surface->pitch, core);
+            SDL_FreeSurface(map->tileset_surface);
+            map->tileset_surface = NULL;
+        }
+        publish_resource(&map->atlas, core);
+
+        map->tileset_texture = map->atlas->texture;
+        for (index = 0; index < map->tileset_count; index += 1)
+        {
+            map->tileset[index].resource = map->atlas;
+            map->tileset[index].texture  = map->atlas->texture;
+        }
+
+        map->is_complete = SDL_TRUE;
+        return CORE_OK;
+    }
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        tileset_t*  tileset     = &map->tileset[index];
+        resource_t* unpublished = tileset->resource;
+        Sint32      other;
+
+        if (! tileset->resource->texture && tileset->surface)
+        {
+            tileset->resource->texture = SDL_CreateTextureFromSurface(core->renderer, tileset->surface);
+            if (! tileset->resource->texture)
+            {
+                dbgprint("Could not create texture from surface: %s", SDL_GetError());
+                return CORE_ERROR;
+            }
+            PROFILE_COUNT(PROFILE_TEXTURE_BYTES, tileset->surface->h * tileset->surface->pitch, core);
+            SDL_FreeSurface(tileset->surface);
+            tileset->surface = NULL;
+        }
+
+        // Tilesets sharing the resource follow it if it gets replaced.
+        publish_resource(&tileset->resource, core);
+        for (other = index + 1; other < map->tileset_count; other += 1)
+        {
+            if (map->tileset[other].resource == unpublished)
+            {
+                map->tileset[other].resource = tileset->resource;
+            }
+        }
+
+        tileset->texture = tileset->resource->texture;
+    }
+
+    map->is_complete = SDL_TRUE;
+    return CORE_OK;
+}
+
+void free_tilesets(core_t* core)
+{
+    map_t* map = core->map;
+    Sint32 index;
+
+    if (map->tileset_surface)
+    {
+        SDL_FreeSurface(map->tileset_surface);
+        map->tileset_surface = NULL;
+    }
+
+    if (map->tileset)
+    {
+        for (index = 0; index < map->tileset_count; index += 1)
+        {
+            if (map->tileset[index].surface)
+            {
+                SDL_FreeSurface(map->tileset[index].surface);
+            }
+            if (map->tileset[index].resource != map->atlas)
+            {
+                release_resource(map->tileset[index].resource, core);
+            }
+        }
+    }
+
+    release_resource(map->atlas, core);
+    map->atlas           = NULL;
+    map->tileset_texture = NULL;
+
+    // The tileset table lives in the map arena.
+    map->tileset       = NULL;
+    map->tileset_count = 0;
+}
+
+Sint32 get_tileset_first_gid(Sint32 gid, core_t* core)
+{
+    return core->map->tileset[core->map->render_list.gid_tileset[gid]].first_gid;
+}
+
+SDL_Texture* get_tile_texture(Sint32 gid, core_t* core)
+{
+    return core->map->tileset[core->map->render_list.gid_tileset[gid]].texture;
+}
+
+// Source position of a gid in the texture it is drawn from.
+void get_tile_source(Sint32 gid, SDL_Point* src, core_t* core)
+{
+    render_list_t* list = &core->map->render_list;
+
+    *src = list->position[gid];
+
+    if (core->map->tileset)
+    {
+        src->x += core->map->tileset[list->gid_tileset[gid]].offset.x;
+        src->y += core->map->tileset[list->gid_tileset[gid]].offset.y;
+    }
+}
+
+/* Load an image into *surface, unless that has been done already, and
+ * keep its size and, with the tile blitter, its pixels as image of the
+ * given resource.  A compiled texture stored next to the image is
+ * preferred, which needs neither decoding nor conversion.
+ */
+static status_t load_tileset_image(const char* file_name, SDL_Surface** surface, resource_t* resource, Sint32 image, core_t* core)
+{
+    SDL_bool is_compiled = SDL_FALSE;
+
+    if (! *surface)
+    {
+        switch (load_texture_blob(file_name, surface))
+        {
+            case CORE_OK:
+                is_compiled = SDL_TRUE;
+                break;
+            case CORE_WARNING:
+                if (CORE_OK != load_surface_from_file(file_name, surface))
+                {
+                    dbgprint("%s: Error loading image '%s'.", FUNCTION_NAME, file_name);
+                    return CORE_ERROR;
+                }
+                break;
+            default:
+                return CORE_ERROR;
+        }
+    }
+
+    resource->size[image].x = (*surface)->w;
+    resource->size[image].y = (*surface)->h;
+
+    if (core->is_tile_blitter_enabled && ! resource->pixels[image])
+    {
+        if (is_compiled)
+        {
+            return copy_blit_source(*surface, &resource->pixels[image]);
+        }
+        return load_blit_source(*surface, &resource->pixels[image]);
+    }
+
+    return CORE_OK;
+}
+
+/* Shelf packing: images are placed left to right in rows sorted by
+ * decreasing height.  The atlas is about as wide as it is high, but
+ * never exceeds the maximum texture size of the renderer.  On success
+ * the atlas replaces the images of the tilesets and the position of
+ * each image is stored in the atlas resource.
+ */
+static status_t pack_tileset_atlas(core_t* core)
+{
+    map_t*       map        = core->map;
+    SDL_Surface* surface[TILESET_MAX];
+    SDL_Surface* atlas;
+    Uint8        order[TILESET_MAX];
+    Uint64       area       = 0;
+    Sint32       max_width  = core->max_texture_size.x;
+    Sint32       max_height = core->max_texture_size.y;
+    Sint32       width      = 0;
+    Sint32       height;
+    Sint32       pos_x      = 0;
+    Sint32       pos_y      = 0;
+    Sint32       row_height = 0;
+    Sint32       index;
+    Sint32       sort_index;
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        surface[index] = map->tileset[index].surface;
+    }
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        Uint8 tileset = (Uint8)index;
+
+        area += (Uint64)surface[index]->w * (Uint64)surface[index]->h;
+        if (surface[index]->w > width)
+        {
+            width = surface[index]->w;
+        }
+
+        for (sort_index = index; sort_index > 0 && surface[order[sort_index - 1]]->h < surface[tileset]->h; sort_index -= 1)
+        {
+            order[sort_index] = order[sort_index - 1];
+        }
+        order[sort_index] = tileset;
+    }
+
+    while (width < max_width && (Uint64)width * (Uint64)width < area)
+    {
+        width *= 2;
+    }
+    if (width > max_width)
+    {
+        width = max_width;
+    }
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        SDL_Surface* image = surface[order[index]];
+
+        if (image->w > width)
+        {
+            return CORE_ERROR;
+        }
+
+        if (pos_x + image->w > width)
+        {
+            pos_x      = 0;
+            pos_y     += row_height;
+            row_height = 0;
+        }
+
+        map->atlas->offset[order[index]].x = pos_x;
+        map->atlas->offset[order[index]].y = pos_y;
+
+        pos_x += image->w;
+        if (image->h > row_height)
+        {
+            row_height = image->h;
+        }
+    }
+
+    height = pos_y + row_height;
+    if (height > max_height)
+    {
+        return CORE_ERROR;
+    }
+
+    // Color keyed pixels are skipped and stay fully transparent.
+    atlas = SDL_CreateRGBSurface(0, width, height, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+    if (! atlas)
+    {
+        dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+        return CORE_ERROR;
+    }
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        SDL_Rect dst;
+
+        dst.x = map->atlas->offset[index].x;
+        dst.y = map->atlas->offset[index].y;
+        dst.w = surface[index]->w;
+        dst.h = surface[index]->h;
+
+        SDL_SetSurfaceBlendMode(surface[index], SDL_BLENDMODE_NONE);
+        if (0 > SDL_BlitSurface(surface[index], NULL, atlas, &dst))
+        {
+            dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+            SDL_FreeSurface(atlas);
+            return CORE_ERROR;
+        }
+    }
+
+    map->tileset_surface = atlas;
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        SDL_FreeSurface(map->tileset[index].surface);
+        map->tileset[index].surface = NULL;
+    }
+
+    dbgprint("Packed %d tilesets into a %dx%d atlas.", map->tileset_count, width, height);
+
+    return CORE_OK;
+}
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef TILESET_H
+#define TILESET_H
+
+#include <SDL.h>
+#include "core.h"
+
+#define TILESET_MAX 255
+
+status_t     load_tileset_table(core_t* core);
+status_t     load_tileset_images(core_t* core);
+status_t     upload_tileset_textures(core_t* core);
+void         free_tilesets(core_t* core);
+Sint32       get_tileset_first_gid(Sint32 gid, core_t* core);
+SDL_Texture* get_tile_texture(Sint32 gid, core_t* core);
+void         get_tile_source(Sint32 gid, SDL_Point* src, core_t* core);
+
+#endif /* TILESET_H */
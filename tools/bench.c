@@ -0,0 +1,751 @@
+// SPDX-License-Identifier: MIT
+
+/* Headless frame-time benchmark.
+ *
+ * Runs the real init_core/load_map/update_core path under SDL's dummy
+ * video driver with the software renderer, replays a scripted camera
+ * path and reports per-phase frame-time percentiles as well as the
+ * number of render calls (copies and batched geometry) per frame.  The
+ * idle_frame phase runs update_core with a still camera, where every
+ * frame without animation changes is skipped.
+ *
+ * Usage: demo_bench [-r] [-t] [-s] [-b] [-p] [map file | -g <tiles>] [frame count]
+ *
+ * -r bakes chunks with SDL's renderer instead of the tile blitter, -t
+ * then draws one render copy per tile instead of one batched geometry
+ * call per chunk, -s keeps one texture per tileset instead of packing
+ * them into an atlas, -b bakes every chunk in the frame it becomes
+ * visible instead of spreading bakes over frames within a time budget.
+ * -p writes the frames of the update_core and idle_frame phases to
+ * profile.csv and profile.json, see profile.h; this needs a build with
+ * the profiler (-DDEMO_PROFILE=ON).
+ *
+ * With -g, a synthetic square map of the given size in tiles is
+ * generated next to the default map (using its tileset) and loaded
+ * instead, e.g. "demo_bench -g 1000" for a 1000x1000-tile map.  It
+ * has an object layer with one object per BENCH_OBJECT_SPACING tiles
+ * squared, over which the object queries of object.h are timed.
+ * Paths between random cells are timed as well, see path.h, and so
+ * are sweeps and rays against the collision grid, see collision.h.
+ *
+ * The map file may also be a compiled map (.cmap, see demo_mapc) to
+ * compare load time and peak memory growth against the TMX path.
+ *
+ * Finally, loading the map past the map cache and baking all visible
+ * chunks are timed with 0, 1, 2, 4... worker threads of the job
+ * system, up to one per core, and reported as speedups over 0.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <SDL.h>
+#include "arena.h"
+#include "blit.h"
+#include "cache.h"
+#include "chunk.h"
+#include "collision.h"
+#include "core.h"
+#include "job.h"
+#include "object.h"
+#include "path.h"
+#include "profile.h"
+#include "tiled.h"
+
+#define BENCH_DEFAULT_MAP    "res/demo.tmx"
+#define BENCH_DEFAULT_FRAMES 1000
+#define BENCH_SPEED_X        3
+#define BENCH_SPEED_Y        2
+#define BENCH_TILESET        "grass_biome.tsx"
+#define BENCH_TILE_COUNT     252
+#define BENCH_OBJECT_SPACING 4
+#define BENCH_OBJECT_MAX     256
+#define BENCH_PATH_COUNT     256
+#define BENCH_PATH_MAX       4096
+#define BENCH_BAKE_REPEAT    16
+
+typedef enum
+{
+    PHASE_UPDATE_CORE = 0,
+    PHASE_IDLE_FRAME,
+    PHASE_RENDER_SCENE,
+    PHASE_DRAW_SCENE,
+    PHASE_MAX
+
+} bench_phase;
+
+static const char* phase_name[PHASE_MAX] =
+{
+    "update_core",
+    "idle_frame",
+    "render_scene",
+    "draw_scene"
+};
+
+typedef struct bench
+{
+    double* frame_time[PHASE_MAX];
+    double* copy_count[PHASE_MAX];
+    Sint32  frame_count;
+    double  ticks_per_us;
+
+} bench_t;
+
+static int compare_double(const void* a, const void* b)
+{
+    double lhs = *(const double*)a;
+    double rhs = *(const double*)b;
+
+    if (lhs < rhs)
+    {
+        return -1;
+    }
+    if (lhs > rhs)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+// Nearest-rank percentile of an already sorted sample set.
+static double get_percentile(const double* sample, Sint32 count, Sint32 percentile)
+{
+    Sint32 rank = (percentile * count + 99) / 100;
+
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    return sample[rank - 1];
+}
+
+// Triangle wave between 0 and range: the camera bounces between map edges.
+static Sint32 get_ping_pong(Sint32 value, Sint32 range)
+{
+    Sint32 period;
+
+    if (0 >= range)
+    {
+        return 0;
+    }
+
+    period = range * 2;
+    value  = value % period;
+
+    return (value < range) ? value : period - value;
+}
+
+// The scripted position is used as is, without interpolation.
+static void set_camera(Sint32 frame, core_t* core)
+{
+    core->camera.pos_x      = get_ping_pong(frame * BENCH_SPEED_X, core->map->width  - 176);
+    core->camera.pos_y      = get_ping_pong(frame * BENCH_SPEED_Y, core->map->height - 208);
+    core->camera.prev_pos_x = core->camera.pos_x;
+    core->camera.prev_pos_y = core->camera.pos_y;
+    core->camera.view_x     = core->camera.pos_x;
+    core->camera.view_y     = core->camera.pos_y;
+}
+
+/* Write a map of size x size tiles with two CSV-encoded layers, a
+ * dense ground layer and a sparse overlay, and an object layer.
+ */
+static status_t generate_map(const char* file_name, Sint32 size)
+{
+    FILE*  fp;
+    Uint32 seed = 0x2545f491;
+    Sint32 layer;
+    Sint32 index;
+
+    fp = fopen(file_name, "w");
+    if (! fp)
+    {
+        fprintf(stderr, "Could not create %s.\n", file_name);
+        return CORE_ERROR;
+    }
+
+    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(fp, "<map version=\"1.8\" orientation=\"orthogonal\" renderorder=\"right-down\" "
+                "width=\"%d\" height=\"%d\" tilewidth=\"16\" tileheight=\"16\" infinite=\"0\">\n", size, size);
+    fprintf(fp, " <tileset firstgid=\"1\" source=\"%s\"/>\n", BENCH_TILESET);
+
+    for (layer = 0; layer < 2; layer += 1)
+    {
+        fprintf(fp, " <layer id=\"%d\" name=\"Layer %d\" width=\"%d\" height=\"%d\">\n", layer + 1, layer + 1, size, size);
+        fprintf(fp, "  <data encoding=\"csv\">\n");
+
+        for (index = 0; index < size * size; index += 1)
+        {
+            Uint32 gid;
+
+            seed = seed * 1664525 + 1013904223;
+            gid  = ((seed >> 16) % BENCH_TILE_COUNT) + 1;
+
+            if (0 < layer && 0 != ((seed >> 8) & 7))
+            {
+                gid = 0;
+            }
+            fprintf(fp, (index + 1 < size * size) ? "%u," : "%u\n", gid);
+        }
+
+        fprintf(fp, "  </data>\n </layer>\n");
+    }
+
+    fprintf(fp, " <objectgroup id=\"3\" name=\"Objects\">\n");
+    for (index = 0; index < (size / BENCH_OBJECT_SPACING) * (size / BENCH_OBJECT_SPACING); index += 1)
+    {
+        Sint32 pos_x = (index % (size / BENCH_OBJECT_SPACING)) * BENCH_OBJECT_SPACING * 16;
+        Sint32 pos_y = (index / (size / BENCH_OBJECT_SPACING)) * BENCH_OBJECT_SPACING * 16;
+
+        seed = seed * 1664525 + 1013904223;
+        fprintf(fp, "  <object id=\"%d\" type=\"%s\" x=\"%d\" y=\"%d\" width=\"%u\" height=\"%u\"/>\n",
+                index + 1, (seed & 1) ? "trigger" : "npc",
+                pos_x + (Sint32)((seed >> 8) % 32), pos_y + (Sint32)((seed >> 16) % 32),
+                16 + ((seed >> 24) % 48), 16 + ((seed >> 4) % 48));
+    }
+    fprintf(fp, " </objectgroup>\n");
+
+    fprintf(fp, "</map>\n");
+    fclose(fp);
+
+    return CORE_OK;
+}
+
+// Peak resident set size of the process so far, in KiB.
+static long get_peak_memory(void)
+{
+    struct rusage usage;
+
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+    {
+        return 0;
+    }
+    return usage.ru_maxrss;
+}
+
+static double get_elapsed_us(Uint64 start, bench_t* bench)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) / bench->ticks_per_us;
+}
+
+/* Time a view query and a point query at the center of the view for
+ * each camera position of the path, in microseconds per query.
+ */
+static void time_object_queries(core_t* core, bench_t* bench)
+{
+    Sint32 result[BENCH_OBJECT_MAX];
+    double view_time  = 0.0;
+    double point_time = 0.0;
+    Uint32 view_found = 0;
+    Sint32 frame;
+
+    for (frame = 0; frame < bench->frame_count; frame += 1)
+    {
+        Uint64 start;
+
+        set_camera(frame, core);
+
+        start       = SDL_GetPerformanceCounter();
+        view_found += (Uint32)query_objects_in_view(result, BENCH_OBJECT_MAX, core);
+        view_time  += get_elapsed_us(start, bench);
+
+        start = SDL_GetPerformanceCounter();
+        query_objects_at_point(core->camera.view_x - core->map->pos_x + (176 / 2),
+                               core->camera.view_y - core->map->pos_y + (208 / 2),
+                               result, BENCH_OBJECT_MAX, core);
+        point_time += get_elapsed_us(start, bench);
+    }
+
+    printf("objects: %d, view query: %.2f us (%.1f found), point query: %.2f us\n",
+           core->map->object.count,
+           view_time  / bench->frame_count,
+           (double)view_found / bench->frame_count,
+           point_time / bench->frame_count);
+}
+
+/* Time a sweep of an entity-sized box and a ray cast from the center
+ * of the view towards its corners for each camera position of the
+ * path, in microseconds per query.
+ */
+static void time_collision_queries(core_t* core, bench_t* bench)
+{
+    double sweep_time = 0.0;
+    double ray_time   = 0.0;
+    Uint32 ray_hits   = 0;
+    Sint32 frame;
+
+    for (frame = 0; frame < bench->frame_count; frame += 1)
+    {
+        SDL_Rect  box;
+        SDL_Point delta;
+        SDL_Point from;
+        SDL_Point to;
+        SDL_Point hit;
+        Uint64    start;
+
+        set_camera(frame, core);
+
+        from.x  = core->camera.view_x + (176 / 2);
+        from.y  = core->camera.view_y + (208 / 2);
+        box.x   = from.x;
+        box.y   = from.y;
+        box.w   = 16;
+        box.h   = 16;
+        delta.x = (frame & 1) ? 64 : -64;
+        delta.y = (frame & 2) ? 64 : -64;
+        to.x    = core->camera.view_x + ((frame & 1) ? 175 : 0);
+        to.y    = core->camera.view_y + ((frame & 2) ? 207 : 0);
+
+        start       = SDL_GetPerformanceCounter();
+        sweep_rect(&box, &delta, core);
+        sweep_time += get_elapsed_us(start, bench);
+
+        start     = SDL_GetPerformanceCounter();
+        ray_hits += cast_ray(&from, &to, &hit, core) ? 1 : 0;
+        ray_time += get_elapsed_us(start, bench);
+    }
+
+    printf("collision: sweep: %.2f us, ray cast: %.2f us (%u hit)\n",
+           sweep_time / bench->frame_count,
+           ray_time   / bench->frame_count,
+           ray_hits);
+}
+
+/* Time BENCH_PATH_COUNT paths between random cells, then the same
+ * paths again, which come from the path cache.
+ */
+static void time_path_queries(core_t* core, bench_t* bench)
+{
+    path_grid_t* grid       = &core->map->path_grid;
+    SDL_Point*   path       = (SDL_Point*)calloc(BENCH_PATH_MAX, sizeof(SDL_Point));
+    double       time[2]    = { 0.0, 0.0 };
+    Sint32       found      = 0;
+    Uint32       hit_count  = grid->hit_count;
+    Sint32       round;
+    Sint32       index;
+
+    if (! path || 0 >= grid->width)
+    {
+        free(path);
+        return;
+    }
+
+    for (round = 0; round < 2; round += 1)
+    {
+        Uint32 seed = 0x9e3779b9;
+
+        for (index = 0; index < BENCH_PATH_COUNT; index += 1)
+        {
+            SDL_Point start;
+            SDL_Point goal;
+            Uint64    begin;
+
+            seed    = seed * 1664525 + 1013904223;
+            start.x = (Sint32)((seed >> 8) % (Uint32)grid->width);
+            seed    = seed * 1664525 + 1013904223;
+            start.y = (Sint32)((seed >> 8) % (Uint32)grid->height);
+            seed    = seed * 1664525 + 1013904223;
+            goal.x  = (Sint32)((seed >> 8) % (Uint32)grid->width);
+            seed    = seed * 1664525 + 1013904223;
+            goal.y  = (Sint32)((seed >> 8) % (Uint32)grid->height);
+
+            begin = SDL_GetPerformanceCounter();
+            if (0 < find_path(&start, &goal, path, BENCH_PATH_MAX, core) && 0 == round)
+            {
+                found += 1;
+            }
+            time[round] += get_elapsed_us(begin, bench);
+        }
+    }
+
+    printf("paths: %d of %d found, %.1f us per path, %.2f us cached (%u hits)\n",
+           found, BENCH_PATH_COUNT,
+           time[0] / BENCH_PATH_COUNT,
+           time[1] / BENCH_PATH_COUNT,
+           grid->hit_count - hit_count);
+
+    free(path);
+}
+
+/* Time a load of the map with an empty map cache and the bake of all
+ * visible chunks for each worker thread count.  The job system is
+ * restored to its default afterwards.
+ */
+static status_t time_job_scaling(const char* map_file_name, core_t* core, bench_t* bench)
+{
+    cache_stats_t cache_stats;
+    SDL_bool      is_progressive_bake_enabled = core->is_progressive_bake_enabled;
+    Sint32        thread_max                  = SDL_min(SDL_GetCPUCount() - 1, JOB_THREAD_MAX);
+    Sint32        thread_count                = 0;
+    double        base_load_time              = 0.0;
+    double        base_bake_time              = 0.0;
+    status_t      status                      = CORE_OK;
+
+    get_cache_stats(&cache_stats, core);
+    core->is_progressive_bake_enabled = SDL_FALSE;
+
+    for (;;)
+    {
+        double load_time;
+        double bake_time;
+        Uint64 start;
+        Sint32 repeat;
+        Sint32 layer;
+
+        free_job_system(core);
+        if (CORE_ERROR == init_job_system(thread_count, core))
+        {
+            status = CORE_ERROR;
+            break;
+        }
+
+        unload_map(core);
+        set_cache_budget(0, core);
+        set_cache_budget(cache_stats.budget, core);
+
+        start = SDL_GetPerformanceCounter();
+        if (CORE_OK != load_map(map_file_name, core))
+        {
+            fprintf(stderr, "Could not reload %s.\n", map_file_name);
+            status = CORE_ERROR;
+            break;
+        }
+        load_time = get_elapsed_us(start, bench);
+
+        start = SDL_GetPerformanceCounter();
+        for (repeat = 0; repeat < BENCH_BAKE_REPEAT; repeat += 1)
+        {
+            start_chunk_baking(core);
+            for (layer = 0; layer < MAP_LAYER_MAX; layer += 1)
+            {
+                reset_chunk_cache(&core->map->chunk_cache[layer]);
+                if (CORE_OK != update_chunk_cache(&core->map->chunk_cache[layer], core))
+                {
+                    status = CORE_ERROR;
+                }
+            }
+        }
+        bake_time = get_elapsed_us(start, bench) / BENCH_BAKE_REPEAT;
+
+        if (0 == thread_count)
+        {
+            base_load_time = load_time;
+            base_bake_time = bake_time;
+        }
+
+        printf("jobs: %d worker(s), load_map: %.1f us (%.2fx), bake: %.1f us (%.2fx), %d steal(s)\n",
+               get_job_thread_count(core),
+               load_time, base_load_time / load_time,
+               bake_time, base_bake_time / bake_time,
+               SDL_AtomicGet(&core->jobs->steal_count));
+
+        if (CORE_OK != status || thread_count >= thread_max)
+        {
+            break;
+        }
+        thread_count = SDL_min(thread_count ? thread_count * 2 : 1, thread_max);
+    }
+
+    core->is_progressive_bake_enabled = is_progressive_bake_enabled;
+
+    free_job_system(core);
+    init_job_system(JOB_THREAD_AUTO, core);
+
+    return status;
+}
+
+static status_t run_phase(bench_phase phase, core_t* core, bench_t* bench)
+{
+    status_t status = CORE_OK;
+    Sint32   frame;
+
+    for (frame = 0; frame < bench->frame_count; frame += 1)
+    {
+        Uint64 start;
+
+        // Idle frames keep the camera still, so nothing needs to be rendered.
+        set_camera((PHASE_IDLE_FRAME == phase) ? 0 : frame, core);
+        core->render_copy_count = 0;
+
+        start = SDL_GetPerformanceCounter();
+        switch (phase)
+        {
+            case PHASE_UPDATE_CORE:
+            case PHASE_IDLE_FRAME:
+                status = update_core(core);
+                break;
+            case PHASE_RENDER_SCENE:
+                status = render_scene(core);
+                break;
+            case PHASE_DRAW_SCENE:
+                /* draw_scene presents whatever render_scene produced,
+                 * so the scene has to be rendered first.  Only the
+                 * presentation is timed.
+                 */
+                status = render_scene(core);
+                if (CORE_OK == status)
+                {
+                    core->render_copy_count = 0;
+                    start  = SDL_GetPerformanceCounter();
+                    status = draw_scene(core);
+                }
+                break;
+            default:
+                break;
+        }
+
+        bench->frame_time[phase][frame] = get_elapsed_us(start, bench);
+        bench->copy_count[phase][frame] = (double)core->render_copy_count;
+
+        if (CORE_OK != status)
+        {
+            dbgprint("%s: aborted at frame %d.", phase_name[phase], frame);
+            return status;
+        }
+    }
+
+    return CORE_OK;
+}
+
+static void print_report(bench_t* bench)
+{
+    Sint32 index;
+
+    printf("%-14s %10s %10s %10s %10s %8s %8s %8s\n",
+           "phase", "p50 [us]", "p95 [us]", "p99 [us]", "max [us]",
+           "copy p50", "copy p95", "copy p99");
+
+    for (index = 0; index < PHASE_MAX; index += 1)
+    {
+        double* time = bench->frame_time[index];
+        double* copy = bench->copy_count[index];
+        Sint32  n    = bench->frame_count;
+
+        SDL_qsort(time, (size_t)n, sizeof(double), compare_double);
+        SDL_qsort(copy, (size_t)n, sizeof(double), compare_double);
+
+        printf("%-14s %10.1f %10.1f %10.1f %10.1f %8.0f %8.0f %8.0f\n",
+               phase_name[index],
+               get_percentile(time, n, 50),
+               get_percentile(time, n, 95),
+               get_percentile(time, n, 99),
+               time[n - 1],
+               get_percentile(copy, n, 50),
+               get_percentile(copy, n, 95),
+               get_percentile(copy, n, 99));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char*   map_file_name               = BENCH_DEFAULT_MAP;
+    char          generated_map[64];
+    core_t*       core                        = NULL;
+    bench_t       bench;
+    cache_stats_t cache_stats;
+    arena_stats_t arena_stats;
+    Uint64        start;
+    double        load_time;
+    long          peak_memory;
+    SDL_bool      is_tile_blitter_enabled     = SDL_TRUE;
+    SDL_bool      is_tile_batch_enabled       = SDL_TRUE;
+    SDL_bool      is_tileset_atlas_enabled    = SDL_TRUE;
+    SDL_bool      is_progressive_bake_enabled = SDL_TRUE;
+    SDL_bool      is_profile_dumped           = SDL_FALSE;
+    Sint32        index;
+    int           status                      = EXIT_FAILURE;
+
+    SDL_zero(bench);
+    bench.frame_count = BENCH_DEFAULT_FRAMES;
+
+    for (; argc > 1; argc -= 1, argv += 1)
+    {
+        if (0 == SDL_strcmp(argv[1], "-r"))
+        {
+            is_tile_blitter_enabled = SDL_FALSE;
+        }
+        else if (0 == SDL_strcmp(argv[1], "-t"))
+        {
+            is_tile_batch_enabled = SDL_FALSE;
+        }
+        else if (0 == SDL_strcmp(argv[1], "-s"))
+        {
+            is_tileset_atlas_enabled = SDL_FALSE;
+        }
+        else if (0 == SDL_strcmp(argv[1], "-b"))
+        {
+            is_progressive_bake_enabled = SDL_FALSE;
+        }
+        else if (0 == SDL_strcmp(argv[1], "-p"))
+        {
+            is_profile_dumped = SDL_TRUE;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc > 2 && 0 == SDL_strcmp(argv[1], "-g"))
+    {
+        Sint32 size = SDL_atoi(argv[2]);
+
+        if (0 >= size)
+        {
+            fprintf(stderr, "Invalid map size.\n");
+            return EXIT_FAILURE;
+        }
+
+        SDL_snprintf(generated_map, sizeof(generated_map), "res/bench_%d.tmx", size);
+        if (CORE_OK != generate_map(generated_map, size))
+        {
+            return EXIT_FAILURE;
+        }
+
+        map_file_name = generated_map;
+        argc -= 1;
+        argv += 1;
+    }
+    else if (argc > 1)
+    {
+        map_file_name = argv[1];
+    }
+    if (argc > 2)
+    {
+        bench.frame_count = SDL_atoi(argv[2]);
+    }
+    if (0 >= bench.frame_count)
+    {
+        fprintf(stderr, "Invalid frame count.\n");
+        return EXIT_FAILURE;
+    }
+
+    for (index = 0; index < PHASE_MAX; index += 1)
+    {
+        bench.frame_time[index] = (double*)calloc((size_t)bench.frame_count, sizeof(double));
+        bench.copy_count[index] = (double*)calloc((size_t)bench.frame_count, sizeof(double));
+        if (! bench.frame_time[index] || ! bench.copy_count[index])
+        {
+            fprintf(stderr, "Error allocating memory.\n");
+            goto quit;
+        }
+    }
+
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+    if (CORE_ERROR == init_core("demo_bench", &core))
+    {
+        goto quit;
+    }
+
+    bench.ticks_per_us = (double)SDL_GetPerformanceFrequency() / 1000000.0;
+
+    set_frame_rate_cap(0, core);
+
+    core->is_tileset_atlas_enabled    = is_tileset_atlas_enabled;
+    core->is_tile_blitter_enabled     = is_tile_blitter_enabled;
+    core->is_progressive_bake_enabled = is_progressive_bake_enabled;
+    if (! is_tile_batch_enabled)
+    {
+        core->is_tile_batch_enabled = SDL_FALSE;
+    }
+
+    peak_memory = get_peak_memory();
+    start       = SDL_GetPerformanceCounter();
+    if (CORE_OK != load_map(map_file_name, core))
+    {
+        fprintf(stderr, "Could not load %s.\n", map_file_name);
+        goto quit;
+    }
+    load_time   = get_elapsed_us(start, &bench);
+    peak_memory = get_peak_memory() - peak_memory;
+
+    printf("map: %s (%dx%d px), frames: %d, load_map: %.1f us, peak memory: +%ld KiB\n",
+           map_file_name, core->map->width, core->map->height, bench.frame_count, load_time, peak_memory);
+
+    get_arena_stats(&arena_stats, core->map->arena);
+    printf("map arena: %u bytes in use, %u peak, %u reserved in %d blocks\n",
+           (unsigned)arena_stats.byte_count, (unsigned)arena_stats.peak_byte_count,
+           (unsigned)arena_stats.reserved_byte_count, arena_stats.block_count);
+
+    time_object_queries(core, &bench);
+    time_collision_queries(core, &bench);
+    time_path_queries(core, &bench);
+
+    for (index = 0; index < PHASE_MAX; index += 1)
+    {
+        if (CORE_OK != run_phase((bench_phase)index, core, &bench))
+        {
+            goto quit;
+        }
+    }
+
+    print_report(&bench);
+
+    if (is_profile_dumped)
+    {
+#ifdef PROFILE_ENABLED
+        if (CORE_OK == dump_profile("profile.csv", "profile.json", core))
+        {
+            printf("profile: profile.csv, profile.json\n");
+        }
+#else
+        fprintf(stderr, "Built without the profiler: -p ignored.\n");
+#endif
+    }
+
+    printf("tile rendering: %s, tilesets: %d (%s)\n",
+           is_tile_blitter_ready(core) ? "tile blitter" : (core->is_tile_batch_enabled ? "batched" : "per tile"),
+           core->map->tileset_count,
+           core->map->tileset_texture ? "atlas" : "one texture each");
+
+    printf("skipped frames: %u\n", core->skipped_frame_count);
+
+    printf("layer cache: %u bytes, %u chunk bakes, %u chunks drawn unbaked\n",
+           (unsigned)(get_chunk_cache_size(&core->map->chunk_cache[MAP_LAYER_BG]) +
+                      get_chunk_cache_size(&core->map->chunk_cache[MAP_LAYER_FG])),
+           core->map->chunk_cache[MAP_LAYER_BG].bake_count + core->map->chunk_cache[MAP_LAYER_FG].bake_count,
+           core->map->chunk_cache[MAP_LAYER_BG].direct_draw_count + core->map->chunk_cache[MAP_LAYER_FG].direct_draw_count);
+
+    // Going back to a map takes it out of the map cache.
+    unload_map(core);
+    start = SDL_GetPerformanceCounter();
+    if (CORE_OK != load_map(map_file_name, core))
+    {
+        fprintf(stderr, "Could not reload %s.\n", map_file_name);
+        goto quit;
+    }
+    load_time = get_elapsed_us(start, &bench);
+
+    get_cache_stats(&cache_stats, core);
+    printf("reload: %.1f us, map cache: %d maps, %u bytes, %u hits, %u misses\n",
+           load_time, cache_stats.map_count, (unsigned)cache_stats.map_byte_count,
+           cache_stats.map_hit_count, cache_stats.map_miss_count);
+    printf("resource cache: %d resources, %u bytes, %u hits, %u misses\n",
+           cache_stats.resource_count, (unsigned)cache_stats.resource_byte_count,
+           cache_stats.resource_hit_count, cache_stats.resource_miss_count);
+
+    if (CORE_OK != time_job_scaling(map_file_name, core, &bench))
+    {
+        goto quit;
+    }
+
+    status = EXIT_SUCCESS;
+
+quit:
+    if (core)
+    {
+        if (is_map_loaded(core))
+        {
+            unload_map(core);
+        }
+        free_core(core);
+    }
+    for (index = 0; index < PHASE_MAX; index += 1)
+    {
+        free(bench.frame_time[index]);
+        free(bench.copy_count[index]);
+    }
+
+    return status;
+}
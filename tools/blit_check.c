@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: MIT
+
+/* Tile blitter validation and micro-benchmark.
+ *
+ * Composites every chunk of a map with the tile blitter and with SDL's
+ * software renderer, compares the results pixel by pixel and reports
+ * the time each path takes per chunk: compositing and uploading for
+ * the blitter, drawing to a render target for SDL.
+ *
+ * Usage: demo_blit_check [-t] [map file]
+ *
+ * With -t, the SDL path draws one render copy per tile instead of one
+ * batched geometry call per chunk.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "blit.h"
+#include "chunk.h"
+#include "core.h"
+#include "tiled.h"
+
+#define BLIT_CHECK_DEFAULT_MAP "res/demo.tmx"
+
+int main(int argc, char *argv[])
+{
+    const char*    map_file_name = BLIT_CHECK_DEFAULT_MAP;
+    core_t*        core          = NULL;
+    render_list_t* list;
+    SDL_Texture*   target        = NULL;
+    SDL_Texture*   streaming     = NULL;
+    Uint16*        blitted       = NULL;
+    Uint16*        rendered      = NULL;
+    SDL_bool       is_batched    = SDL_TRUE;
+    Sint32         width;
+    Sint32         height;
+    Sint32         chunk_count;
+    Sint32         chunk_index;
+    Sint32         index;
+    Sint32         mismatch      = 0;
+    Uint64         start;
+    Uint64         blit_ticks    = 0;
+    Uint64         render_ticks  = 0;
+    double         ticks_per_us;
+    int            status        = EXIT_FAILURE;
+
+    if (argc > 1 && 0 == SDL_strcmp(argv[1], "-t"))
+    {
+        is_batched = SDL_FALSE;
+        argc -= 1;
+        argv += 1;
+    }
+    if (argc > 1)
+    {
+        map_file_name = argv[1];
+    }
+
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+    if (CORE_ERROR == init_core("demo_blit_check", &core))
+    {
+        goto quit;
+    }
+    if (! is_batched)
+    {
+        core->is_tile_batch_enabled = SDL_FALSE;
+    }
+
+    if (CORE_OK != load_map(map_file_name, core))
+    {
+        fprintf(stderr, "Could not load %s.\n", map_file_name);
+        goto quit;
+    }
+    if (! is_tile_blitter_ready(core))
+    {
+        fprintf(stderr, "The tile blitter does not support %s.\n", map_file_name);
+        goto quit;
+    }
+
+    list         = &core->map->render_list;
+    width        = list->tile_width  * CHUNK_SIZE;
+    height       = list->tile_height * CHUNK_SIZE;
+    chunk_count  = list->chunk_count_x * list->chunk_count_y;
+    ticks_per_us = (double)SDL_GetPerformanceFrequency() / 1000000.0;
+
+    blitted   = (Uint16*)calloc((size_t)(width * height), sizeof(Uint16));
+    rendered  = (Uint16*)calloc((size_t)(width * height), sizeof(Uint16));
+    target    = SDL_CreateTexture(core->renderer, SDL_PIXELFORMAT_RGB444, SDL_TEXTUREACCESS_TARGET, width, height);
+    streaming = SDL_CreateTexture(core->renderer, SDL_PIXELFORMAT_RGB444, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (! blitted || ! rendered || ! target || ! streaming)
+    {
+        fprintf(stderr, "Error allocating memory.\n");
+        goto quit;
+    }
+
+    if (0 > SDL_SetRenderTarget(core->renderer, target))
+    {
+        fprintf(stderr, "%s\n", SDL_GetError());
+        goto quit;
+    }
+
+    for (chunk_index = 0; chunk_index < chunk_count; chunk_index += 1)
+    {
+        // [1] Tile blitter.
+        start = SDL_GetPerformanceCounter();
+        fill_blit_rect(blitted, width, width, height, get_blit_clear_color(core));
+        blit_chunk(chunk_index, blitted, width, core);
+        SDL_UpdateTexture(streaming, NULL, blitted, width * (int)sizeof(Uint16));
+        blit_ticks += SDL_GetPerformanceCounter() - start;
+
+        // [2] SDL.
+        start = SDL_GetPerformanceCounter();
+        SDL_RenderClear(core->renderer);
+        if (CORE_OK != render_chunk(chunk_index, 0, 0, core))
+        {
+            goto quit;
+        }
+        render_ticks += SDL_GetPerformanceCounter() - start;
+
+        if (0 > SDL_RenderReadPixels(core->renderer, NULL, SDL_PIXELFORMAT_RGB444, rendered, width * (int)sizeof(Uint16)))
+        {
+            fprintf(stderr, "%s\n", SDL_GetError());
+            goto quit;
+        }
+
+        // [3] Compare, ignoring the unused upper nibble.
+        for (index = 0; index < width * height; index += 1)
+        {
+            if ((blitted[index] & 0x0fff) != (rendered[index] & 0x0fff))
+            {
+                if (0 == mismatch)
+                {
+                    fprintf(stderr, "chunk %d, pixel (%d, %d): blitter %03x, SDL %03x\n",
+                            chunk_index, index % width, index / width, blitted[index] & 0x0fff, rendered[index] & 0x0fff);
+                }
+                mismatch += 1;
+            }
+        }
+    }
+
+    printf("map: %s, chunks: %d, SDL path: %s\n", map_file_name, chunk_count, is_batched ? "batched" : "per tile");
+    printf("%-8s %12s\n", "path", "us/chunk");
+    printf("%-8s %12.2f\n", "blitter", (double)blit_ticks   / ticks_per_us / chunk_count);
+    printf("%-8s %12.2f\n", "SDL",     (double)render_ticks / ticks_per_us / chunk_count);
+
+    if (0 != mismatch)
+    {
+        fprintf(stderr, "%d pixels differ.\n", mismatch);
+        goto quit;
+    }
+    printf("All pixels match.\n");
+
+    status = EXIT_SUCCESS;
+
+quit:
+    if (target)
+    {
+        SDL_DestroyTexture(target);
+    }
+    if (streaming)
+    {
+        SDL_DestroyTexture(streaming);
+    }
+    free(blitted);
+    free(rendered);
+    if (core)
+    {
+        if (is_map_loaded(core))
+        {
+            unload_map(core);
+        }
+        free_core(core);
+    }
+
+    return status;
+}
@@ -0,0 +1,1048 @@
+// SPDX-License-Identifier: MIT
+
+/* Offline map compiler.
+ *
+ * Loads a Tiled map and its tilesets through the regular TMX path,
+ * compiles the render list, animations, properties, tile flags and
+ * objects and writes them as a compiled map blob (see
+ * src/map_blob.h) that load_map can use in place.
+ *
+ * Usage: demo_mapc <map.tmx> [map.cmap]
+ *
+ * Without an output file name, the blob is written next to the input
+ * with its extension replaced by .cmap.
+ *
+ * Infinite maps are compiled into streamed maps.  libtmx cannot parse
+ * their chunked layers, so a copy of the map with a single empty cell
+ * per layer is loaded through the regular path for everything but the
+ * tiles, which are read from the chunks of the map with libxml2.
+ * Chunks have to be square, a multiple of CHUNK_SIZE on a side and
+ * aligned to their size, as Tiled writes them by default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+#include <tmx.h>
+#include <cwalk.h>
+#include <zlib.h>
+#include "animation.h"
+#include "arena.h"
+#include "core.h"
+#include "map_blob.h"
+#include "object.h"
+#include "property.h"
+#include "render_list.h"
+#include "tile_flag.h"
+#include "tiled.h"
+#include "tileset.h"
+
+typedef struct string_pool
+{
+    char*  data;
+    Uint32 size;
+    Uint32 capacity;
+
+} string_pool_t;
+
+// One layer of a chunk of an infinite map.
+typedef struct layer_chunk
+{
+    Sint32  index_x; // In chunks.
+    Sint32  index_y;
+    Sint32  layer_index;
+    Uint16* gid;
+
+} layer_chunk_t;
+
+typedef struct infinite_map
+{
+    layer_chunk_t* layer_chunk;
+    Sint32         layer_chunk_count;
+    Sint32         layer_chunk_capacity;
+    Sint32         chunk_size;
+    Sint32         chunk_count; // Chunks with at least one layer.
+    Sint32         chunk_count_x;
+    Sint32         chunk_count_y;
+    Sint32         layer_count;
+    Sint32         gid_count;
+
+} infinite_map_t;
+
+static Uint32 align_offset(Uint32 offset)
+{
+    return (offset + MAP_BLOB_ALIGNMENT - 1) & ~(Uint32)(MAP_BLOB_ALIGNMENT - 1);
+}
+
+// Append a string to the pool and return its offset, or -1 on failure.
+static Sint32 add_string(string_pool_t* pool, const char* string, size_t length)
+{
+    Uint32 offset = pool->size;
+
+    if (pool->size + length + 1 > pool->capacity)
+    {
+        Uint32 capacity = pool->capacity ? pool->capacity : 256;
+        char*  data;
+
+        while (pool->size + length + 1 > capacity)
+        {
+            capacity *= 2;
+        }
+
+        data = (char*)realloc(pool->data, capacity);
+        if (! data)
+        {
+            return -1;
+        }
+        pool->data     = data;
+        pool->capacity = capacity;
+    }
+
+    SDL_memcpy(&pool->data[pool->size], string, length);
+    pool->data[pool->size + length] = '\0';
+    pool->size += (Uint32)length + 1;
+
+    return (Sint32)offset;
+}
+
+/* Flatten the property table of the map.  Strings are moved into the
+ * string pool and referenced by offset.
+ */
+static status_t collect_properties(map_blob_property_t* blob_property, string_pool_t* pool, core_t* core)
+{
+    property_table_t* table = &core->map->property;
+    Uint32            count = 0;
+    Uint32            index;
+
+    for (index = 0; index < table->capacity; index += 1)
+    {
+        const property_entry_t* entry = &table->entry[index];
+
+        if (PT_NONE == entry->type)
+        {
+            continue;
+        }
+
+        blob_property[count].hash  = entry->hash;
+        blob_property[count].owner = entry->owner;
+        blob_property[count].type  = entry->type;
+
+        if (PT_STRING == entry->type || PT_FILE == entry->type)
+        {
+            Sint32 offset = add_string(pool, entry->value.string, SDL_strlen(entry->value.string));
+
+            if (0 > offset)
+            {
+                return CORE_ERROR;
+            }
+            blob_property[count].value.string = (Uint32)offset;
+        }
+        else if (PT_FLOAT == entry->type)
+        {
+            blob_property[count].value.decimal = entry->value.decimal;
+        }
+        else
+        {
+            blob_property[count].value.integer = entry->value.integer;
+        }
+
+        count += 1;
+    }
+
+    return CORE_OK;
+}
+
+// Copy the object store of the map, with its strings moved into the string pool.
+static status_t collect_objects(map_blob_object_t* blob_object, string_pool_t* pool, core_t* core)
+{
+    object_store_t* store = &core->map->object;
+    Sint32          index;
+
+    for (index = 0; index < store->count; index += 1)
+    {
+        Sint32 name = add_string(pool, store->name[index],      SDL_strlen(store->name[index]));
+        Sint32 type = add_string(pool, store->type_name[index], SDL_strlen(store->type_name[index]));
+
+        if (0 > name || 0 > type)
+        {
+            return CORE_ERROR;
+        }
+
+        blob_object[index].type_hash = store->type_hash[index];
+        blob_object[index].pos_x     = store->pos_x[index];
+        blob_object[index].pos_y     = store->pos_y[index];
+        blob_object[index].width     = store->width[index];
+        blob_object[index].height    = store->height[index];
+        blob_object[index].id        = store->id[index];
+        blob_object[index].gid       = store->gid[index];
+        blob_object[index].name      = (Uint32)name;
+        blob_object[index].type      = (Uint32)type;
+    }
+
+    return CORE_OK;
+}
+
+/* The image source is stored relative to the map file: prepend the
+ * directory of the tileset file, as set_tileset_path does.
+ */
+static Sint32 add_image_source(string_pool_t* pool, tmx_tileset_list* tileset)
+{
+    const char* image_source   = tileset->tileset->image->source;
+    char        path[256]      = { 0 };
+    size_t      ts_path_length = 0;
+
+    if (! tileset->is_embedded && tileset->source)
+    {
+        cwk_path_get_dirname(tileset->source, &ts_path_length);
+    }
+
+    if (ts_path_length + SDL_strlen(image_source) >= sizeof(path))
+    {
+        return -1;
+    }
+
+    SDL_memcpy(path, tileset->source, ts_path_length);
+    SDL_strlcpy(&path[ts_path_length], image_source, sizeof(path) - ts_path_length);
+
+    return add_string(pool, path, SDL_strlen(path));
+}
+
+// Replace the data of every tile layer below node with a single empty cell.
+static void clear_layer_data(xmlNodePtr node)
+{
+    xmlNodePtr child;
+
+    for (child = node->children; child; child = child->next)
+    {
+        if (XML_ELEMENT_NODE != child->type)
+        {
+            continue;
+        }
+
+        if (0 == xmlStrcmp(node->name, (const xmlChar*)"layer") && 0 == xmlStrcmp(child->name, (const xmlChar*)"data"))
+        {
+            xmlNodeSetContent(child, (const xmlChar*)"0");
+            xmlSetProp(child, (const xmlChar*)"encoding", (const xmlChar*)"csv");
+            xmlUnsetProp(child, (const xmlChar*)"compression");
+            continue;
+        }
+
+        clear_layer_data(child);
+    }
+}
+
+/* Write a copy of an infinite map that libtmx can load: finite, one
+ * cell wide and high, with the data of every layer replaced by a
+ * single empty cell.
+ */
+static status_t write_header_map(const char* file_name, const char* header_name)
+{
+    xmlDocPtr  doc;
+    xmlNodePtr root;
+
+    doc = xmlReadFile(file_name, NULL, 0);
+    if (! doc)
+    {
+        dbgprint("%s: could not parse %s.", FUNCTION_NAME, file_name);
+        return CORE_ERROR;
+    }
+
+    root = xmlDocGetRootElement(doc);
+    if (! root || 0 != xmlStrcmp(root->name, (const xmlChar*)"map"))
+    {
+        dbgprint("%s: %s is not a map.", FUNCTION_NAME, file_name);
+        xmlFreeDoc(doc);
+        return CORE_ERROR;
+    }
+
+    xmlSetProp(root, (const xmlChar*)"infinite", (const xmlChar*)"0");
+    xmlSetProp(root, (const xmlChar*)"width",    (const xmlChar*)"1");
+    xmlSetProp(root, (const xmlChar*)"height",   (const xmlChar*)"1");
+    clear_layer_data(root);
+
+    if (0 > xmlSaveFile(header_name, doc))
+    {
+        dbgprint("%s: could not create %s.", FUNCTION_NAME, header_name);
+        xmlFreeDoc(doc);
+        return CORE_ERROR;
+    }
+
+    xmlFreeDoc(doc);
+
+    return CORE_OK;
+}
+
+static Sint32 decode_base64_char(char c)
+{
+    if ('A' <= c && c <= 'Z')
+    {
+        return c - 'A';
+    }
+    if ('a' <= c && c <= 'z')
+    {
+        return c - 'a' + 26;
+    }
+    if ('0' <= c && c <= '9')
+    {
+        return c - '0' + 52;
+    }
+    if ('+' == c)
+    {
+        return 62;
+    }
+    if ('/' == c)
+    {
+        return 63;
+    }
+
+    return -1;
+}
+
+/* Decode base64 text in place, skipping white space.  Returns the
+ * number of bytes.
+ */
+static size_t decode_base64(char* text)
+{
+    Uint8* out   = (Uint8*)text;
+    size_t size  = 0;
+    Uint32 bits  = 0;
+    Sint32 count = 0;
+
+    for (; *text && '=' != *text; text += 1)
+    {
+        Sint32 value = decode_base64_char(*text);
+
+        if (0 > value)
+        {
+            continue;
+        }
+
+        bits   = (bits << 6) | (Uint32)value;
+        count += 6;
+        if (8 <= count)
+        {
+            count      -= 8;
+            out[size]   = (Uint8)(bits >> count);
+            size       += 1;
+        }
+    }
+
+    return size;
+}
+
+/* Decode the gids of a chunk, in any encoding Tiled writes but the
+ * deprecated XML one and zstd compression.  Flip bits are dropped.
+ */
+static status_t decode_chunk(char* text, const char* encoding, const char* compression, Uint16* gid, Sint32 cell_count, Sint32 gid_count)
+{
+    Uint8*  bytes = NULL;
+    Uint32  value;
+    Sint32  index;
+
+    if (0 == SDL_strcmp(encoding, "csv"))
+    {
+        char* cursor = text;
+
+        for (index = 0; index < cell_count; index += 1)
+        {
+            char* end;
+
+            while (',' == *cursor || SDL_isspace(*cursor))
+            {
+                cursor += 1;
+            }
+
+            value = (Uint32)SDL_strtoul(cursor, &end, 10);
+            if (end == cursor)
+            {
+                return CORE_ERROR;
+            }
+            cursor = end;
+
+            value      = (Uint32)remove_gid_flip_bits((Sint32)value);
+            gid[index] = (Uint16)(value < (Uint32)gid_count ? value : 0);
+        }
+
+        return CORE_OK;
+    }
+
+    if (0 != SDL_strcmp(encoding, "base64"))
+    {
+        return CORE_ERROR;
+    }
+
+    if ('\0' == compression[0])
+    {
+        if ((size_t)cell_count * 4 != decode_base64(text))
+        {
+            return CORE_ERROR;
+        }
+        bytes = (Uint8*)text;
+    }
+    else if (0 == SDL_strcmp(compression, "zlib") || 0 == SDL_strcmp(compression, "gzip"))
+    {
+        z_stream stream;
+        int      status;
+
+        SDL_zero(stream);
+        bytes = (Uint8*)malloc((size_t)cell_count * 4);
+        if (! bytes || Z_OK != inflateInit2(&stream, 15 + 32))
+        {
+            free(bytes);
+            return CORE_ERROR;
+        }
+
+        stream.next_in   = (Bytef*)text;
+        stream.avail_in  = (uInt)decode_base64(text);
+        stream.next_out  = bytes;
+        stream.avail_out = (uInt)cell_count * 4;
+
+        status = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+
+        if (Z_STREAM_END != status || 0 != stream.avail_out)
+        {
+            free(bytes);
+            return CORE_ERROR;
+        }
+    }
+    else
+    {
+        return CORE_ERROR;
+    }
+
+    for (index = 0; index < cell_count; index += 1)
+    {
+        const Uint8* byte = &bytes[index * 4];
+
+        value      = (Uint32)byte[0] | ((Uint32)byte[1] << 8) | ((Uint32)byte[2] << 16) | ((Uint32)byte[3] << 24);
+        value      = (Uint32)remove_gid_flip_bits((Sint32)value);
+        gid[index] = (Uint16)(value < (Uint32)gid_count ? value : 0);
+    }
+
+    if (bytes != (Uint8*)text)
+    {
+        free(bytes);
+    }
+
+    return CORE_OK;
+}
+
+// Read one chunk element of a layer and keep it, unless it is empty.
+static status_t read_chunk(xmlTextReaderPtr reader, Sint32 layer_index, const char* encoding, const char* compression, infinite_map_t* infinite)
+{
+    xmlChar*       attribute[4];
+    const char*    name[4] = { "x", "y", "width", "height" };
+    Sint32         value[4];
+    xmlChar*       text;
+    layer_chunk_t* chunk;
+    Sint32         size;
+    Sint32         index;
+    SDL_bool       is_empty = SDL_TRUE;
+    status_t       status;
+
+    for (index = 0; index < 4; index += 1)
+    {
+        attribute[index] = xmlTextReaderGetAttribute(reader, (const xmlChar*)name[index]);
+        value[index]     = attribute[index] ? SDL_atoi((const char*)attribute[index]) : 0;
+        xmlFree(attribute[index]);
+    }
+
+    // [1] Every chunk has the size of the first one.
+    size = value[2];
+    if (0 == infinite->chunk_size)
+    {
+        infinite->chunk_size = size;
+    }
+
+    if (size != infinite->chunk_size || size != value[3] || 0 >= size || 0 != size % CHUNK_SIZE || 256 < size ||
+        0 != value[0] % size || 0 != value[1] % size)
+    {
+        dbgprint("%s: unsupported chunk %dx%d at %d, %d.", FUNCTION_NAME, value[2], value[3], value[0], value[1]);
+        return CORE_ERROR;
+    }
+
+    if (infinite->layer_chunk_count == infinite->layer_chunk_capacity)
+    {
+        Sint32         capacity = infinite->layer_chunk_capacity ? infinite->layer_chunk_capacity * 2 : 64;
+        layer_chunk_t* list     = (layer_chunk_t*)realloc(infinite->layer_chunk, (size_t)capacity * sizeof(struct layer_chunk));
+
+        if (! list)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            return CORE_ERROR;
+        }
+        infinite->layer_chunk          = list;
+        infinite->layer_chunk_capacity = capacity;
+    }
+
+    // [2] Gids.
+    chunk              = &infinite->layer_chunk[infinite->layer_chunk_count];
+    chunk->index_x     = value[0] / size;
+    chunk->index_y     = value[1] / size;
+    chunk->layer_index = layer_index;
+    chunk->gid         = (Uint16*)calloc((size_t)(size * size), sizeof(Uint16));
+    text               = xmlTextReaderReadString(reader);
+
+    if (! chunk->gid || ! text)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        free(chunk->gid);
+        xmlFree(text);
+        return CORE_ERROR;
+    }
+
+    status = decode_chunk((char*)text, encoding, compression, chunk->gid, size * size, infinite->gid_count);
+    xmlFree(text);
+
+    if (CORE_OK != status)
+    {
+        dbgprint("%s: could not decode chunk at %d, %d.", FUNCTION_NAME, value[0], value[1]);
+        free(chunk->gid);
+        return CORE_ERROR;
+    }
+
+    for (index = 0; index < size * size && is_empty; index += 1)
+    {
+        is_empty = chunk->gid[index] ? SDL_FALSE : SDL_TRUE;
+    }
+
+    if (is_empty)
+    {
+        free(chunk->gid);
+        return CORE_OK;
+    }
+
+    infinite->layer_chunk_count += 1;
+
+    return CORE_OK;
+}
+
+static int compare_layer_chunks(const void* a, const void* b)
+{
+    const layer_chunk_t* chunk_a = (const layer_chunk_t*)a;
+    const layer_chunk_t* chunk_b = (const layer_chunk_t*)b;
+
+    if (chunk_a->index_y != chunk_b->index_y)
+    {
+        return chunk_a->index_y < chunk_b->index_y ? -1 : 1;
+    }
+    if (chunk_a->index_x != chunk_b->index_x)
+    {
+        return chunk_a->index_x < chunk_b->index_x ? -1 : 1;
+    }
+    if (chunk_a->layer_index != chunk_b->layer_index)
+    {
+        return chunk_a->layer_index < chunk_b->layer_index ? -1 : 1;
+    }
+
+    return 0;
+}
+
+/* Read the chunks of every visible top-level tile layer, the same
+ * layers as load_render_list, and move them so that the top-left
+ * chunk is at 0, 0.  origin is set to the cell of Tiled's coordinates
+ * that ends up at 0, 0.
+ */
+static status_t read_infinite_map(const char* file_name, infinite_map_t* infinite, SDL_Point* origin)
+{
+    xmlTextReaderPtr reader;
+    char             encoding[16]    = { 0 };
+    char             compression[16] = { 0 };
+    Sint32           layer_index     = -1;
+    Sint32           layer_count     = 0;
+    Sint32           min_x           = SDL_MAX_SINT32;
+    Sint32           min_y           = SDL_MAX_SINT32;
+    Sint32           max_x           = SDL_MIN_SINT32;
+    Sint32           max_y           = SDL_MIN_SINT32;
+    Sint32           index;
+    int              status;
+
+    reader = xmlReaderForFile(file_name, NULL, 0);
+    if (! reader)
+    {
+        dbgprint("%s: could not open %s.", FUNCTION_NAME, file_name);
+        return CORE_ERROR;
+    }
+
+    // [1] Chunks, layer by layer.
+    while (1 == (status = xmlTextReaderRead(reader)))
+    {
+        const char* name  = (const char*)xmlTextReaderConstName(reader);
+        int         depth = xmlTextReaderDepth(reader);
+
+        if (XML_READER_TYPE_ELEMENT != xmlTextReaderNodeType(reader))
+        {
+            continue;
+        }
+
+        if (1 == depth)
+        {
+            layer_index = -1;
+
+            if (0 == SDL_strcmp(name, "layer"))
+            {
+                xmlChar* visible = xmlTextReaderGetAttribute(reader, (const xmlChar*)"visible");
+
+                if (! visible || 0 != SDL_atoi((const char*)visible))
+                {
+                    layer_index  = layer_count;
+                    layer_count += 1;
+                }
+                xmlFree(visible);
+            }
+        }
+        else if (2 == depth && 0 <= layer_index && 0 == SDL_strcmp(name, "data"))
+        {
+            xmlChar* value = xmlTextReaderGetAttribute(reader, (const xmlChar*)"encoding");
+
+            SDL_strlcpy(encoding, value ? (const char*)value : "", sizeof(encoding));
+            xmlFree(value);
+
+            value = xmlTextReaderGetAttribute(reader, (const xmlChar*)"compression");
+            SDL_strlcpy(compression, value ? (const char*)value : "", sizeof(compression));
+            xmlFree(value);
+        }
+        else if (3 == depth && 0 <= layer_index && 0 == SDL_strcmp(name, "chunk"))
+        {
+            if (CORE_OK != read_chunk(reader, layer_index, encoding, compression, infinite))
+            {
+                xmlFreeTextReader(reader);
+                return CORE_ERROR;
+            }
+        }
+    }
+
+    xmlFreeTextReader(reader);
+
+    if (0 != status)
+    {
+        dbgprint("%s: could not parse %s.", FUNCTION_NAME, file_name);
+        return CORE_ERROR;
+    }
+
+    if (layer_count != infinite->layer_count || 0 == infinite->layer_chunk_count)
+    {
+        dbgprint("%s: no tiles in %s.", FUNCTION_NAME, file_name);
+        return CORE_ERROR;
+    }
+
+    // [2] Bounding box and chunk order.
+    for (index = 0; index < infinite->layer_chunk_count; index += 1)
+    {
+        layer_chunk_t* chunk = &infinite->layer_chunk[index];
+
+        min_x = SDL_min(min_x, chunk->index_x);
+        min_y = SDL_min(min_y, chunk->index_y);
+        max_x = SDL_max(max_x, chunk->index_x);
+        max_y = SDL_max(max_y, chunk->index_y);
+    }
+
+    for (index = 0; index < infinite->layer_chunk_count; index += 1)
+    {
+        infinite->layer_chunk[index].index_x -= min_x;
+        infinite->layer_chunk[index].index_y -= min_y;
+    }
+
+    qsort(infinite->layer_chunk, (size_t)infinite->layer_chunk_count, sizeof(struct layer_chunk), compare_layer_chunks);
+
+    infinite->chunk_count_x = max_x - min_x + 1;
+    infinite->chunk_count_y = max_y - min_y + 1;
+    infinite->chunk_count   = 0;
+
+    for (index = 0; index < infinite->layer_chunk_count; index += 1)
+    {
+        if (0 == index ||
+            infinite->layer_chunk[index].index_x != infinite->layer_chunk[index - 1].index_x ||
+            infinite->layer_chunk[index].index_y != infinite->layer_chunk[index - 1].index_y)
+        {
+            infinite->chunk_count += 1;
+        }
+    }
+
+    origin->x = min_x * infinite->chunk_size;
+    origin->y = min_y * infinite->chunk_size;
+
+    return CORE_OK;
+}
+
+static void free_infinite_map(infinite_map_t* infinite)
+{
+    Sint32 index;
+
+    for (index = 0; index < infinite->layer_chunk_count; index += 1)
+    {
+        free(infinite->layer_chunk[index].gid);
+    }
+    free(infinite->layer_chunk);
+    SDL_zerop(infinite);
+}
+
+/* The chunk index and chunk data of a streamed map, at the offsets of
+ * the header.
+ */
+static void write_stream_sections(Uint8* data, const map_blob_header_t* header, const infinite_map_t* infinite)
+{
+    map_blob_chunk_t* chunk      = (map_blob_chunk_t*)&data[header->chunk_offset];
+    Uint32            layer_size = header->stream_chunk_size * header->stream_chunk_size;
+    Uint32            data_size  = header->layer_count * layer_size * (Uint32)sizeof(Uint16);
+    Sint32            count      = -1;
+    Sint32            index;
+
+    for (index = 0; index < infinite->layer_chunk_count; index += 1)
+    {
+        const layer_chunk_t* layer_chunk = &infinite->layer_chunk[index];
+
+        if (0 > count || (Uint32)layer_chunk->index_x != chunk[count].index_x || (Uint32)layer_chunk->index_y != chunk[count].index_y)
+        {
+            count                    += 1;
+            chunk[count].index_x      = (Uint32)layer_chunk->index_x;
+            chunk[count].index_y      = (Uint32)layer_chunk->index_y;
+            chunk[count].data_offset  = header->stream_data_offset + ((Uint32)count * data_size);
+        }
+
+        SDL_memcpy(&data[chunk[count].data_offset + ((Uint32)layer_chunk->layer_index * layer_size * sizeof(Uint16))], layer_chunk->gid, layer_size * sizeof(Uint16));
+    }
+}
+
+static status_t write_map_blob(const char* file_name, const infinite_map_t* infinite, core_t* core)
+{
+    map_t*               map            = core->map;
+    render_list_t*       list           = &map->render_list;
+    string_pool_t        pool;
+    map_blob_property_t* property       = NULL;
+    map_blob_tileset_t*  tileset        = NULL;
+    map_blob_object_t*   object         = NULL;
+    Uint32               property_count = map->property.count;
+    Uint32               object_count   = (Uint32)map->object.count;
+    map_blob_header_t    header;
+    map_blob_animation_t animation;
+    Uint32               chunk_count    = (Uint32)(list->chunk_count_x * list->chunk_count_y);
+    Uint32               tile_count;
+    Uint32               frame_count    = 0;
+    Uint8*               data           = NULL;
+    FILE*                fp;
+    Sint32               offset;
+    Sint32               index;
+    status_t             status         = CORE_ERROR;
+
+    SDL_zero(pool);
+    SDL_zero(header);
+
+    // [1] String pool: image sources, string property values, then object names and types.
+    tileset = (map_blob_tileset_t*)calloc((size_t)map->tileset_count, sizeof(struct map_blob_tileset));
+    if (! tileset)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        goto quit;
+    }
+
+    for (index = 0; index < map->tileset_count; index += 1)
+    {
+        offset = add_image_source(&pool, get_tileset_list_entry(index, map->handle));
+        if (0 > offset)
+        {
+            dbgprint("%s: invalid tileset image source.", FUNCTION_NAME);
+            goto quit;
+        }
+
+        tileset[index].first_gid    = (Uint32)map->tileset[index].first_gid;
+        tileset[index].tile_count   = (Uint32)map->tileset[index].tile_count;
+        tileset[index].image_source = (Uint32)offset;
+    }
+
+    if (0 < property_count)
+    {
+        property = (map_blob_property_t*)calloc((size_t)property_count, sizeof(struct map_blob_property));
+        if (! property)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            goto quit;
+        }
+    }
+
+    if (CORE_OK != collect_properties(property, &pool, core))
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        goto quit;
+    }
+
+    if (0 < object_count)
+    {
+        object = (map_blob_object_t*)calloc((size_t)object_count, sizeof(struct map_blob_object));
+        if (! object)
+        {
+            dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+            goto quit;
+        }
+    }
+
+    if (CORE_OK != collect_objects(object, &pool, core))
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        goto quit;
+    }
+
+    for (index = 0; index < map->animation_count; index += 1)
+    {
+        frame_count += (Uint32)map->animation[index].animation_length;
+    }
+
+    if (MAP_BLOB_LAYER_MAX < list->layer_count)
+    {
+        dbgprint("%s: more than %d tile layers.", FUNCTION_NAME, MAP_BLOB_LAYER_MAX);
+        goto quit;
+    }
+
+    // [2] Header and section layout.
+    header.magic           = MAP_BLOB_MAGIC;
+    header.version         = MAP_BLOB_VERSION;
+    header.chunk_size      = CHUNK_SIZE;
+    header.width           = (Uint32)list->width;
+    header.height          = (Uint32)list->height;
+    header.layer_count     = (Uint32)list->layer_count;
+    header.cell_count      = list->cell_offset ? list->cell_offset[chunk_count] : 0;
+
+    // Streamed maps have no layer grid and cell list, only chunks.
+    if (infinite)
+    {
+        chunk_count                = 0;
+        header.width               = (Uint32)(infinite->chunk_count_x * infinite->chunk_size);
+        header.height              = (Uint32)(infinite->chunk_count_y * infinite->chunk_size);
+        header.cell_count          = 0;
+        header.stream_chunk_size   = (Uint32)infinite->chunk_size;
+        header.stream_chunk_count  = (Uint32)infinite->chunk_count;
+    }
+    tile_count = chunk_count ? header.layer_count * header.width * header.height : 0;
+
+    header.tile_width      = (Uint32)list->tile_width;
+    header.tile_height     = (Uint32)list->tile_height;
+    header.gid_count       = (Uint32)list->gid_count;
+    header.tileset_count   = (Uint32)map->tileset_count;
+    header.animation_count = (Uint32)map->animation_count;
+    header.frame_count     = frame_count;
+    header.property_count  = property_count;
+    header.object_count    = object_count;
+
+    header.layer_tile_offset  = align_offset(sizeof(map_blob_header_t));
+    header.cell_offset_offset = align_offset(header.layer_tile_offset  + tile_count * sizeof(Uint16));
+    header.cell_list_offset   = align_offset(header.cell_offset_offset + (chunk_count + 1) * sizeof(Uint32));
+    header.position_offset    = align_offset(header.cell_list_offset   + header.cell_count * sizeof(render_cell_t));
+    header.gid_tileset_offset = align_offset(header.position_offset    + header.gid_count * sizeof(SDL_Point));
+    header.tile_flag_offset   = align_offset(header.gid_tileset_offset + header.gid_count * sizeof(Uint8));
+    header.tileset_offset     = align_offset(header.tile_flag_offset   + header.gid_count * sizeof(Uint32));
+    header.animation_offset   = align_offset(header.tileset_offset     + header.tileset_count * sizeof(map_blob_tileset_t));
+    header.frame_offset       = align_offset(header.animation_offset   + header.animation_count * sizeof(map_blob_animation_t));
+    header.property_offset    = align_offset(header.frame_offset       + header.frame_count * sizeof(animation_frame_t));
+    header.object_offset      = align_offset(header.property_offset    + header.property_count * sizeof(map_blob_property_t));
+    header.chunk_offset       = align_offset(header.object_offset      + header.object_count * sizeof(map_blob_object_t));
+    header.string_offset      = align_offset(header.chunk_offset       + header.stream_chunk_count * sizeof(map_blob_chunk_t));
+    header.size               = header.string_offset + pool.size;
+
+    if (infinite)
+    {
+        header.stream_data_offset = align_offset(header.size);
+        header.size               = header.stream_data_offset + (header.stream_chunk_count * header.layer_count * header.stream_chunk_size * header.stream_chunk_size * sizeof(Uint16));
+    }
+
+    data = (Uint8*)calloc(1, header.size);
+    if (! data)
+    {
+        dbgprint("%s: error allocating memory.", FUNCTION_NAME);
+        goto quit;
+    }
+
+    // [3] Sections.
+    SDL_memcpy(data, &header, sizeof(map_blob_header_t));
+
+    if (list->layer_tile && 0 < tile_count)
+    {
+        SDL_memcpy(&data[header.layer_tile_offset], list->layer_tile, tile_count * sizeof(Uint16));
+    }
+    if (list->cell_offset && ! infinite)
+    {
+        SDL_memcpy(&data[header.cell_offset_offset], list->cell_offset, (chunk_count + 1) * sizeof(Uint32));
+    }
+    if (list->cell && 0 < header.cell_count)
+    {
+        SDL_memcpy(&data[header.cell_list_offset], list->cell, header.cell_count * sizeof(render_cell_t));
+    }
+    SDL_memcpy(&data[header.position_offset], list->position, header.gid_count * sizeof(SDL_Point));
+    SDL_memcpy(&data[header.gid_tileset_offset], list->gid_tileset, header.gid_count * sizeof(Uint8));
+    SDL_memcpy(&data[header.tile_flag_offset], map->tile_properties, header.gid_count * sizeof(Uint32));
+    SDL_memcpy(&data[header.tileset_offset], tileset, header.tileset_count * sizeof(map_blob_tileset_t));
+
+    for (index = 0; index < map->animation_count; index += 1)
+    {
+        SDL_zero(animation);
+        animation.gid         = (Uint32)map->animation[index].gid;
+        animation.first_frame = (Uint32)(map->animation[index].frame - map->animation_frame);
+        animation.frame_count = (Uint32)map->animation[index].animation_length;
+
+        SDL_memcpy(&data[header.animation_offset + (Uint32)index * sizeof(map_blob_animation_t)], &animation, sizeof(map_blob_animation_t));
+    }
+    if (0 < frame_count)
+    {
+        SDL_memcpy(&data[header.frame_offset], map->animation_frame, frame_count * sizeof(animation_frame_t));
+    }
+    if (0 < property_count)
+    {
+        SDL_memcpy(&data[header.property_offset], property, property_count * sizeof(map_blob_property_t));
+    }
+    if (0 < object_count)
+    {
+        SDL_memcpy(&data[header.object_offset], object, object_count * sizeof(map_blob_object_t));
+    }
+    SDL_memcpy(&data[header.string_offset], pool.data, pool.size);
+
+    if (infinite)
+    {
+        write_stream_sections(data, &header, infinite);
+    }
+
+    // [4] Output.
+    fp = fopen(file_name, "wb");
+    if (! fp)
+    {
+        dbgprint("%s: could not create %s.", FUNCTION_NAME, file_name);
+        goto quit;
+    }
+
+    if (1 != fwrite(data, header.size, 1, fp))
+    {
+        dbgprint("%s: could not write %s.", FUNCTION_NAME, file_name);
+        fclose(fp);
+        goto quit;
+    }
+    fclose(fp);
+
+    dbgprint("Wrote %s: %u bytes, %u cell(s), %u animation(s), %u propert(y/ies), %u object(s).",
+             file_name, header.size, header.cell_count, header.animation_count, header.property_count, header.object_count);
+
+    if (infinite)
+    {
+        dbgprint("Streamed %u chunk(s) of %ux%u cells, in a %ux%u map.",
+                 header.stream_chunk_count, header.stream_chunk_size, header.stream_chunk_size, header.width, header.height);
+    }
+
+    status = CORE_OK;
+
+quit:
+    free(data);
+    free(pool.data);
+    free(object);
+    free(property);
+    free(tileset);
+
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    char           output_name[256];
+    char           header_name[256];
+    core_t         core;
+    map_t          map;
+    infinite_map_t infinite;
+    SDL_Point      origin      = { 0, 0 };
+    SDL_bool       is_infinite;
+    status_t       load_status;
+    Sint32         index;
+    int            status      = EXIT_FAILURE;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <map.tmx> [map.cmap]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    is_infinite = is_infinite_map(argv[1]);
+
+    if (argc > 2)
+    {
+        SDL_strlcpy(output_name, argv[2], sizeof(output_name));
+    }
+    else if (sizeof(output_name) <= cwk_path_change_extension(argv[1], MAP_BLOB_EXTENSION, output_name, sizeof(output_name)))
+    {
+        fprintf(stderr, "Output file name too long.\n");
+        return EXIT_FAILURE;
+    }
+
+    SDL_zero(core);
+    SDL_zero(map);
+    SDL_zero(infinite);
+    core.map  = &map;
+    map.arena = create_arena();
+    if (! map.arena)
+    {
+        return EXIT_FAILURE;
+    }
+
+    // Infinite maps are loaded from a copy without tiles, next to the map for relative tileset paths.
+    if (is_infinite)
+    {
+        if (sizeof(header_name) <= cwk_path_change_extension(argv[1], ".header.tmx", header_name, sizeof(header_name)) ||
+            CORE_OK != write_header_map(argv[1], header_name))
+        {
+            free_arena(map.arena);
+            return EXIT_FAILURE;
+        }
+
+        load_status = load_tiled_map(header_name, &core);
+        remove(header_name);
+    }
+    else
+    {
+        load_status = load_tiled_map(argv[1], &core);
+    }
+
+    if (CORE_OK != load_status)
+    {
+        free_arena(map.arena);
+        return EXIT_FAILURE;
+    }
+
+    if (CORE_OK != load_map_path(argv[1], &core)   ||
+        CORE_OK != load_property_table(&core)      ||
+        CORE_OK != load_tileset_table(&core)       ||
+        CORE_OK != load_render_list(&core)         ||
+        CORE_OK != load_animated_tiles(&core)      ||
+        CORE_OK != load_tile_flags(argv[1], &core) ||
+        CORE_OK != load_objects(&core))
+    {
+        goto quit;
+    }
+
+    // Objects move along with the tiles, so that the top-left chunk is at 0, 0.
+    if (is_infinite)
+    {
+        infinite.layer_count = map.render_list.layer_count;
+        infinite.gid_count   = map.render_list.gid_count;
+
+        if (CORE_OK != read_infinite_map(argv[1], &infinite, &origin))
+        {
+            goto quit;
+        }
+
+        for (index = 0; index < map.object.count; index += 1)
+        {
+            map.object.pos_x[index] -= origin.x * map.render_list.tile_width;
+            map.object.pos_y[index] -= origin.y * map.render_list.tile_height;
+        }
+    }
+
+    if (CORE_OK == write_map_blob(output_name, is_infinite ? &infinite : NULL, &core))
+    {
+        status = EXIT_SUCCESS;
+    }
+
+quit:
+    free_infinite_map(&infinite);
+    free_tilesets(&core);
+    unload_tiled_map(&core);
+    free_arena(map.arena);
+
+    return status;
+}
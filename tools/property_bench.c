@@ -0,0 +1,233 @@
+// SPDX-License-Identifier: MIT
+
+/* Property lookup micro-benchmark.
+ *
+ * Compares looking up every map property through the property table
+ * with the former lookup path, which walked all properties with
+ * tmx_property_foreach and hashed each name on every query.
+ *
+ * Usage: demo_property_bench [-p <count> | map file] [iterations]
+ *
+ * With -p, a small map carrying the given number of integer map
+ * properties is generated next to the default map and used instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include <tmx.h>
+#include "arena.h"
+#include "core.h"
+#include "property.h"
+#include "tiled.h"
+
+#define PROPERTY_BENCH_DEFAULT_MAP        "res/demo.tmx"
+#define PROPERTY_BENCH_DEFAULT_ITERATIONS 100000
+#define PROPERTY_BENCH_NAME_MAX           4096
+
+typedef struct scan_query
+{
+    Uint64        hash;
+    tmx_property* result;
+
+} scan_query_t;
+
+typedef struct name_list
+{
+    Uint64 hash[PROPERTY_BENCH_NAME_MAX];
+    Sint32 count;
+
+} name_list_t;
+
+static void scan_property(tmx_property* property, void* query)
+{
+    scan_query_t* query_ptr = query;
+
+    if (query_ptr->hash == generate_hash((const unsigned char*)property->name))
+    {
+        query_ptr->result = property;
+    }
+}
+
+static void collect_name(tmx_property* property, void* list)
+{
+    name_list_t* list_ptr = list;
+
+    if (PROPERTY_BENCH_NAME_MAX > list_ptr->count)
+    {
+        list_ptr->hash[list_ptr->count] = generate_hash((const unsigned char*)property->name);
+        list_ptr->count += 1;
+    }
+}
+
+static status_t generate_map(const char* file_name, Sint32 property_count)
+{
+    FILE*  fp;
+    Sint32 index;
+
+    fp = fopen(file_name, "w");
+    if (! fp)
+    {
+        fprintf(stderr, "Could not create %s.\n", file_name);
+        return CORE_ERROR;
+    }
+
+    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(fp, "<map version=\"1.8\" orientation=\"orthogonal\" renderorder=\"right-down\" "
+                "width=\"1\" height=\"1\" tilewidth=\"16\" tileheight=\"16\" infinite=\"0\">\n");
+    fprintf(fp, " <properties>\n");
+    for (index = 0; index < property_count; index += 1)
+    {
+        fprintf(fp, "  <property name=\"property_%d\" type=\"int\" value=\"%d\"/>\n", index, index);
+    }
+    fprintf(fp, " </properties>\n");
+    fprintf(fp, " <tileset firstgid=\"1\" source=\"grass_biome.tsx\"/>\n");
+    fprintf(fp, " <layer id=\"1\" name=\"Layer 1\" width=\"1\" height=\"1\">\n");
+    fprintf(fp, "  <data encoding=\"csv\">\n1\n</data>\n </layer>\n");
+    fprintf(fp, "</map>\n");
+    fclose(fp);
+
+    return CORE_OK;
+}
+
+int main(int argc, char *argv[])
+{
+    const char*  map_file_name = PROPERTY_BENCH_DEFAULT_MAP;
+    char         generated_map[64];
+    name_list_t* name_list;
+    core_t       core;
+    map_t        map;
+    Sint32       iteration_count = PROPERTY_BENCH_DEFAULT_ITERATIONS;
+    Sint32       iteration;
+    Sint32       index;
+    Sint32       found_count     = 0;
+    Uint64       start;
+    double       ticks_per_ns    = (double)SDL_GetPerformanceFrequency() / 1000000000.0;
+    double       scan_time;
+    double       table_time;
+    int          status          = EXIT_FAILURE;
+
+    if (argc > 2 && 0 == SDL_strcmp(argv[1], "-p"))
+    {
+        Sint32 property_count = SDL_atoi(argv[2]);
+
+        if (0 >= property_count)
+        {
+            fprintf(stderr, "Invalid property count.\n");
+            return EXIT_FAILURE;
+        }
+
+        SDL_snprintf(generated_map, sizeof(generated_map), "res/bench_props_%d.tmx", property_count);
+        if (CORE_OK != generate_map(generated_map, property_count))
+        {
+            return EXIT_FAILURE;
+        }
+
+        map_file_name = generated_map;
+        argc -= 1;
+        argv += 1;
+    }
+    else if (argc > 1)
+    {
+        map_file_name = argv[1];
+    }
+    if (argc > 2)
+    {
+        iteration_count = SDL_atoi(argv[2]);
+    }
+    if (0 >= iteration_count)
+    {
+        fprintf(stderr, "Invalid iteration count.\n");
+        return EXIT_FAILURE;
+    }
+
+    name_list = (name_list_t*)calloc(1, sizeof(struct name_list));
+    if (! name_list)
+    {
+        fprintf(stderr, "Error allocating memory.\n");
+        return EXIT_FAILURE;
+    }
+
+    SDL_zero(core);
+    SDL_zero(map);
+    core.map           = &map;
+    core.is_map_loaded = SDL_TRUE;
+    map.arena          = create_arena();
+
+    if (! map.arena || CORE_OK != load_tiled_map(map_file_name, &core))
+    {
+        free_arena(map.arena);
+        free(name_list);
+        return EXIT_FAILURE;
+    }
+
+    if (CORE_OK != load_property_table(&core))
+    {
+        goto quit;
+    }
+
+    if (map.handle->properties)
+    {
+        tmx_property_foreach(map.handle->properties, collect_name, name_list);
+    }
+    if (0 == name_list->count)
+    {
+        fprintf(stderr, "%s has no map properties.\n", map_file_name);
+        goto quit;
+    }
+
+    // [1] Former path: walk and hash every property on each query.
+    start = SDL_GetPerformanceCounter();
+    for (iteration = 0; iteration < iteration_count; iteration += 1)
+    {
+        for (index = 0; index < name_list->count; index += 1)
+        {
+            scan_query_t query;
+
+            query.hash   = name_list->hash[index];
+            query.result = NULL;
+            tmx_property_foreach(map.handle->properties, scan_property, &query);
+
+            if (query.result)
+            {
+                found_count += 1;
+            }
+        }
+    }
+    scan_time = (double)(SDL_GetPerformanceCounter() - start) / ticks_per_ns;
+
+    // [2] Property table.
+    start = SDL_GetPerformanceCounter();
+    for (iteration = 0; iteration < iteration_count; iteration += 1)
+    {
+        for (index = 0; index < name_list->count; index += 1)
+        {
+            if (find_property(&map.property, PROPERTY_OWNER_MAP, name_list->hash[index]))
+            {
+                found_count -= 1;
+            }
+        }
+    }
+    table_time = (double)(SDL_GetPerformanceCounter() - start) / ticks_per_ns;
+
+    if (0 != found_count)
+    {
+        fprintf(stderr, "Lookup results differ.\n");
+        goto quit;
+    }
+
+    printf("map: %s, properties: %d (%u indexed in %u slots), iterations: %d\n",
+           map_file_name, name_list->count, map.property.count, map.property.capacity, iteration_count);
+    printf("%-10s %12s\n", "path", "ns/lookup");
+    printf("%-10s %12.1f\n", "foreach", scan_time  / ((double)iteration_count * name_list->count));
+    printf("%-10s %12.1f\n", "table",   table_time / ((double)iteration_count * name_list->count));
+
+    status = EXIT_SUCCESS;
+
+quit:
+    unload_tiled_map(&core);
+    free_arena(map.arena);
+    free(name_list);
+
+    return status;
+}
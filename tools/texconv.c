@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: MIT
+
+/* Offline texture compiler and load/blit benchmark.
+ *
+ * Converts a color-keyed BMP tileset image into a compiled texture
+ * (see src/texture_blob.h) and compares both forms: the time it takes
+ * to load each as the tileset loader does, including the source
+ * pixels of the tile blitter, and the time SDL takes to blit each onto
+ * an RGB444 surface like the chunk textures.
+ *
+ * Usage: demo_texconv <image.bmp> [image.ctex] [iterations]
+ *
+ * Without an output file name, the compiled texture is written next to
+ * the input with its extension replaced by .ctex, which is where the
+ * tileset loader looks for it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "blit.h"
+#include "core.h"
+#include "texture_blob.h"
+#include "tiled.h"
+
+#define TEXCONV_DEFAULT_ITERATIONS 100
+
+static status_t write_texture_blob(const char* file_name, SDL_Surface* image)
+{
+    texture_blob_header_t header;
+    Uint16*               pixels = NULL;
+    FILE*                 fp;
+    Sint32                index;
+
+    if (CORE_OK != load_blit_source(image, &pixels))
+    {
+        return CORE_ERROR;
+    }
+    if (! pixels)
+    {
+        dbgprint("%s: semi-transparent images are not supported.", FUNCTION_NAME);
+        return CORE_ERROR;
+    }
+
+    SDL_zero(header);
+    header.magic   = TEXTURE_BLOB_MAGIC;
+    header.version = TEXTURE_BLOB_VERSION;
+    header.format  = SDL_PIXELFORMAT_ARGB4444;
+    header.width   = (Uint32)image->w;
+    header.height  = (Uint32)image->h;
+    header.flags   = TEXTURE_BLOB_OPAQUE;
+
+    for (index = 0; index < image->w * image->h; index += 1)
+    {
+        if (! (pixels[index] & BLIT_ALPHA))
+        {
+            header.flags &= ~(Uint32)TEXTURE_BLOB_OPAQUE;
+            break;
+        }
+    }
+
+    fp = fopen(file_name, "wb");
+    if (! fp)
+    {
+        dbgprint("%s: could not create %s.", FUNCTION_NAME, file_name);
+        free(pixels);
+        return CORE_ERROR;
+    }
+
+    if (1 != fwrite(&header, sizeof(header), 1, fp) ||
+        1 != fwrite(pixels, (size_t)(image->w * image->h) * sizeof(Uint16), 1, fp))
+    {
+        dbgprint("%s: could not write %s.", FUNCTION_NAME, file_name);
+        fclose(fp);
+        free(pixels);
+        return CORE_ERROR;
+    }
+    fclose(fp);
+    free(pixels);
+
+    dbgprint("Wrote %s: %ux%u, %s.", file_name, header.width, header.height,
+             (header.flags & TEXTURE_BLOB_OPAQUE) ? "opaque" : "color keyed");
+
+    return CORE_OK;
+}
+
+// Average time of one load, as the tileset loader does it, in microseconds.
+static double time_load(const char* file_name, SDL_bool is_compiled, Sint32 iterations)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    Sint32 index;
+
+    for (index = 0; index < iterations; index += 1)
+    {
+        SDL_Surface* surface   = NULL;
+        Uint16*      pixels    = NULL;
+        SDL_bool     is_loaded;
+
+        if (is_compiled)
+        {
+            is_loaded = CORE_OK == load_texture_blob(file_name, &surface) && CORE_OK == copy_blit_source(surface, &pixels);
+        }
+        else
+        {
+            is_loaded = CORE_OK == load_surface_from_file(file_name, &surface) && CORE_OK == load_blit_source(surface, &pixels);
+        }
+
+        free(pixels);
+        SDL_FreeSurface(surface);
+
+        if (! is_loaded)
+        {
+            return -1.0;
+        }
+    }
+
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / (double)SDL_GetPerformanceFrequency() / iterations;
+}
+
+// Average time of one blit of the whole image onto target, in microseconds.
+static double time_blit(SDL_Surface* image, SDL_Surface* target, Sint32 iterations)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    Sint32 index;
+
+    for (index = 0; index < iterations; index += 1)
+    {
+        if (0 > SDL_BlitSurface(image, NULL, target, NULL))
+        {
+            dbgprint("%s: %s.", FUNCTION_NAME, SDL_GetError());
+            return -1.0;
+        }
+    }
+
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / (double)SDL_GetPerformanceFrequency() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    const char*  output_name;
+    char*        blob_name   = NULL;
+    SDL_Surface* image       = NULL;
+    SDL_Surface* compiled    = NULL;
+    SDL_Surface* target      = NULL;
+    Sint32       iterations  = TEXCONV_DEFAULT_ITERATIONS;
+    int          status      = EXIT_FAILURE;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <image.bmp> [image.ctex] [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    blob_name   = get_texture_blob_name(argv[1]);
+    output_name = (argc > 2) ? argv[2] : blob_name;
+    if (argc > 3)
+    {
+        iterations = SDL_atoi(argv[3]);
+    }
+    if (! output_name || 0 >= iterations)
+    {
+        fprintf(stderr, "Invalid arguments.\n");
+        goto quit;
+    }
+
+    if (CORE_OK != load_surface_from_file(argv[1], &image))
+    {
+        goto quit;
+    }
+    if (CORE_OK != write_texture_blob(output_name, image))
+    {
+        goto quit;
+    }
+
+    // Only compare if the loader finds the compiled texture next to the image.
+    if (! blob_name || 0 != SDL_strcmp(output_name, blob_name))
+    {
+        status = EXIT_SUCCESS;
+        goto quit;
+    }
+
+    if (CORE_OK != load_texture_blob(argv[1], &compiled))
+    {
+        goto quit;
+    }
+    target = SDL_CreateRGBSurfaceWithFormat(0, image->w, image->h, 16, SDL_PIXELFORMAT_RGB444);
+    if (! target)
+    {
+        fprintf(stderr, "%s\n", SDL_GetError());
+        goto quit;
+    }
+
+    // The loaders log every file they open.
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN);
+
+    printf("image: %s (%dx%d), iterations: %d\n", argv[1], image->w, image->h, iterations);
+    printf("%-8s %12s %12s\n", "format", "load us", "blit us");
+    printf("%-8s %12.1f %12.1f\n", "BMP",  time_load(argv[1], SDL_FALSE, iterations), time_blit(image,    target, iterations));
+    printf("%-8s %12.1f %12.1f\n", "CTEX", time_load(argv[1], SDL_TRUE,  iterations), time_blit(compiled, target, iterations));
+
+    status = EXIT_SUCCESS;
+
+quit:
+    if (target)
+    {
+        SDL_FreeSurface(target);
+    }
+    if (compiled)
+    {
+        SDL_FreeSurface(compiled);
+    }
+    if (image)
+    {
+        SDL_FreeSurface(image);
+    }
+    free(blob_name);
+
+    return status;
+}